@@ -0,0 +1,311 @@
+#include "controller_session.h"
+
+#include <string.h>
+
+#include "app_config.h"
+#include "http_parameters_client.h"
+#include "parameters.h"
+
+#define MODULE_NAME "[SESSION] "
+#define DEBUG_LVL   PRINT_INFO
+
+#if CONFIG_DEBUG_MENU_BACKEND
+#define LOG( _lvl, ... ) \
+  debug_printf( DEBUG_LVL, _lvl, MODULE_NAME __VA_ARGS__ )
+#else
+#define LOG( PRINT_INFO, ... )
+#endif
+
+#define NO_FOREGROUND      -1
+#define SYNC_TIMEOUT_MS    1000
+
+typedef struct
+{
+  controller_session_t sessions[CONTROLLER_SESSION_MAX];
+  int foreground;
+  bool sync_pending;
+  bool sync_restore;
+  uint32_t sync_seq;
+} controller_session_ctx_t;
+
+static controller_session_ctx_t ctx = { .foreground = NO_FOREGROUND };
+static portMUX_TYPE session_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static int _find( const char* ap_name )
+{
+  for ( int i = 0; i < CONTROLLER_SESSION_MAX; i++ )
+  {
+    if ( ctx.sessions[i].used && strncmp( ctx.sessions[i].ap_name, ap_name, DEVICE_LIST_NAME_SIZE ) == 0 )
+    {
+      return i;
+    }
+  }
+
+  return -1;
+}
+
+static int _alloc( void )
+{
+  int oldest = -1;
+
+  for ( int i = 0; i < CONTROLLER_SESSION_MAX; i++ )
+  {
+    if ( !ctx.sessions[i].used )
+    {
+      return i;
+    }
+
+    if ( i == ctx.foreground )
+    {
+      continue;
+    }
+
+    if ( oldest < 0 || ( int32_t )( ctx.sessions[i].last_active - ctx.sessions[oldest].last_active ) < 0 )
+    {
+      oldest = i;
+    }
+  }
+
+  return oldest;
+}
+
+static void _store_values( controller_session_t* session )
+{
+  session->motor_value = parameters_getValue( PARAM_MOTOR );
+  session->servo_value = parameters_getValue( PARAM_SERVO );
+  session->vibro_on_s = parameters_getValue( PARAM_VIBRO_ON_S );
+  session->vibro_off_s = parameters_getValue( PARAM_VIBRO_OFF_S );
+}
+
+static void _restore_values( const controller_session_t* session )
+{
+  parameters_setValue( PARAM_MOTOR, session->motor_value );
+  parameters_setValue( PARAM_SERVO, session->servo_value );
+  parameters_setValue( PARAM_VIBRO_ON_S, session->vibro_on_s );
+  parameters_setValue( PARAM_VIBRO_OFF_S, session->vibro_off_s );
+}
+
+static bool _send_values( const controller_session_t* session )
+{
+  return ( HTTPParamClient_SetU32Value( PARAM_MOTOR, session->motor_value, SYNC_TIMEOUT_MS ) == ERROR_CODE_OK )
+         && ( HTTPParamClient_SetU32Value( PARAM_SERVO, session->servo_value, SYNC_TIMEOUT_MS ) == ERROR_CODE_OK )
+         && ( HTTPParamClient_SetU32Value( PARAM_VIBRO_ON_S, session->vibro_on_s, SYNC_TIMEOUT_MS ) == ERROR_CODE_OK )
+         && ( HTTPParamClient_SetU32Value( PARAM_VIBRO_OFF_S, session->vibro_off_s, SYNC_TIMEOUT_MS ) == ERROR_CODE_OK );
+}
+
+static bool _read_values( void )
+{
+  return ( HTTPParamClient_GetU32Value( PARAM_MOTOR, NULL, SYNC_TIMEOUT_MS ) == ERROR_CODE_OK )
+         && ( HTTPParamClient_GetU32Value( PARAM_SERVO, NULL, SYNC_TIMEOUT_MS ) == ERROR_CODE_OK )
+         && ( HTTPParamClient_GetU32Value( PARAM_VIBRO_ON_S, NULL, SYNC_TIMEOUT_MS ) == ERROR_CODE_OK )
+         && ( HTTPParamClient_GetU32Value( PARAM_VIBRO_OFF_S, NULL, SYNC_TIMEOUT_MS ) == ERROR_CODE_OK );
+}
+
+void controllerSessionSaveForeground( void )
+{
+  controller_session_t values = { 0 };
+
+  _store_values( &values );
+
+  portENTER_CRITICAL( &session_lock );
+  if ( ctx.foreground != NO_FOREGROUND )
+  {
+    controller_session_t* session = &ctx.sessions[ctx.foreground];
+    session->motor_value = values.motor_value;
+    session->servo_value = values.servo_value;
+    session->vibro_on_s = values.vibro_on_s;
+    session->vibro_off_s = values.vibro_off_s;
+    session->last_active = xTaskGetTickCount();
+  }
+
+  portEXIT_CRITICAL( &session_lock );
+}
+
+void controllerSessionSetForeground( const char* ap_name )
+{
+  assert( ap_name );
+
+  controller_session_t restore = { 0 };
+  bool known = false;
+  bool foreground = false;
+
+  /* Device list has own mutex, read it before taking spinlock */
+  device_list_entry_t entry;
+  int dev_idx = deviceListFind( ap_name );
+  bool seen = dev_idx >= 0 && deviceListGetEntry( dev_idx, &entry );
+  uint8_t dev_type = deviceListGetDevType( ap_name );
+
+  portENTER_CRITICAL( &session_lock );
+  int idx = _find( ap_name );
+  if ( idx >= 0 && idx == ctx.foreground )
+  {
+    ctx.sessions[idx].last_active = xTaskGetTickCount();
+    if ( seen )
+    {
+      ctx.sessions[idx].rssi = entry.rssi;
+    }
+
+    foreground = true;
+  }
+
+  portEXIT_CRITICAL( &session_lock );
+
+  if ( foreground )
+  {
+    return;
+  }
+
+  /* Keep values set on previous machine, each controller has own settings */
+  controllerSessionSaveForeground();
+
+  portENTER_CRITICAL( &session_lock );
+  idx = _find( ap_name );
+  if ( idx < 0 )
+  {
+    idx = _alloc();
+    controller_session_t* session = &ctx.sessions[idx];
+    memset( session, 0, sizeof( controller_session_t ) );
+    strncpy( session->ap_name, ap_name, DEVICE_LIST_NAME_SIZE - 1 );
+    session->used = true;
+  }
+  else
+  {
+    restore = ctx.sessions[idx];
+    known = true;
+  }
+
+  ctx.sessions[idx].dev_type = dev_type;
+  ctx.sessions[idx].last_active = xTaskGetTickCount();
+  if ( seen )
+  {
+    ctx.sessions[idx].rssi = entry.rssi;
+  }
+
+  ctx.foreground = idx;
+  ctx.sync_pending = true;
+  ctx.sync_restore = known;
+  ctx.sync_seq++;
+  portEXIT_CRITICAL( &session_lock );
+
+  if ( known )
+  {
+    _restore_values( &restore );
+  }
+
+  LOG( PRINT_INFO, "Foreground %s (%s)", ap_name, known ? "restored" : "new" );
+}
+
+bool controllerSessionIsSyncPending( void )
+{
+  portENTER_CRITICAL( &session_lock );
+  bool pending = ctx.sync_pending;
+  portEXIT_CRITICAL( &session_lock );
+  return pending;
+}
+
+bool controllerSessionSync( void )
+{
+  controller_session_t session = { 0 };
+
+  portENTER_CRITICAL( &session_lock );
+  bool pending = ctx.sync_pending && ctx.foreground != NO_FOREGROUND;
+  bool restore = ctx.sync_restore;
+  uint32_t seq = ctx.sync_seq;
+  if ( pending )
+  {
+    session = ctx.sessions[ctx.foreground];
+  }
+
+  portEXIT_CRITICAL( &session_lock );
+
+  if ( !pending )
+  {
+    return true;
+  }
+
+  /* Known machine gets its stored values back, new one keeps and reports its own */
+  bool ret = restore ? _send_values( &session ) : _read_values();
+
+  portENTER_CRITICAL( &session_lock );
+  if ( ret && seq == ctx.sync_seq )
+  {
+    ctx.sync_pending = false;
+  }
+
+  portEXIT_CRITICAL( &session_lock );
+
+  LOG( PRINT_INFO, "Sync %s (%s) %d", session.ap_name, restore ? "restore" : "read", ret );
+  return ret;
+}
+
+bool controllerSessionGetForeground( controller_session_t* session )
+{
+  bool ret = false;
+
+  assert( session );
+  portENTER_CRITICAL( &session_lock );
+  if ( ctx.foreground != NO_FOREGROUND )
+  {
+    *session = ctx.sessions[ctx.foreground];
+    ret = true;
+  }
+
+  portEXIT_CRITICAL( &session_lock );
+  return ret;
+}
+
+uint8_t controllerSessionGetCount( void )
+{
+  uint8_t count = 0;
+
+  portENTER_CRITICAL( &session_lock );
+  for ( int i = 0; i < CONTROLLER_SESSION_MAX; i++ )
+  {
+    if ( ctx.sessions[i].used )
+    {
+      count++;
+    }
+  }
+
+  portEXIT_CRITICAL( &session_lock );
+  return count;
+}
+
+bool controllerSessionGet( uint8_t idx, controller_session_t* session )
+{
+  bool ret = false;
+
+  assert( session );
+  portENTER_CRITICAL( &session_lock );
+  if ( idx < CONTROLLER_SESSION_MAX && ctx.sessions[idx].used )
+  {
+    *session = ctx.sessions[idx];
+    ret = true;
+  }
+
+  portEXIT_CRITICAL( &session_lock );
+  return ret;
+}
+
+bool controllerSessionIsKnown( const char* ap_name )
+{
+  assert( ap_name );
+  portENTER_CRITICAL( &session_lock );
+  bool known = _find( ap_name ) >= 0;
+  portEXIT_CRITICAL( &session_lock );
+  return known;
+}
+
+void controllerSessionPublishToDeviceList( void )
+{
+  controller_session_t session;
+
+  /* Known machines are listed before the first scan finish, not seen ones age out */
+  for ( uint8_t i = 0; i < CONTROLLER_SESSION_MAX; i++ )
+  {
+    if ( controllerSessionGet( i, &session ) )
+    {
+      deviceListUpdate( session.ap_name, session.rssi );
+    }
+  }
+}
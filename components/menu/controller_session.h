@@ -0,0 +1,34 @@
+#ifndef CONTROLLER_SESSION_H_
+#define CONTROLLER_SESSION_H_
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "device_list.h"
+#include "freertos/FreeRTOS.h"
+
+#define CONTROLLER_SESSION_MAX 4
+
+typedef struct
+{
+  char ap_name[DEVICE_LIST_NAME_SIZE];
+  uint8_t dev_type;
+  int8_t rssi;
+  uint32_t motor_value;
+  uint32_t servo_value;
+  uint32_t vibro_on_s;
+  uint32_t vibro_off_s;
+  TickType_t last_active;
+  bool used;
+} controller_session_t;
+
+void controllerSessionSetForeground( const char* ap_name );
+void controllerSessionSaveForeground( void );
+bool controllerSessionIsSyncPending( void );
+bool controllerSessionSync( void );
+bool controllerSessionGetForeground( controller_session_t* session );
+uint8_t controllerSessionGetCount( void );
+bool controllerSessionGet( uint8_t idx, controller_session_t* session );
+bool controllerSessionIsKnown( const char* ap_name );
+void controllerSessionPublishToDeviceList( void );
+
+#endif
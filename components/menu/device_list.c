@@ -0,0 +1,329 @@
+#include "device_list.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "app_config.h"
+#include "esp_wifi.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+#include "wifidrv.h"
+
+#define MODULE_NAME "[DEV LIST] "
+#define DEBUG_LVL   PRINT_INFO
+
+#if CONFIG_DEBUG_MENU_BACKEND
+#define LOG( _lvl, ... ) \
+  debug_printf( DEBUG_LVL, _lvl, MODULE_NAME __VA_ARGS__ )
+#else
+#define LOG( PRINT_INFO, ... )
+#endif
+
+#define SCAN_PERIOD_MS 5000
+#define SCAN_MAX_AP    64
+
+typedef struct
+{
+  const char* prefix;
+  size_t len;
+  uint8_t dev_type;
+} device_prefix_t;
+
+typedef struct
+{
+  device_list_entry_t list[DEVICE_LIST_SIZE];
+  uint16_t count;
+  SemaphoreHandle_t mutex;
+  TaskHandle_t task;
+  bool scanning;
+  bool scan_in_progress;
+  bool scan_failed;
+} device_list_ctx_t;
+
+static device_list_ctx_t ctx;
+
+static device_prefix_t prefix_table[] =
+  {
+    { .prefix = WIFI_SIEWNIK_NAME, .dev_type = T_DEV_TYPE_SIEWNIK },
+    { .prefix = WIFI_SOLARKA_NAME, .dev_type = T_DEV_TYPE_SOLARKA },
+    { .prefix = WIFI_VALVE_NAME,   .dev_type = T_DEV_TYPE_VALVE   },
+};
+
+static void _compile_prefix_table( void )
+{
+  /* Last char of the name is the serial number placeholder */
+  for ( size_t i = 0; i < sizeof( prefix_table ) / sizeof( prefix_table[0] ); i++ )
+  {
+    prefix_table[i].len = strlen( prefix_table[i].prefix ) - 1;
+  }
+}
+
+static uint8_t _match_prefix( const char* name )
+{
+  for ( size_t i = 0; i < sizeof( prefix_table ) / sizeof( prefix_table[0] ); i++ )
+  {
+    if ( memcmp( prefix_table[i].prefix, name, prefix_table[i].len ) == 0 )
+    {
+      return prefix_table[i].dev_type;
+    }
+  }
+
+  return DEVICE_LIST_UNKNOWN_DEV;
+}
+
+static int _find( const char* name )
+{
+  for ( uint16_t i = 0; i < ctx.count; i++ )
+  {
+    if ( strncmp( ctx.list[i].name, name, DEVICE_LIST_NAME_SIZE ) == 0 )
+    {
+      return i;
+    }
+  }
+
+  return -1;
+}
+
+static void _remove( uint16_t idx )
+{
+  memmove( &ctx.list[idx], &ctx.list[idx + 1], ( ctx.count - idx - 1 ) * sizeof( device_list_entry_t ) );
+  ctx.count--;
+}
+
+/* Keep list sorted by RSSI, strongest first. Only one entry is out of place after update. */
+static void _sort_entry( uint16_t idx )
+{
+  device_list_entry_t entry = ctx.list[idx];
+
+  while ( idx > 0 && ctx.list[idx - 1].rssi < entry.rssi )
+  {
+    ctx.list[idx] = ctx.list[idx - 1];
+    idx--;
+  }
+
+  while ( idx + 1 < ctx.count && ctx.list[idx + 1].rssi > entry.rssi )
+  {
+    ctx.list[idx] = ctx.list[idx + 1];
+    idx++;
+  }
+
+  ctx.list[idx] = entry;
+}
+
+static void _update( const char* name, int8_t rssi, TickType_t now )
+{
+  uint8_t dev_type = _match_prefix( name );
+
+  if ( dev_type == DEVICE_LIST_UNKNOWN_DEV )
+  {
+    return;
+  }
+
+  int idx = _find( name );
+
+  if ( idx < 0 )
+  {
+    if ( ctx.count < DEVICE_LIST_SIZE )
+    {
+      idx = ctx.count++;
+    }
+    else if ( ctx.list[DEVICE_LIST_SIZE - 1].rssi < rssi )
+    {
+      /* List full, drop the weakest device */
+      idx = DEVICE_LIST_SIZE - 1;
+    }
+    else
+    {
+      return;
+    }
+
+    strncpy( ctx.list[idx].name, name, DEVICE_LIST_NAME_SIZE - 1 );
+    ctx.list[idx].name[DEVICE_LIST_NAME_SIZE - 1] = 0;
+    ctx.list[idx].dev_type = dev_type;
+  }
+
+  ctx.list[idx].rssi = rssi;
+  ctx.list[idx].last_seen = now;
+  _sort_entry( idx );
+}
+
+static void _age_out( TickType_t now )
+{
+  uint16_t i = 0;
+
+  while ( i < ctx.count )
+  {
+    if ( now - ctx.list[i].last_seen >= MS2ST( DEVICE_LIST_AGE_OUT_MS ) )
+    {
+      LOG( PRINT_INFO, "%s aged out", ctx.list[i].name );
+      _remove( i );
+    }
+    else
+    {
+      i++;
+    }
+  }
+}
+
+static bool _scan( void )
+{
+  wifi_scan_config_t scan_config = { 0 };
+  uint16_t ap_count = 0;
+
+  if ( esp_wifi_scan_start( &scan_config, true ) != ESP_OK )
+  {
+    return false;
+  }
+
+  esp_wifi_scan_get_ap_num( &ap_count );
+  if ( ap_count > SCAN_MAX_AP )
+  {
+    ap_count = SCAN_MAX_AP;
+  }
+
+  wifi_ap_record_t* records = malloc( sizeof( wifi_ap_record_t ) * SCAN_MAX_AP );
+
+  if ( records == NULL )
+  {
+    esp_wifi_scan_get_ap_records( &ap_count, NULL );
+    return false;
+  }
+
+  if ( esp_wifi_scan_get_ap_records( &ap_count, records ) != ESP_OK )
+  {
+    free( records );
+    return false;
+  }
+
+  TickType_t now = xTaskGetTickCount();
+
+  xSemaphoreTake( ctx.mutex, portMAX_DELAY );
+  for ( uint16_t i = 0; i < ap_count; i++ )
+  {
+    _update( (const char*) records[i].ssid, records[i].rssi, now );
+  }
+
+  _age_out( now );
+  xSemaphoreGive( ctx.mutex );
+
+  LOG( PRINT_DEBUG, "Scan done: ap %d devices %d", ap_count, ctx.count );
+  free( records );
+  return true;
+}
+
+static void _scan_task( void* arg )
+{
+  while ( 1 )
+  {
+    ulTaskNotifyTake( pdTRUE, ctx.scanning ? MS2ST( SCAN_PERIOD_MS ) : portMAX_DELAY );
+
+    if ( !ctx.scanning || !wifiDrvIsReadyToScan() || wifiDrvTryingConnect() )
+    {
+      continue;
+    }
+
+    ctx.scan_in_progress = true;
+    ctx.scan_failed = !_scan();
+    ctx.scan_in_progress = false;
+  }
+}
+
+void deviceListStartScanning( void )
+{
+  ctx.scanning = true;
+  deviceListRequestScan();
+}
+
+void deviceListStopScanning( void )
+{
+  ctx.scanning = false;
+}
+
+void deviceListRequestScan( void )
+{
+  if ( ctx.task != NULL )
+  {
+    xTaskNotifyGive( ctx.task );
+  }
+}
+
+bool deviceListIsScanning( void )
+{
+  return ctx.scanning || ctx.scan_in_progress;
+}
+
+bool deviceListScanFailed( void )
+{
+  return ctx.scan_failed;
+}
+
+uint16_t deviceListGetCount( void )
+{
+  return ctx.count;
+}
+
+bool deviceListGetEntry( uint16_t idx, device_list_entry_t* entry )
+{
+  bool ret = false;
+
+  assert( entry );
+  xSemaphoreTake( ctx.mutex, portMAX_DELAY );
+  if ( idx < ctx.count )
+  {
+    *entry = ctx.list[idx];
+    ret = true;
+  }
+
+  xSemaphoreGive( ctx.mutex );
+  return ret;
+}
+
+int deviceListFind( const char* name )
+{
+  assert( name );
+  xSemaphoreTake( ctx.mutex, portMAX_DELAY );
+  int idx = _find( name );
+  xSemaphoreGive( ctx.mutex );
+  return idx;
+}
+
+uint8_t deviceListGetDevType( const char* name )
+{
+  assert( name );
+  return _match_prefix( name );
+}
+
+void deviceListUpdate( const char* name, int8_t rssi )
+{
+  assert( name );
+  xSemaphoreTake( ctx.mutex, portMAX_DELAY );
+  _update( name, rssi, xTaskGetTickCount() );
+  xSemaphoreGive( ctx.mutex );
+}
+
+void deviceListAgeOut( TickType_t now )
+{
+  xSemaphoreTake( ctx.mutex, portMAX_DELAY );
+  _age_out( now );
+  xSemaphoreGive( ctx.mutex );
+}
+
+void deviceListClear( void )
+{
+  xSemaphoreTake( ctx.mutex, portMAX_DELAY );
+  ctx.count = 0;
+  xSemaphoreGive( ctx.mutex );
+}
+
+void deviceListInit( void )
+{
+  if ( ctx.mutex != NULL )
+  {
+    return;
+  }
+
+  _compile_prefix_table();
+  ctx.mutex = xSemaphoreCreateMutex();
+  assert( ctx.mutex );
+  xTaskCreate( _scan_task, "device_scan", 4096, NULL, NORMALPRIO - 1, &ctx.task );
+}
@@ -0,0 +1,39 @@
+#ifndef DEVICE_LIST_H_
+#define DEVICE_LIST_H_
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "freertos/FreeRTOS.h"
+
+#define DEVICE_LIST_SIZE        32
+#define DEVICE_LIST_NAME_SIZE   33
+#define DEVICE_LIST_UNKNOWN_DEV 0xFF
+/* Device missing from scans for this long is removed by deviceListAgeOut() */
+#define DEVICE_LIST_AGE_OUT_MS  15000
+
+typedef struct
+{
+  char name[DEVICE_LIST_NAME_SIZE];
+  int8_t rssi;
+  uint8_t dev_type;
+  TickType_t last_seen;
+} device_list_entry_t;
+
+void deviceListInit( void );
+void deviceListStartScanning( void );
+void deviceListStopScanning( void );
+void deviceListRequestScan( void );
+bool deviceListIsScanning( void );
+bool deviceListScanFailed( void );
+
+uint16_t deviceListGetCount( void );
+bool deviceListGetEntry( uint16_t idx, device_list_entry_t* entry );
+int deviceListFind( const char* name );
+uint8_t deviceListGetDevType( const char* name );
+
+/* Used by scanner, exported to feed synthetic scan results */
+void deviceListUpdate( const char* name, int8_t rssi );
+void deviceListAgeOut( TickType_t now );
+void deviceListClear( void );
+
+#endif
@@ -1,11 +1,24 @@
 #include "dictionary.h"
 
 #include "app_config.h"
+#include "param_persist.h"
 #include "parameters.h"
+#include "text_cache.h"
+
+#define MODULE_NAME "[DICT] "
+#define DEBUG_LVL   PRINT_INFO
+
+#if CONFIG_DEBUG_MENU_BACKEND
+#define LOG( _lvl, ... ) \
+  debug_printf( DEBUG_LVL, _lvl, MODULE_NAME __VA_ARGS__ )
+#else
+#define LOG( PRINT_INFO, ... )
+#endif
 
 static menu_language_t dict_language = MENU_LANGUAGE_ENGLISH;
 
-static const char* dictionary_phrases[DICT_TOP][LANGUAGE_CNT_SUPPORT] = {
+/* Table and strings are const, both stay in flash */
+static const char* const dictionary_phrases[DICT_TOP][LANGUAGE_CNT_SUPPORT] = {
   /* Bootup */
   [DICT_LOGO_CLIENT_NAME] =
     {
@@ -385,8 +398,8 @@ static const char* dictionary_phrases[DICT_TOP][LANGUAGE_CNT_SUPPORT] = {
     {
                              "Servo not\n connected",
                              "Серво не подключен",
-                             "Serwo nie \npodłączone"
-      "Servo nicht verbunden" },
+                             "Serwo nie \npodłączone",
+                             "Servo nicht verbunden" },
   [DICT_SERVO_OVERCURRENT] =
     {
                              "                  Servo \n            overcurrent",
@@ -459,10 +472,60 @@ static const char* dictionary_phrases[DICT_TOP][LANGUAGE_CNT_SUPPORT] = {
                              "Мощность вибратора",
                              "Wydajność wibro",
                              "Vibratorleistung" },
+  [DICT_SESSION_MASS] =
+    {
+                             "Spread",
+                             "Внесено",
+                             "Wysiano",
+                             "Gestreut" },
+  [DICT_MASS_TOTAL] =
+    {
+                             "Total",
+                             "Всего",
+                             "Razem",
+                             "Gesamt" },
+  [DICT_WORK_TIME] =
+    {
+                             "Work time",
+                             "Наработка",
+                             "Czas pracy",
+                             "Betriebszeit" },
+  [DICT_SERVO_AUTO_CALIBRATION] =
+    {
+                             "Servo auto calib",
+                             "Автокалибровка",
+                             "Autokalibracja",
+                             "Autokalibrierung" },
+  [DICT_MOTOR_AUTO_CALIBRATION] =
+    {
+                             "Motor auto calib",
+                             "Калибровка мотора",
+                             "Kalibracja silnika",
+                             "Motorkalibrierung" },
 };
 
+bool dictionary_validate( void )
+{
+  bool valid = true;
+
+  for ( int phrase = 0; phrase < DICT_TOP; phrase++ )
+  {
+    for ( int lang = 0; lang < LANGUAGE_CNT_SUPPORT; lang++ )
+    {
+      if ( dictionary_phrases[phrase][lang] == NULL )
+      {
+        LOG( PRINT_ERROR, "Missing phrase %d for language %d", phrase, lang );
+        valid = false;
+      }
+    }
+  }
+
+  return valid;
+}
+
 void dictionary_init( void )
 {
+  dictionary_validate();
   dictionary_set_language( parameters_getValue( PARAM_LANGUAGE ) );
 }
 
@@ -470,19 +533,26 @@ bool dictionary_set_language( menu_language_t lang )
 {
   if ( lang < LANGUAGE_CNT_SUPPORT )
   {
-    parameters_setValue( PARAM_LANGUAGE, lang );
+    paramPersistSetValue( PARAM_LANGUAGE, lang );
     dict_language = lang;
+    textCacheInvalidate();
     return true;
   }
 
   return false;
 }
 
+menu_language_t dictionary_get_language( void )
+{
+  return dict_language;
+}
+
 const char* dictionary_get_string( enum dictionary_phrase phrase )
 {
   if ( phrase < DICT_TOP )
   {
-    return dictionary_phrases[phrase][dict_language];
+    const char* str = dictionary_phrases[phrase][dict_language];
+    return str != NULL ? str : dictionary_phrases[phrase][MENU_LANGUAGE_ENGLISH];
   }
 
   return "Bad phrase number";
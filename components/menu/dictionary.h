@@ -97,11 +97,18 @@ enum dictionary_phrase
   DICT_TIMEOUT_SERVER,
   DICT_SERIAL_NUMBER,
   DICT_VIBRO_PWM_DUTY,
+  DICT_SESSION_MASS,
+  DICT_MASS_TOTAL,
+  DICT_WORK_TIME,
+  DICT_SERVO_AUTO_CALIBRATION,
+  DICT_MOTOR_AUTO_CALIBRATION,
   DICT_TOP
 };
 
 void dictionary_init( void );
+bool dictionary_validate( void );
 bool dictionary_set_language( menu_language_t lang );
+menu_language_t dictionary_get_language( void );
 const char* dictionary_get_string( enum dictionary_phrase phrase );
 
 #endif
\ No newline at end of file
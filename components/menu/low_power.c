@@ -0,0 +1,145 @@
+#include "low_power.h"
+
+#include "app_config.h"
+#include "esp_freertos_hooks.h"
+#include "esp_pm.h"
+#include "esp_sleep.h"
+#include "esp_timer.h"
+#include "freertos/task.h"
+
+#define MODULE_NAME "[LOW PWR] "
+#define DEBUG_LVL   PRINT_INFO
+
+#if CONFIG_DEBUG_SLEEP
+#define LOG( _lvl, ... ) \
+  debug_printf( DEBUG_LVL, _lvl, MODULE_NAME __VA_ARGS__ )
+#else
+#define LOG( PRINT_INFO, ... )
+#endif
+
+typedef struct
+{
+  bool light_sleep;
+  volatile uint32_t wakeups[portNUM_PROCESSORS];
+  uint32_t last_wakeups;
+  uint32_t last_idle_time;
+  int64_t last_sample_us;
+} low_power_ctx_t;
+
+static low_power_ctx_t ctx;
+
+/* Idle task runs the hook once after each sleep, so it counts CPU wakeups */
+static bool _idle_hook( void )
+{
+  ctx.wakeups[xPortGetCoreID()]++;
+  return true;
+}
+
+static uint32_t _wakeups( void )
+{
+  uint32_t sum = 0;
+
+  for ( int core = 0; core < portNUM_PROCESSORS; core++ )
+  {
+    sum += ctx.wakeups[core];
+  }
+
+  return sum;
+}
+
+static uint32_t _idle_time( void )
+{
+  uint32_t sum = 0;
+
+#if CONFIG_FREERTOS_USE_TRACE_FACILITY && CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS
+  TaskStatus_t status;
+
+  /* Run time counter is in us when stats use esp_timer */
+  for ( int core = 0; core < portNUM_PROCESSORS; core++ )
+  {
+    vTaskGetInfo( xTaskGetIdleTaskHandleForCPU( core ), &status, pdFALSE, eReady );
+    sum += status.ulRunTimeCounter;
+  }
+#endif
+
+  return sum;
+}
+
+static void _configure_pm( void )
+{
+#if CONFIG_PM_ENABLE
+  esp_pm_config_t pm_config =
+    {
+      .max_freq_mhz = CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ,
+      .min_freq_mhz = LOW_POWER_MIN_FREQ_MHZ,
+#if CONFIG_FREERTOS_USE_TICKLESS_IDLE
+      .light_sleep_enable = true,
+#endif
+    };
+
+  esp_err_t err = esp_pm_configure( &pm_config );
+
+  ctx.light_sleep = ( err == ESP_OK ) && pm_config.light_sleep_enable;
+  LOG( PRINT_INFO, "PM configure %s, light sleep %d", esp_err_to_name( err ), ctx.light_sleep );
+#else
+  LOG( PRINT_INFO, "PM disabled in config" );
+#endif
+}
+
+void lowPowerInit( void )
+{
+  for ( int core = 0; core < portNUM_PROCESSORS; core++ )
+  {
+    esp_register_freertos_idle_hook_for_cpu( _idle_hook, core );
+  }
+
+  ctx.last_sample_us = esp_timer_get_time();
+  ctx.last_idle_time = _idle_time();
+
+  /* Wi-Fi stays in modem sleep, beacons and traffic wake CPU from light sleep */
+  _configure_pm();
+
+  if ( BUTTON_WAKEUP_PIN != GPIO_NUM_NC )
+  {
+    gpio_set_direction( BUTTON_WAKEUP_PIN, GPIO_MODE_INPUT );
+    gpio_wakeup_enable( BUTTON_WAKEUP_PIN, GPIO_INTR_LOW_LEVEL );
+    esp_sleep_enable_gpio_wakeup();
+  }
+}
+
+bool lowPowerIsLightSleepEnabled( void )
+{
+  return ctx.light_sleep;
+}
+
+void lowPowerGetStats( low_power_stats_t* stats )
+{
+  assert( stats );
+
+  int64_t now = esp_timer_get_time();
+  uint32_t idle_time = _idle_time();
+  uint32_t wakeups = _wakeups();
+  uint32_t elapsed_us = (uint32_t) ( now - ctx.last_sample_us );
+
+  /* Counters are free running, deltas are taken with unsigned wrap */
+  lowPowerCalcStats( stats, elapsed_us, idle_time - ctx.last_idle_time, wakeups - ctx.last_wakeups );
+
+  ctx.last_sample_us = now;
+  ctx.last_idle_time = idle_time;
+  ctx.last_wakeups = wakeups;
+}
+
+void lowPowerCalcStats( low_power_stats_t* stats, uint32_t elapsed_us, uint32_t idle_us, uint32_t wakeups )
+{
+  assert( stats );
+
+  stats->period_ms = elapsed_us / 1000;
+  stats->idle_percent = 0;
+  stats->wakeups_per_s = 0;
+
+  if ( elapsed_us > 0 )
+  {
+    stats->idle_percent = (uint64_t) idle_us * 100 / ( (uint64_t) elapsed_us * portNUM_PROCESSORS );
+    stats->wakeups_per_s = (uint64_t) wakeups * 1000000 / elapsed_us;
+  }
+}
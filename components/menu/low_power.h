@@ -0,0 +1,18 @@
+#ifndef LOW_POWER_H_
+#define LOW_POWER_H_
+#include <stdbool.h>
+#include <stdint.h>
+
+typedef struct
+{
+  uint32_t idle_percent;
+  uint32_t wakeups_per_s;
+  uint32_t period_ms;
+} low_power_stats_t;
+
+void lowPowerInit( void );
+bool lowPowerIsLightSleepEnabled( void );
+void lowPowerGetStats( low_power_stats_t* stats );
+void lowPowerCalcStats( low_power_stats_t* stats, uint32_t elapsed_us, uint32_t idle_us, uint32_t wakeups );
+
+#endif
@@ -3,11 +3,16 @@
 #include "app_config.h"
 #include "but.h"
 #include "cmd_client.h"
+#include "controller_session.h"
 #include "dictionary.h"
 #include "freertos/semphr.h"
 #include "http_parameters_client.h"
+#include "low_power.h"
 #include "menu_drv.h"
+#include "panel_power.h"
+#include "param_cache.h"
 #include "parameters.h"
+#include "soc_estimator.h"
 #include "ssdFigure.h"
 #include "start_menu.h"
 #include "stdarg.h"
@@ -24,6 +29,9 @@
 #define LOG( PRINT_INFO, ... )
 #endif
 
+#define PANEL_BATTERY_CAPACITY_MAH 2000
+#define SESSION_SYNC_RETRY_MS      500
+
 typedef enum
 {
   STATE_INIT,
@@ -52,6 +60,10 @@ typedef struct
 
   bool send_all_data;
   struct menu_data sended_data;
+  TaskHandle_t task;
+
+  soc_estimator_t battery_soc;
+  TickType_t battery_soc_timer;
 } menu_start_context_t;
 
 static menu_start_context_t ctx;
@@ -135,16 +147,29 @@ static void backend_idle( void )
   if ( ctx.menu_start_is_active )
   {
     ctx.send_all_data = true;
+    paramCacheInvalidate();
     change_state( STATE_START );
     return;
   }
 
-  osDelay( 50 );
+  /* Nothing to do until a menu is entered or session sync is retried, let the CPU sleep */
+  low_power_stats_t stats;
+  lowPowerGetStats( &stats );
+  ulTaskNotifyTake( pdTRUE, controllerSessionIsSyncPending() ? MS2ST( SESSION_SYNC_RETRY_MS ) : portMAX_DELAY );
+  lowPowerGetStats( &stats );
+  LOG( PRINT_INFO, "Idle %ld ms: idle %ld%%, wakeups %ld/s", stats.period_ms, stats.idle_percent, stats.wakeups_per_s );
+}
+
+static void _wakeup( void )
+{
+  if ( ctx.task != NULL )
+  {
+    xTaskNotifyGive( ctx.task );
+  }
 }
 
 static bool _check_error( void )
 {
-  HTTPParamClient_GetU32Value( PARAM_MACHINE_ERRORS, NULL, 2000 );
   uint32_t errors = parameters_getValue( PARAM_MACHINE_ERRORS );
 
   if ( errors > 0 )
@@ -169,8 +194,7 @@ static void backend_send_control_data( void )
 
   if ( ctx.send_all_data )
   {
-    bool result = HTTPParamClient_GetStrValue( PARAM_STR_CONTROLLER_SN, NULL, 0, 2000 ) == ERROR_CODE_OK;
-    result &= HTTPParamClient_SetU32Value( PARAM_VIBRO_DUTY_PWM, parameters_getValue( PARAM_VIBRO_DUTY_PWM ), 2000 );
+    bool result = HTTPParamClient_SetU32Value( PARAM_VIBRO_DUTY_PWM, parameters_getValue( PARAM_VIBRO_DUTY_PWM ), 2000 );
     result &= HTTPParamClient_SetU32Value( PARAM_MOTOR, data->motor_value, 1000 ) == ERROR_CODE_OK;
     result &= HTTPParamClient_SetU32Value( PARAM_SERVO, data->servo_value, 1000 ) == ERROR_CODE_OK;
 #if MENU_VIRO_ON_OFF_VERSION
@@ -245,6 +269,8 @@ static void backend_send_control_data( void )
 
 static void backend_start( void )
 {
+  paramCacheRefresh();
+
   if ( ctx.get_data_cnt % 5 == 0 )
   {
     bool errors = _check_error() > 0;
@@ -258,11 +284,6 @@ static void backend_start( void )
       LOG( PRINT_DEBUG, "No error" );
     }
 
-    HTTPParamClient_GetU32Value( PARAM_CURRENT_MOTOR, NULL, 2000 );
-    HTTPParamClient_GetU32Value( PARAM_VOLTAGE_ACCUM, NULL, 2000 );
-    HTTPParamClient_GetU32Value( PARAM_LOW_LEVEL_SILOS, NULL, 2000 );
-    HTTPParamClient_GetU32Value( PARAM_SILOS_LEVEL, NULL, 2000 );
-    HTTPParamClient_GetU32Value( PARAM_SILOS_SENSOR_IS_CONNECTED, NULL, 2000 );
     LOG( PRINT_DEBUG, "Get silos %d ", parameters_getValue( PARAM_LOW_LEVEL_SILOS ) );
   }
 
@@ -304,10 +325,7 @@ static void backend_menu_parameters( void )
     return;
   }
 
-  HTTPParamClient_GetU32Value( PARAM_TEMPERATURE, NULL, 2000 );
-  HTTPParamClient_GetU32Value( PARAM_VOLTAGE_ACCUM, NULL, 2000 );
-  HTTPParamClient_GetU32Value( PARAM_CURRENT_MOTOR, NULL, 2000 );
-  HTTPParamClient_GetU32Value( PARAM_SILOS_LEVEL, NULL, 2000 );
+  paramCacheRefresh();
   osDelay( 50 );
 }
 
@@ -371,21 +389,27 @@ static void backend_emergency_disable_exit( void )
 
 void backendEnterMenuParameters( void )
 {
+  paramCacheEnterView( PARAM_CACHE_VIEW_PARAMETERS );
   ctx.menu_param_is_active = true;
+  _wakeup();
 }
 
 void backendExitMenuParameters( void )
 {
+  paramCacheExitView( PARAM_CACHE_VIEW_PARAMETERS );
   ctx.menu_param_is_active = false;
 }
 
 void backendEnterMenuStart( void )
 {
+  paramCacheEnterView( PARAM_CACHE_VIEW_START );
   ctx.menu_start_is_active = true;
+  _wakeup();
 }
 
 void backendExitMenuStart( void )
 {
+  paramCacheExitView( PARAM_CACHE_VIEW_START );
   ctx.menu_start_is_active = false;
 }
 
@@ -400,15 +424,30 @@ void backendToggleEmergencyDisable( void )
     if ( wifiDrvIsConnected() )
     {
       ctx.emergensy_req = true;
+      _wakeup();
     }
   }
 }
 
+static void _sync_session( void )
+{
+  if ( controllerSessionIsSyncPending() && wifiDrvIsConnected() )
+  {
+    controllerSessionSync();
+  }
+}
+
+void backendSyncSession( void )
+{
+  _wakeup();
+}
+
 static void menu_task( void* arg )
 {
   while ( 1 )
   {
     _check_emergency_disable();
+    _sync_session();
 
     switch ( ctx.state )
     {
@@ -451,12 +490,24 @@ static void menu_task( void* arg )
   }
 }
 
+static void _draw_battery( uint8_t x, uint8_t y, float accum_voltage, bool is_charging )
+{
+  TickType_t now = xTaskGetTickCount();
+
+  socEstimatorUpdate( &ctx.battery_soc, (uint32_t) ( accum_voltage * 1000 ), 0, ST2MS( now - ctx.battery_soc_timer ) );
+  ctx.battery_soc_timer = now;
+
+  panelPowerProcess( accum_voltage, is_charging );
+  drawBattery( x, y, accum_voltage, socEstimatorGetSoc( &ctx.battery_soc ), is_charging );
+}
+
 void menuBackendInit( void )
 {
+  socEstimatorInit( &ctx.battery_soc, &soc_config_panel, PANEL_BATTERY_CAPACITY_MAH );
   menuDrvSetGetMsgCb( _get_msg );
-  menuDrvSetDrawBatteryCb( drawBattery );
+  menuDrvSetDrawBatteryCb( _draw_battery );
   menuDrvSetDrawSignalCb( drawSignal );
-  xTaskCreate( menu_task, "menu_back", 4096, NULL, 5, NULL );
+  xTaskCreate( menu_task, "menu_back", MENU_BACKEND_TASK_STACK, NULL, MENU_BACKEND_TASK_PRIO, &ctx.task );
 }
 
 bool backendIsConnected( void )
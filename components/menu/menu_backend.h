@@ -10,4 +10,5 @@ void backendEnterMenuStart( void );
 void backendExitMenuStart( void );
 bool backendIsConnected( void );
 bool backendIsEmergencyDisable( void );
+void backendSyncSession( void );
 #endif
\ No newline at end of file
@@ -1,6 +1,8 @@
 #include "app_config.h"
 #include "but.h"
 #include "cmd_client.h"
+#include "boot_trace.h"
+#include "deadline.h"
 #include "dictionary.h"
 #include "freertos/semphr.h"
 #include "http_parameters_client.h"
@@ -45,7 +47,7 @@ typedef struct
   bool error_flag;
   const char* error_msg;
   char ap_name[33];
-  uint32_t timeout_con;
+  deadline_t timeout_con;
   bool system_connected;
   bool exit_req;
   char buff[128];
@@ -91,42 +93,49 @@ static void change_state( state_bootup_t new_state )
   }
 }
 
-static void bootup_init_state( void )
+static void bootup_connect( void )
 {
-  menuPrintfInfo( dictionary_get_string( DICT_INIT ) );
-  change_state( STATE_WAIT_WIFI_INIT );
+  wifiDrvGetAPName( ctx.ap_name );
+  menuPrintfInfo( "%s %s", dictionary_get_string( DICT_TRY_CONNECT_TO_S ), ctx.ap_name );
+  wifiDrvConnect();
+  bootTraceMark( "connect", BOOT_TRACE_NO_BUDGET );
+  change_state( STATE_WAIT_CONNECT );
 }
 
-static void bootup_wifi_wait( void )
+static void bootup_check_memory( void )
 {
-  if ( wifiDrvReadyToConnect() )
+  /* AP stored by Wi-Fi driver, connect in the same frame */
+  if ( wifiDrvIsReadData() )
   {
-    change_state( STATE_CHECK_MEMORY );
+    change_state( STATE_CONNECT );
+    bootup_connect();
   }
   else
   {
-    menuPrintfInfo( dictionary_get_string( DICT_WAIT_TO_START_WIFI ) );
+    change_state( STATE_EXIT );
   }
 }
 
-static void bootup_check_memory( void )
+static void bootup_wifi_wait( void )
 {
-  if ( wifiDrvIsReadData() )
+  if ( wifiDrvReadyToConnect() )
   {
-    change_state( STATE_CONNECT );
+    bootTraceMark( "wifi ready", BOOT_TRACE_NO_BUDGET );
+    change_state( STATE_CHECK_MEMORY );
+    bootup_check_memory();
   }
   else
   {
-    change_state( STATE_EXIT );
+    menuPrintfInfo( dictionary_get_string( DICT_WAIT_TO_START_WIFI ) );
   }
 }
 
-static void bootup_connect( void )
+static void bootup_init_state( void )
 {
-  wifiDrvGetAPName( ctx.ap_name );
-  menuPrintfInfo( "%s %s", dictionary_get_string( DICT_TRY_CONNECT_TO_S ), ctx.ap_name );
-  wifiDrvConnect();
-  change_state( STATE_WAIT_CONNECT );
+  bootTraceMark( "bootup menu", BOOT_TRACE_NO_BUDGET );
+  menuPrintfInfo( dictionary_get_string( DICT_INIT ) );
+  change_state( STATE_WAIT_WIFI_INIT );
+  bootup_wifi_wait();
 }
 
 static void _show_wait_connection( void )
@@ -141,10 +150,10 @@ static void _show_wait_connection( void )
 static void bootup_wait_connect( void )
 {
   /* Wait to connect wifi */
-  ctx.timeout_con = MS2ST( 5000 ) + xTaskGetTickCount();
+  deadlineArm( &ctx.timeout_con, 5000 );
   do
   {
-    if ( ctx.timeout_con < xTaskGetTickCount() || ctx.exit_req )
+    if ( deadlineExpired( &ctx.timeout_con ) || ctx.exit_req )
     {
       ctx.error_msg = dictionary_get_string( DICT_TIMEOUT_CONNECT );
       ctx.error_flag = 1;
@@ -156,10 +165,10 @@ static void bootup_wait_connect( void )
     osDelay( 50 );
   } while ( wifiDrvTryingConnect() );
 
-  ctx.timeout_con = MS2ST( 5000 ) + xTaskGetTickCount();
+  deadlineArm( &ctx.timeout_con, 5000 );
   do
   {
-    if ( ctx.timeout_con < xTaskGetTickCount() || ctx.exit_req )
+    if ( deadlineExpired( &ctx.timeout_con ) || ctx.exit_req )
     {
       ctx.error_msg = dictionary_get_string( DICT_TIMEOUT_SERVER );
       ctx.error_flag = 1;
@@ -171,11 +180,32 @@ static void bootup_wait_connect( void )
     osDelay( 50 );
   } while ( !backendIsConnected() );
 
+  bootTraceMark( "connected", 1500 );
   oled_clearScreen();
   menuPrintfInfo( dictionary_get_string( DICT_CONNECTED_TRY_READ_DATA ) );
   change_state( STATE_GET_SERVER_DATA );
 }
 
+static void bootup_exit( void )
+{
+  mainMenuInit( MENU_DRV_NORMAL_INIT );
+  if ( ctx.system_connected )
+  {
+    enterMenuStart();
+    bootTraceMark( "operational", 100 );
+    bootTraceDump();
+  }
+}
+
+/* Start menu is shown as soon as controller answered, no extra frame */
+static void bootup_checking_data( void )
+{
+  ctx.system_connected = true;
+  menuPrintfInfo( dictionary_get_string( DICT_SYSTEM_READY_TO_START ) );
+  change_state( STATE_EXIT );
+  bootup_exit();
+}
+
 static void bootup_get_server_data( void )
 {
   uint32_t time_to_connect = 0;
@@ -195,24 +225,10 @@ static void bootup_get_server_data( void )
     }
   }
 
+  bootTraceMark( "first data", 300 );
   menuPrintfInfo( dictionary_get_string( DICT_READ_DATA_FROM_S ), ctx.ap_name );
   change_state( STATE_CHECKING_DATA );
-}
-
-static void bootup_checking_data( void )
-{
-  ctx.system_connected = true;
-  change_state( STATE_EXIT );
-  menuPrintfInfo( dictionary_get_string( DICT_SYSTEM_READY_TO_START ) );
-}
-
-static void bootup_exit( void )
-{
-  mainMenuInit( MENU_DRV_NORMAL_INIT );
-  if ( ctx.system_connected )
-  {
-    enterMenuStart();
-  }
+  bootup_checking_data();
 }
 
 static bool menu_process( void* arg )
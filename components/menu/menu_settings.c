@@ -9,6 +9,7 @@
 #include "menu_backend.h"
 #include "menu_default.h"
 #include "menu_drv.h"
+#include "param_persist.h"
 #include "parameters.h"
 #include "ssd1306.h"
 #include "ssdFigure.h"
@@ -45,8 +46,10 @@ typedef enum
   SETTINGS_SERVO_ERROR,
   SETTINGS_VIBRO_ERROR,
   SETTINGS_MOTOR_ERROR_CALIBRATION,
+  SETTINGS_MOTOR_AUTO_CALIBRATION,
   SETTINGS_SERVO_CLOSE_CALIBRATION,
   SETTINGS_SERVO_OPEN_CALIBRATION,
+  SETTINGS_SERVO_AUTO_CALIBRATION,
   SETTINGS_SILOS_HEIGHT,
   SETTINGS_VIBRO_PWM_DUTY,
   SETTINGS_TOP,
@@ -93,6 +96,9 @@ static void enter_servo_open_calibration( void );
 static void exit_servo_open_calibration( void );
 static void fast_add_open_servo_cb( uint32_t value );
 static void fast_add_close_servo_cb( uint32_t value );
+static void get_servo_auto_calibration( uint32_t* value );
+static void get_max_servo_auto_calibration( uint32_t* value );
+static void set_servo_auto_calibration( uint32_t value );
 
 static void get_silos_height( uint32_t* value );
 static void set_silos_height( uint32_t value );
@@ -136,6 +142,10 @@ static void set_motor_error_calibration( uint32_t value );
 static void get_max_motor_error_calibration( uint32_t* value );
 static void exit_motor_error_calibration( void );
 
+static void get_motor_auto_calibration( uint32_t* value );
+static void get_max_motor_auto_calibration( uint32_t* value );
+static void set_motor_auto_calibration( uint32_t value );
+
 static void get_brightness( uint32_t* value );
 static void set_brightness( uint32_t value );
 static void get_max_brightness( uint32_t* value );
@@ -232,6 +242,13 @@ static parameters_t parameters_list_siewnik[] =
      .get_max_value = get_max_motor_error_calibration,
      .exit = exit_motor_error_calibration },
 
+    { .param_type = SETTINGS_MOTOR_AUTO_CALIBRATION,
+     .name_dict = DICT_MOTOR_AUTO_CALIBRATION,
+     .unit_type = UNIT_ON_OFF,
+     .get_value = get_motor_auto_calibration,
+     .set_value = set_motor_auto_calibration,
+     .get_max_value = get_max_motor_auto_calibration },
+
     { .param_type = SETTINGS_SERVO_CLOSE_CALIBRATION,
      .name_dict = DICT_SERVO_CLOSE,
      .unit_type = UNIT_INT,
@@ -252,6 +269,13 @@ static parameters_t parameters_list_siewnik[] =
      .exit = exit_servo_open_calibration,
      .fast_add = fast_add_open_servo_cb },
 
+    { .param_type = SETTINGS_SERVO_AUTO_CALIBRATION,
+     .name_dict = DICT_SERVO_AUTO_CALIBRATION,
+     .unit_type = UNIT_ON_OFF,
+     .get_value = get_servo_auto_calibration,
+     .set_value = set_servo_auto_calibration,
+     .get_max_value = get_max_servo_auto_calibration },
+
     { .param_type = SETTINGS_SILOS_HEIGHT,
      .name_dict = DICT_SILOS_HEIGHT,
      .unit_type = UNIT_INT,
@@ -351,6 +375,13 @@ static parameters_t parameters_list_solarka[] =
      .get_max_value = get_max_motor_error_calibration,
      .exit = exit_motor_error_calibration },
 
+    { .param_type = SETTINGS_MOTOR_AUTO_CALIBRATION,
+     .name_dict = DICT_MOTOR_AUTO_CALIBRATION,
+     .unit_type = UNIT_ON_OFF,
+     .get_value = get_motor_auto_calibration,
+     .set_value = set_motor_auto_calibration,
+     .get_max_value = get_max_motor_auto_calibration },
+
     { .param_type = SETTINGS_SILOS_HEIGHT,
      .name_dict = DICT_SILOS_HEIGHT,
      .unit_type = UNIT_INT,
@@ -412,6 +443,40 @@ static void fast_add_close_servo_cb( uint32_t value )
   HTTPParamClient_SetU32ValueDontWait( PARAM_CLOSE_SERVO_REGULATION, value );
 }
 
+static void get_motor_auto_calibration( uint32_t* value )
+{
+  *value = parameters_getValue( PARAM_MOTOR_AUTO_CALIBRATION );
+}
+
+static void get_max_motor_auto_calibration( uint32_t* value )
+{
+  *value = parameters_getMaxValue( PARAM_MOTOR_AUTO_CALIBRATION );
+}
+
+static void set_motor_auto_calibration( uint32_t value )
+{
+  LOG( PRINT_DEBUG, "%s: %d", __func__, value );
+  paramPersistSetValue( PARAM_MOTOR_AUTO_CALIBRATION, value );
+  HTTPParamClient_SetU32ValueDontWait( PARAM_MOTOR_AUTO_CALIBRATION, value );
+}
+
+static void get_servo_auto_calibration( uint32_t* value )
+{
+  *value = parameters_getValue( PARAM_SERVO_AUTO_CALIBRATION );
+}
+
+static void get_max_servo_auto_calibration( uint32_t* value )
+{
+  *value = parameters_getMaxValue( PARAM_SERVO_AUTO_CALIBRATION );
+}
+
+static void set_servo_auto_calibration( uint32_t value )
+{
+  LOG( PRINT_DEBUG, "%s: %d", __func__, value );
+  paramPersistSetValue( PARAM_SERVO_AUTO_CALIBRATION, value );
+  HTTPParamClient_SetU32ValueDontWait( PARAM_SERVO_AUTO_CALIBRATION, value );
+}
+
 static void get_silos_height( uint32_t* value )
 {
   *value = parameters_getValue( PARAM_SILOS_HEIGHT );
@@ -469,7 +534,7 @@ static void get_max_motor_error( uint32_t* value )
 
 static void set_motor_error( uint32_t value )
 {
-  parameters_setValue( PARAM_ERROR_MOTOR, value );
+  paramPersistSetValue( PARAM_ERROR_MOTOR, value );
 }
 
 static void exit_motor_error( void )
@@ -490,7 +555,7 @@ static void get_max_servo_error( uint32_t* value )
 
 static void set_servo_error( uint32_t value )
 {
-  parameters_setValue( PARAM_ERROR_SERVO, value );
+  paramPersistSetValue( PARAM_ERROR_SERVO, value );
 }
 
 static void exit_servo_error( void )
@@ -517,7 +582,7 @@ static void get_min_period( uint32_t* value )
 
 static void set_period( uint32_t value )
 {
-  parameters_setValue( PARAM_PERIOD, value );
+  paramPersistSetValue( PARAM_PERIOD, value );
 }
 
 static void exit_period( void )
@@ -533,7 +598,7 @@ static void get_motor_error_calibration( uint32_t* value )
 
 static void set_motor_error_calibration( uint32_t value )
 {
-  parameters_setValue( PARAM_ERROR_MOTOR_CALIBRATION, value );
+  paramPersistSetValue( PARAM_ERROR_MOTOR_CALIBRATION, value );
 }
 
 static void get_max_motor_error_calibration( uint32_t* value )
@@ -565,7 +630,7 @@ static void get_min_power_on_min( uint32_t* value )
 
 static void set_power_on_min( uint32_t value )
 {
-  parameters_setValue( PARAM_POWER_ON_MIN, value );
+  paramPersistSetValue( PARAM_POWER_ON_MIN, value );
 }
 
 static void get_language( uint32_t* value )
@@ -580,7 +645,10 @@ static void get_max_language( uint32_t* value )
 
 static void set_language( uint32_t value )
 {
-  dictionary_set_language( value );
+  if ( dictionary_set_language( value ) )
+  {
+    paramPersistMarkDirty( PARAM_LANGUAGE );
+  }
 }
 
 static void get_bootup( uint32_t* value )
@@ -605,12 +673,12 @@ static void get_max_buzzer( uint32_t* value )
 
 static void set_bootup( uint32_t value )
 {
-  parameters_setValue( PARAM_BOOT_UP_SYSTEM, value );
+  paramPersistSetValue( PARAM_BOOT_UP_SYSTEM, value );
 }
 
 static void set_buzzer( uint32_t value )
 {
-  parameters_setValue( PARAM_BUZZER, value );
+  paramPersistSetValue( PARAM_BUZZER, value );
 }
 
 static void get_brightness( uint32_t* value )
@@ -620,7 +688,7 @@ static void get_brightness( uint32_t* value )
 
 static void set_brightness( uint32_t value )
 {
-  parameters_setValue( PARAM_BRIGHTNESS, value );
+  paramPersistSetValue( PARAM_BRIGHTNESS, value );
   MOTOR_LED_SET_RED( 1 );
   SERVO_VIBRO_LED_SET_GREEN( 1 );
 }
@@ -654,7 +722,7 @@ static void get_vibro_duty_pwm( uint32_t* value )
 
 static void set_vibro_duty_pwm( uint32_t value )
 {
-  parameters_setValue( PARAM_VIBRO_DUTY_PWM, value );
+  paramPersistSetValue( PARAM_VIBRO_DUTY_PWM, value );
 }
 
 static void get_max_vibro_duty_pwm( uint32_t* value )
@@ -922,7 +990,6 @@ static void menu_button_exit_callback( void* arg )
     return;
   }
 
-  parameters_save();
   if ( _state == MENU_EDIT_PARAMETERS )
   {
     _set_and_exit( menu );
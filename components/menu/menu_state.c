@@ -4,9 +4,11 @@
 #include "menu_backend.h"
 #include "menu_default.h"
 #include "menu_drv.h"
+#include "param_cache.h"
 #include "parameters.h"
 #include "ssd1306.h"
 #include "ssdFigure.h"
+#include "widget.h"
 #include "wifi_menu.h"
 #include "wifidrv.h"
 
@@ -28,6 +30,9 @@ typedef enum
   PARAM_TEMPERATURE_IN,
   PARAM_CONNECTION,
   PARAM_SIGNAL,
+  PARAM_SESSION_MASS_IN,
+  PARAM_MASS_TOTAL_IN,
+  PARAM_WORK_TIME_IN,
   PARAM_SN,
   PARAM_TOP
 
@@ -49,6 +54,8 @@ typedef struct
   uint32_t value;
   char* value_str;
   unit_type_t unit_type;
+  bool cached;
+  uint32_t cache_param;
   void ( *get_value )( uint32_t* value );
   void ( *get_str )( char** value );
 } parameters_t;
@@ -59,22 +66,63 @@ static void get_silos( uint32_t* value );
 static void get_signal( uint32_t* value );
 static void get_temp( uint32_t* value );
 static void get_connection( uint32_t* value );
+static void get_session_mass( uint32_t* value );
+static void get_mass_total( uint32_t* value );
+static void get_work_time( uint32_t* value );
 static void get_sn( char** value );
 
 static parameters_t parameters_list[] =
   {
-    [PARAM_CURRENT] = {.name_dict = DICT_CURRENT,        .unit = "A",    .unit_type = UNIT_DOUBLE, .get_value = get_current   },
-    [PARAM_VOLTAGE] = { .name_dict = DICT_VOLTAGE,       .unit = "V",    .unit_type = UNIT_DOUBLE, .get_value = get_voltage   },
-    [PARAM_SILOS] = { .name_dict = DICT_SILOS,         .unit = "dm 3", .unit_type = UNIT_INT,    .get_value = get_silos     },
-    [PARAM_SIGNAL] = { .name_dict = DICT_SIGNAL,        .unit = "",     .unit_type = UNIT_INT,    .get_value = get_signal    },
-    [PARAM_TEMPERATURE_IN] = { .name_dict = DICT_TEMP,          .unit = "\"C",  .unit_type = UNIT_INT,    .get_value = get_temp      },
-    [PARAM_CONNECTION] = { .name_dict = DICT_CONNECT,       .unit = "",     .unit_type = UNIT_BOOL,   .get_value = get_connection},
-    [PARAM_SN] = { .name_dict = DICT_SERIAL_NUMBER, .unit = "",     .unit_type = UNIT_STR,    .get_str = get_sn          },
+    [PARAM_CURRENT] = {.name_dict = DICT_CURRENT,        .unit = "A",    .unit_type = UNIT_DOUBLE, .get_value = get_current,    .cached = true, .cache_param = PARAM_CURRENT_MOTOR    },
+    [PARAM_VOLTAGE] = { .name_dict = DICT_VOLTAGE,       .unit = "V",    .unit_type = UNIT_DOUBLE, .get_value = get_voltage,    .cached = true, .cache_param = PARAM_VOLTAGE_ACCUM    },
+    [PARAM_SILOS] = { .name_dict = DICT_SILOS,         .unit = "dm 3", .unit_type = UNIT_INT,    .get_value = get_silos,      .cached = true, .cache_param = PARAM_SILOS_LEVEL      },
+    [PARAM_SIGNAL] = { .name_dict = DICT_SIGNAL,        .unit = "",     .unit_type = UNIT_INT,    .get_value = get_signal                                                          },
+    [PARAM_TEMPERATURE_IN] = { .name_dict = DICT_TEMP,          .unit = "\"C",  .unit_type = UNIT_INT,    .get_value = get_temp,       .cached = true, .cache_param = PARAM_TEMPERATURE      },
+    [PARAM_CONNECTION] = { .name_dict = DICT_CONNECT,       .unit = "",     .unit_type = UNIT_BOOL,   .get_value = get_connection                                                      },
+    [PARAM_SESSION_MASS_IN] = { .name_dict = DICT_SESSION_MASS,  .unit = "kg",   .unit_type = UNIT_DOUBLE, .get_value = get_session_mass, .cached = true, .cache_param = PARAM_SESSION_MASS   },
+    [PARAM_MASS_TOTAL_IN] = { .name_dict = DICT_MASS_TOTAL,    .unit = "kg",   .unit_type = UNIT_INT,    .get_value = get_mass_total, .cached = true, .cache_param = PARAM_MASS_TOTAL       },
+    [PARAM_WORK_TIME_IN] = { .name_dict = DICT_WORK_TIME,     .unit = "h",    .unit_type = UNIT_DOUBLE, .get_value = get_work_time,  .cached = true, .cache_param = PARAM_WORK_TIME        },
+    [PARAM_SN] = { .name_dict = DICT_SERIAL_NUMBER, .unit = "",     .unit_type = UNIT_STR,    .get_str = get_sn,           .cached = true, .cache_param = PARAM_STR_CONTROLLER_SN},
 };
 
-static scrollBar_t scrollBar = {
-  .line_max = MAX_LINE,
-  .y_start = MENU_HEIGHT };
+static uint32_t _row_key( uint16_t row );
+static void _row_format( uint16_t row, char* buff, size_t size );
+
+static widget_t title_widget =
+  {
+    .type = WIDGET_LABEL,
+    .width = SSD1306_WIDTH,
+    .height = MENU_HEIGHT,
+    .label.font = OLED_FONT_SIZE_16,
+};
+
+static widget_t list_widget =
+  {
+    .type = WIDGET_LIST,
+    .y = MENU_HEIGHT,
+    .width = SSD1306_WIDTH,
+    .height = SSD1306_HEIGHT - MENU_HEIGHT,
+    .list = {
+             .line_height = LINE_HEIGHT,
+             .font = OLED_FONT_SIZE_11,
+             .row_key = _row_key,
+             .row_format = _row_format,
+             .scroll_bar.line_max = MAX_LINE,
+             },
+};
+
+static widget_t* widgets[] = { &title_widget, &list_widget };
+
+static widget_screen_t screen =
+  {
+    .widgets = widgets,
+    .count = sizeof( widgets ) / sizeof( widgets[0] ),
+};
+
+static const widget_rect_t header_band = { .width = SSD1306_WIDTH, .height = MENU_HEIGHT };
+static const widget_rect_t emergency_overlay = { .width = SSD1306_WIDTH, .height = SSD1306_HEIGHT };
+
+static bool last_connected;
 
 static void get_current( uint32_t* value )
 {
@@ -113,6 +161,23 @@ static void get_connection( uint32_t* value )
   *value = backendIsConnected();
 }
 
+/* Session mass is in 10 g, shown in kg */
+static void get_session_mass( uint32_t* value )
+{
+  *value = parameters_getValue( PARAM_SESSION_MASS );
+}
+
+static void get_mass_total( uint32_t* value )
+{
+  *value = parameters_getValue( PARAM_MASS_TOTAL );
+}
+
+/* Work time is in minutes, shown in hours */
+static void get_work_time( uint32_t* value )
+{
+  *value = parameters_getValue( PARAM_WORK_TIME ) * 100 / 60;
+}
+
 static void get_sn( char** value )
 {
   static char serial_number[32] = { 0 };
@@ -120,6 +185,57 @@ static void get_sn( char** value )
   *value = serial_number;
 }
 
+static const char* _stale_marker( parameters_t* param )
+{
+  if ( !param->cached )
+  {
+    return "";
+  }
+
+  bool stale = param->unit_type == UNIT_STR ? paramCacheIsStrStale( param->cache_param ) : paramCacheIsStale( param->cache_param );
+  return stale ? " ?" : "";
+}
+
+static uint32_t _row_key( uint16_t row )
+{
+  parameters_t* param = &parameters_list[row];
+  uint32_t key = 0;
+
+  if ( param->unit_type == UNIT_STR && param->get_str != NULL )
+  {
+    param->get_str( &param->value_str );
+    for ( const char* c = param->value_str; c != NULL && *c != 0; c++ )
+    {
+      key = key * 31 + *c;
+    }
+  }
+  else if ( param->get_value != NULL )
+  {
+    param->get_value( &param->value );
+    key = param->value;
+  }
+
+  return _stale_marker( param )[0] != 0 ? ~key : key;
+}
+
+static void _row_format( uint16_t row, char* buff, size_t size )
+{
+  parameters_t* param = &parameters_list[row];
+
+  if ( param->unit_type == UNIT_DOUBLE )
+  {
+    snprintf( buff, size, "%s:      %.2f %s%s", dictionary_get_string( param->name_dict ), (float) param->value / 100.0, param->unit, _stale_marker( param ) );
+  }
+  else if ( param->unit_type == UNIT_STR && param->value_str != NULL )
+  {
+    snprintf( buff, size, "%s:      %s%s", dictionary_get_string( param->name_dict ), param->value_str, _stale_marker( param ) );
+  }
+  else
+  {
+    snprintf( buff, size, "%s:      %ld %s%s", dictionary_get_string( param->name_dict ), param->value, param->unit, _stale_marker( param ) );
+  }
+}
+
 static void menu_button_up_callback( void* arg )
 {
   menu_token_t* menu = arg;
@@ -194,6 +310,9 @@ static bool menu_enter_cb( void* arg )
     return false;
   }
   backendEnterMenuParameters();
+  oled_clearScreen();
+  widgetScreenInvalidate( &screen );
+  last_connected = false;
   return true;
 }
 
@@ -206,6 +325,10 @@ static bool menu_exit_cb( void* arg )
     return false;
   }
   backendExitMenuParameters();
+
+  widget_stats_t stats;
+  widgetScreenGetStats( &screen, &stats );
+  LOG( PRINT_INFO, "Render frames %ld redraws %ld max %ld us", stats.frames, stats.redraws, stats.max_render_us );
   return true;
 }
 
@@ -217,20 +340,6 @@ static bool _disconnected_process( menu_token_t* menu )
 
 static bool _connected_process( menu_token_t* menu )
 {
-  static char buff[64];
-
-  for ( int i = 0; i < PARAM_TOP; i++ )
-  {
-    if ( parameters_list[i].unit_type == UNIT_STR && parameters_list[i].get_str != NULL )
-    {
-      parameters_list[i].get_str( &parameters_list[i].value_str );
-    }
-    else if ( parameters_list[i].get_value != NULL )
-    {
-      parameters_list[i].get_value( &parameters_list[i].value );
-    }
-  }
-
   if ( menu->line.end - menu->line.start != MAX_LINE - 1 )
   {
     menu->line.start = menu->position;
@@ -252,38 +361,7 @@ static bool _connected_process( menu_token_t* menu )
     LOG( PRINT_INFO, "menu->line.start %d, menu->line.end %d, position %d, menu->last_button %d\n", menu->line.start, menu->line.end, menu->position, menu->last_button );
   }
 
-  int line = 0;
-  do
-  {
-    int pos = line + menu->line.start;
-
-    if ( parameters_list[pos].unit_type == UNIT_DOUBLE )
-    {
-      sprintf( buff, "%s:      %.2f %s", dictionary_get_string( parameters_list[pos].name_dict ), (float) parameters_list[pos].value / 100.0, parameters_list[pos].unit );
-    }
-    else if ( parameters_list[pos].unit_type == UNIT_STR && parameters_list[pos].value_str != NULL )
-    {
-      sprintf( buff, "%s:      %s", dictionary_get_string( parameters_list[pos].name_dict ), parameters_list[pos].value_str );
-    }
-    else
-    {
-      sprintf( buff, "%s:      %ld %s", dictionary_get_string( parameters_list[pos].name_dict ), parameters_list[pos].value, parameters_list[pos].unit );
-    }
-
-    if ( line + menu->line.start == menu->position )
-    {
-      ssdFigureFillLine( MENU_HEIGHT + LINE_HEIGHT * line, LINE_HEIGHT );
-      oled_printFixedBlack( 2, MENU_HEIGHT + LINE_HEIGHT * line, buff, OLED_FONT_SIZE_11 );
-    }
-    else
-    {
-      oled_printFixed( 2, MENU_HEIGHT + LINE_HEIGHT * line, buff, OLED_FONT_SIZE_11 );
-    }
-    line++;
-  } while ( line + menu->line.start != PARAM_TOP && line < MAX_LINE );
-  scrollBar.actual_line = menu->position;
-  scrollBar.all_line = PARAM_TOP - 1;
-  ssdFigureDrawScrollBar( &scrollBar );
+  widgetListSet( &list_widget, PARAM_TOP, menu->line.start, menu->position );
 
   MOTOR_LED_SET_GREEN( parameters_getValue( PARAM_MOTOR_IS_ON ) );
   SERVO_VIBRO_LED_SET_GREEN( parameters_getValue( PARAM_SERVO_IS_ON ) );
@@ -301,17 +379,29 @@ static bool menu_process( void* arg )
     return false;
   }
 
-  oled_clearScreen();
-  oled_setGLCDFont( OLED_FONT_SIZE_16 );
-  oled_printFixed( 2, 0, dictionary_get_string( menu->name_dict ), OLED_FONT_SIZE_16 );
-  oled_setGLCDFont( OLED_FONT_SIZE_11 );
+  bool connected = backendIsConnected();
+
+  if ( connected != last_connected )
+  {
+    last_connected = connected;
+    oled_clearScreen();
+    widgetScreenInvalidate( &screen );
+  }
+
+  /* Header band is shared with menu driver overlays, redraw everything in it every frame */
+  widgetLabelSetPhrase( &title_widget, menu->name_dict );
+  widgetScreenInvalidateRect( &screen, &header_band );
+  widgetScreenSetOverlay( &screen, backendIsEmergencyDisable() ? &emergency_overlay : NULL );
 
-  if ( backendIsConnected() )
+  if ( connected )
   {
     ret = _connected_process( menu );
+    widgetScreenRender( &screen );
   }
   else
   {
+    oled_clearScreen();
+    oled_printFixed( 2, 0, dictionary_get_string( menu->name_dict ), OLED_FONT_SIZE_16 );
     ret = _disconnected_process( menu );
   }
 
@@ -0,0 +1,154 @@
+#include "panel_power.h"
+
+#include "app_config.h"
+#include "ssd1306.h"
+
+#define MODULE_NAME "[PANEL PWR] "
+#define DEBUG_LVL   PRINT_INFO
+
+#if CONFIG_DEBUG_MENU_BACKEND
+#define LOG( _lvl, ... ) \
+  debug_printf( DEBUG_LVL, _lvl, MODULE_NAME __VA_ARGS__ )
+#else
+#define LOG( PRINT_INFO, ... )
+#endif
+
+#define DIM_TIMEOUT_MS        ( 30 * 1000 )
+#define POWER_SAVE_TIMEOUT_MS ( 120 * 1000 )
+
+#define CONTRAST_MAX          255
+#define CONTRAST_MIN          16
+#define CONTRAST_LOW_BATTERY  96
+#define CONTRAST_HYSTERESIS   8
+#define VOLTAGE_FULL_CONTRAST 3.8
+#define VOLTAGE_LOW_CONTRAST  3.4
+
+typedef struct
+{
+  panel_power_state_t state;
+  TickType_t last_activity;
+  float voltage;
+  uint8_t contrast;
+  bool contrast_set;
+} panel_power_ctx_t;
+
+static panel_power_ctx_t ctx;
+
+static char* state_name[] =
+  {
+    [PANEL_POWER_ACTIVE] = "PANEL_POWER_ACTIVE",
+    [PANEL_POWER_DIMMED] = "PANEL_POWER_DIMMED",
+    [PANEL_POWER_SAVE] = "PANEL_POWER_SAVE" };
+
+static void change_state( panel_power_state_t new_state )
+{
+  if ( ctx.state != new_state )
+  {
+    LOG( PRINT_INFO, "Panel %s", state_name[new_state] );
+    ctx.state = new_state;
+  }
+}
+
+static uint8_t _battery_contrast( float voltage, bool is_charging )
+{
+  if ( is_charging || voltage >= VOLTAGE_FULL_CONTRAST )
+  {
+    return CONTRAST_MAX;
+  }
+
+  if ( voltage <= VOLTAGE_LOW_CONTRAST )
+  {
+    return CONTRAST_LOW_BATTERY;
+  }
+
+  return CONTRAST_LOW_BATTERY + ( CONTRAST_MAX - CONTRAST_LOW_BATTERY ) * ( voltage - VOLTAGE_LOW_CONTRAST ) / ( VOLTAGE_FULL_CONTRAST - VOLTAGE_LOW_CONTRAST );
+}
+
+static void _set_contrast( uint8_t contrast )
+{
+  if ( ctx.contrast_set && !panelPowerContrastChange( ctx.contrast, contrast ) )
+  {
+    return;
+  }
+
+  ssd1306_setContrast( contrast );
+  ctx.contrast = contrast;
+  ctx.contrast_set = true;
+}
+
+void panelPowerActivity( void )
+{
+  ctx.last_activity = xTaskGetTickCount();
+  change_state( PANEL_POWER_ACTIVE );
+}
+
+/* Called from menu driver task on every frame, the same task flushes the display */
+void panelPowerProcess( float battery_voltage, bool is_charging )
+{
+  TickType_t idle = xTaskGetTickCount() - ctx.last_activity;
+
+  ctx.voltage = ctx.voltage == 0 ? battery_voltage : ctx.voltage + ( battery_voltage - ctx.voltage ) / 8;
+
+  change_state( panelPowerStateForIdle( ctx.state, idle ) );
+  _set_contrast( panelPowerTargetContrast( ctx.state, ctx.voltage, is_charging ) );
+}
+
+panel_power_state_t panelPowerStateForIdle( panel_power_state_t state, TickType_t idle )
+{
+  if ( idle >= MS2ST( POWER_SAVE_TIMEOUT_MS ) )
+  {
+    return PANEL_POWER_SAVE;
+  }
+
+  if ( idle >= MS2ST( DIM_TIMEOUT_MS ) )
+  {
+    return PANEL_POWER_DIMMED;
+  }
+
+  return state;
+}
+
+uint8_t panelPowerTargetContrast( panel_power_state_t state, float voltage, bool is_charging )
+{
+  uint8_t contrast = _battery_contrast( voltage, is_charging );
+
+  switch ( state )
+  {
+    case PANEL_POWER_ACTIVE:
+      return contrast;
+
+    case PANEL_POWER_DIMMED:
+      return contrast / 4 > CONTRAST_MIN ? contrast / 4 : CONTRAST_MIN;
+
+    default:
+      return CONTRAST_MIN;
+  }
+}
+
+/* Small steps of filtered voltage would rewrite contrast on every frame */
+bool panelPowerContrastChange( uint8_t current, uint8_t target )
+{
+  int diff = (int) target - (int) current;
+
+  if ( target == current )
+  {
+    return false;
+  }
+
+  return diff >= CONTRAST_HYSTERESIS || diff <= -CONTRAST_HYSTERESIS || target == CONTRAST_MAX || target == CONTRAST_MIN;
+}
+
+panel_power_state_t panelPowerGetState( void )
+{
+  return ctx.state;
+}
+
+bool panelPowerIsPowerSave( void )
+{
+  return ctx.state == PANEL_POWER_SAVE;
+}
+
+uint8_t panelPowerGetContrast( void )
+{
+  return ctx.contrast;
+}
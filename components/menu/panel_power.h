@@ -0,0 +1,26 @@
+#ifndef PANEL_POWER_H_
+#define PANEL_POWER_H_
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "freertos/FreeRTOS.h"
+
+typedef enum
+{
+  PANEL_POWER_ACTIVE,
+  PANEL_POWER_DIMMED,
+  PANEL_POWER_SAVE,
+} panel_power_state_t;
+
+void panelPowerActivity( void );
+void panelPowerProcess( float battery_voltage, bool is_charging );
+panel_power_state_t panelPowerGetState( void );
+bool panelPowerIsPowerSave( void );
+uint8_t panelPowerGetContrast( void );
+
+/* Policy, no panel access */
+panel_power_state_t panelPowerStateForIdle( panel_power_state_t state, TickType_t idle );
+uint8_t panelPowerTargetContrast( panel_power_state_t state, float voltage, bool is_charging );
+bool panelPowerContrastChange( uint8_t current, uint8_t target );
+
+#endif
@@ -0,0 +1,196 @@
+#include "param_cache.h"
+
+#include "app_config.h"
+#include "http_parameters_client.h"
+#include "parameters.h"
+
+#define MODULE_NAME "[P CACHE] "
+#define DEBUG_LVL   PRINT_INFO
+
+#if CONFIG_DEBUG_MENU_BACKEND
+#define LOG( _lvl, ... ) \
+  debug_printf( DEBUG_LVL, _lvl, MODULE_NAME __VA_ARGS__ )
+#else
+#define LOG( PRINT_INFO, ... )
+#endif
+
+#define REQUEST_TIMEOUT_MS 2000
+/* No new request is started after this, round with unreachable controller ends after one timeout */
+#define ROUND_BUDGET_MS    1000
+#define STALE_FACTOR       3
+#define STATS_PERIOD_MS    ( 60 * 1000 )
+
+typedef struct
+{
+  uint32_t param;
+  bool is_str;
+  uint32_t period_ms;
+  uint8_t views;
+  bool valid;
+  /* Last request failed, retried on next period like a regular refresh */
+  bool failed;
+  bool attempted;
+  TickType_t last_update;
+  TickType_t last_attempt;
+} param_cache_entry_t;
+
+typedef struct
+{
+  uint8_t active_views;
+  /* Round that ran out of time continues here, entries at table start do not starve the rest */
+  size_t next;
+  uint32_t requests;
+  uint32_t requests_per_minute;
+  TickType_t stats_timer;
+} param_cache_ctx_t;
+
+static param_cache_ctx_t ctx;
+
+static param_cache_entry_t entries[] =
+  {
+    { .param = PARAM_CURRENT_MOTOR,             .period_ms = 250,   .views = PARAM_CACHE_VIEW_START | PARAM_CACHE_VIEW_PARAMETERS },
+    { .param = PARAM_MACHINE_ERRORS,            .period_ms = 500,   .views = PARAM_CACHE_VIEW_START                               },
+    { .param = PARAM_VOLTAGE_ACCUM,             .period_ms = 1000,  .views = PARAM_CACHE_VIEW_START | PARAM_CACHE_VIEW_PARAMETERS },
+    { .param = PARAM_ACCUM_SOC,                 .period_ms = 1000,  .views = PARAM_CACHE_VIEW_START                               },
+    { .param = PARAM_SILOS_LEVEL,               .period_ms = 1000,  .views = PARAM_CACHE_VIEW_START | PARAM_CACHE_VIEW_PARAMETERS },
+    { .param = PARAM_LOW_LEVEL_SILOS,           .period_ms = 1000,  .views = PARAM_CACHE_VIEW_START                               },
+    { .param = PARAM_SILOS_SENSOR_IS_CONNECTED, .period_ms = 2000,  .views = PARAM_CACHE_VIEW_START                               },
+    { .param = PARAM_TEMPERATURE,               .period_ms = 2000,  .views = PARAM_CACHE_VIEW_PARAMETERS                          },
+    { .param = PARAM_SESSION_MASS,              .period_ms = 2000,  .views = PARAM_CACHE_VIEW_PARAMETERS                          },
+    { .param = PARAM_MASS_TOTAL,                .period_ms = 10000, .views = PARAM_CACHE_VIEW_PARAMETERS                          },
+    { .param = PARAM_WORK_TIME,                 .period_ms = 10000, .views = PARAM_CACHE_VIEW_PARAMETERS                          },
+    { .param = PARAM_STR_CONTROLLER_SN,         .period_ms = 60000, .views = PARAM_CACHE_VIEW_START | PARAM_CACHE_VIEW_PARAMETERS, .is_str = true },
+};
+
+static param_cache_entry_t* _find( uint32_t param, bool is_str )
+{
+  for ( size_t i = 0; i < sizeof( entries ) / sizeof( entries[0] ); i++ )
+  {
+    if ( entries[i].param == param && entries[i].is_str == is_str )
+    {
+      return &entries[i];
+    }
+  }
+
+  return NULL;
+}
+
+static bool _is_stale( param_cache_entry_t* entry )
+{
+  if ( entry == NULL )
+  {
+    return false;
+  }
+
+  return !entry->valid || xTaskGetTickCount() - entry->last_update > MS2ST( entry->period_ms * STALE_FACTOR );
+}
+
+static bool _request( param_cache_entry_t* entry )
+{
+  ctx.requests++;
+  if ( entry->is_str )
+  {
+    return HTTPParamClient_GetStrValue( entry->param, NULL, 0, REQUEST_TIMEOUT_MS ) == ERROR_CODE_OK;
+  }
+
+  return HTTPParamClient_GetU32Value( entry->param, NULL, REQUEST_TIMEOUT_MS ) == ERROR_CODE_OK;
+}
+
+static void _update_stats( TickType_t now )
+{
+  if ( now - ctx.stats_timer < MS2ST( STATS_PERIOD_MS ) )
+  {
+    return;
+  }
+
+  ctx.requests_per_minute = ctx.requests * STATS_PERIOD_MS / ST2MS( now - ctx.stats_timer );
+  ctx.requests = 0;
+  ctx.stats_timer = now;
+  LOG( PRINT_INFO, "Requests per minute %ld", ctx.requests_per_minute );
+}
+
+void paramCacheRefresh( void )
+{
+  TickType_t now = xTaskGetTickCount();
+  size_t count = sizeof( entries ) / sizeof( entries[0] );
+  size_t start = ctx.next;
+
+  for ( size_t n = 0; n < count; n++ )
+  {
+    size_t i = ( start + n ) % count;
+    param_cache_entry_t* entry = &entries[i];
+
+    if ( ( entry->views & ctx.active_views ) == 0 )
+    {
+      continue;
+    }
+
+    if ( entry->attempted && now - entry->last_attempt < MS2ST( entry->period_ms ) )
+    {
+      continue;
+    }
+
+    if ( xTaskGetTickCount() - now >= MS2ST( ROUND_BUDGET_MS ) )
+    {
+      LOG( PRINT_DEBUG, "Refresh round out of time at %ld", entry->param );
+      ctx.next = i;
+      break;
+    }
+
+    entry->attempted = true;
+    entry->last_attempt = now;
+    ctx.next = ( i + 1 ) % count;
+
+    if ( !_request( entry ) )
+    {
+      /* One failing parameter must not keep the rest of list from refreshing */
+      if ( !entry->failed )
+      {
+        LOG( PRINT_DEBUG, "Refresh %ld failed", entry->param );
+      }
+
+      entry->failed = true;
+      continue;
+    }
+
+    entry->failed = false;
+    entry->valid = true;
+    entry->last_update = xTaskGetTickCount();
+  }
+
+  _update_stats( now );
+}
+
+void paramCacheEnterView( param_cache_view_t view )
+{
+  ctx.active_views |= view;
+}
+
+void paramCacheExitView( param_cache_view_t view )
+{
+  ctx.active_views &= ~view;
+}
+
+void paramCacheInvalidate( void )
+{
+  for ( size_t i = 0; i < sizeof( entries ) / sizeof( entries[0] ); i++ )
+  {
+    entries[i].valid = false;
+    entries[i].attempted = false;
+  }
+}
+
+bool paramCacheIsStale( uint32_t param )
+{
+  return _is_stale( _find( param, false ) );
+}
+
+bool paramCacheIsStrStale( uint32_t param )
+{
+  return _is_stale( _find( param, true ) );
+}
+
+uint32_t paramCacheGetRequestsPerMinute( void )
+{
+  return ctx.requests_per_minute;
+}
@@ -0,0 +1,20 @@
+#ifndef PARAM_CACHE_H_
+#define PARAM_CACHE_H_
+#include <stdbool.h>
+#include <stdint.h>
+
+typedef enum
+{
+  PARAM_CACHE_VIEW_START = 1 << 0,
+  PARAM_CACHE_VIEW_PARAMETERS = 1 << 1,
+} param_cache_view_t;
+
+void paramCacheEnterView( param_cache_view_t view );
+void paramCacheExitView( param_cache_view_t view );
+void paramCacheRefresh( void );
+void paramCacheInvalidate( void );
+bool paramCacheIsStale( uint32_t param );
+bool paramCacheIsStrStale( uint32_t param );
+uint32_t paramCacheGetRequestsPerMinute( void );
+
+#endif
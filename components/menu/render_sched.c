@@ -0,0 +1,76 @@
+#include "render_sched.h"
+
+#include "app_config.h"
+#include "esp_timer.h"
+
+uint32_t renderSchedHash( uint32_t hash, uint32_t value )
+{
+  /* FNV-1a step, enough to detect change of screen inputs */
+  return ( hash ^ value ) * 16777619UL;
+}
+
+bool renderSchedBegin( render_sched_t* sched, uint32_t signature, bool animated )
+{
+  return renderSchedBeginAt( sched, xTaskGetTickCount(), signature, animated );
+}
+
+bool renderSchedBeginAt( render_sched_t* sched, TickType_t now, uint32_t signature, bool animated )
+{
+  assert( sched );
+  int64_t time_us = esp_timer_get_time();
+  bool draw = sched->dirty || sched->signature != signature;
+
+  /* Time between end of last draw and this call is taken by the menu driver flush */
+  if ( sched->render_end != 0 )
+  {
+    sched->stats.last_flush_us = (uint32_t) ( time_us - sched->render_end );
+    sched->render_end = 0;
+  }
+
+  if ( animated && sched->target_fps > 0 && now - sched->last_frame >= MS2ST( 1000 / sched->target_fps ) )
+  {
+    draw = true;
+  }
+
+  if ( sched->min_refresh_ms > 0 && now - sched->last_frame >= MS2ST( sched->min_refresh_ms ) )
+  {
+    draw = true;
+  }
+
+  if ( !draw )
+  {
+    sched->stats.skipped++;
+    return false;
+  }
+
+  sched->signature = signature;
+  sched->dirty = false;
+  sched->last_frame = now;
+  sched->render_start = time_us;
+  return true;
+}
+
+void renderSchedEnd( render_sched_t* sched )
+{
+  assert( sched );
+  sched->render_end = esp_timer_get_time();
+  sched->stats.frames++;
+  sched->stats.last_render_us = (uint32_t) ( sched->render_end - sched->render_start );
+  if ( sched->stats.last_render_us > sched->stats.max_render_us )
+  {
+    sched->stats.max_render_us = sched->stats.last_render_us;
+  }
+}
+
+void renderSchedMarkDirty( render_sched_t* sched )
+{
+  assert( sched );
+  sched->dirty = true;
+}
+
+void renderSchedGetStats( render_sched_t* sched, render_stats_t* stats )
+{
+  assert( sched );
+  assert( stats );
+  *stats = sched->stats;
+}
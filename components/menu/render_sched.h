@@ -0,0 +1,36 @@
+#ifndef RENDER_SCHED_H_
+#define RENDER_SCHED_H_
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "freertos/FreeRTOS.h"
+
+typedef struct
+{
+  uint32_t frames;
+  uint32_t skipped;
+  uint32_t last_render_us;
+  uint32_t max_render_us;
+  uint32_t last_flush_us;
+} render_stats_t;
+
+typedef struct
+{
+  uint32_t target_fps;
+  uint32_t min_refresh_ms;
+  uint32_t signature;
+  bool dirty;
+  TickType_t last_frame;
+  int64_t render_start;
+  int64_t render_end;
+  render_stats_t stats;
+} render_sched_t;
+
+uint32_t renderSchedHash( uint32_t hash, uint32_t value );
+bool renderSchedBegin( render_sched_t* sched, uint32_t signature, bool animated );
+bool renderSchedBeginAt( render_sched_t* sched, TickType_t now, uint32_t signature, bool animated );
+void renderSchedEnd( render_sched_t* sched );
+void renderSchedMarkDirty( render_sched_t* sched );
+void renderSchedGetStats( render_sched_t* sched, render_stats_t* stats );
+
+#endif
@@ -746,6 +746,27 @@ int ssdFigureFillLine( int y_start, int height )
   return TRUE;
 }
 
+void ssdFigureFillRect( uint8_t x, uint8_t y, uint8_t width, uint8_t height, bool set )
+{
+  int x_end = x + width < SSD1306_WIDTH ? x + width : SSD1306_WIDTH;
+  int y_end = y + height < SSD1306_HEIGHT ? y + height : SSD1306_HEIGHT;
+
+  for ( int i = x; i < x_end; i++ )
+  {
+    for ( int j = y; j < y_end; j++ )
+    {
+      if ( set )
+      {
+        oled_putPixel( i, j );
+      }
+      else
+      {
+        oled_clearPixel( i, j );
+      }
+    }
+  }
+}
+
 void drawVibro( uint8_t x, uint8_t y, uint8_t cnt )
 {
   if ( cnt > 3 )
@@ -1005,43 +1026,31 @@ static void _draw_low_accu4( uint8_t x, uint8_t y )
   }
 }
 
-void ssdFigure_DrawLowAccu( uint8_t x, uint8_t y, float acc_voltage, float acc_current )
+void ssdFigure_DrawLowAccu( uint8_t x, uint8_t y, uint8_t soc )
 {
   animation_counter_process();
-  uint8_t x_charge = 0;
-  acc_state_t state = 0;
-#if CONFIG_DEVICE_SOLARKA    ///Mariusz
-  int ds = 10;
-  acc_current = acc_current * ds;
-#else
-  int ds = 10;
-  acc_current = acc_current / ds;
-#endif
-
-  if ( acc_voltage > 1240 - acc_current && acc_voltage < 1700 - acc_current )
+  acc_state_t state = ACC_0_blink;
+
+  if ( soc >= 80 )
   {
     state = ACC_4;
   }
-  else if ( acc_voltage > 1200 - acc_current && acc_voltage < 1241 - acc_current )
+  else if ( soc >= 60 )
   {
     state = ACC_3;
   }
-  else if ( acc_voltage > 1150 - acc_current && acc_voltage < 1201 - acc_current )
+  else if ( soc >= 40 )
   {
     state = ACC_2;
   }
-  else if ( acc_voltage > 1100 - acc_current && acc_voltage < 1151 - acc_current )
+  else if ( soc >= 20 )
   {
     state = ACC_1;
   }
-  else if ( acc_voltage > 1050 - acc_current && acc_voltage < 1101 - acc_current )
+  else if ( soc >= 10 )
   {
     state = ACC_0;
   }
-  else if ( acc_voltage > 200 - acc_current && acc_voltage < 1051 - acc_current )
-  {
-    state = ACC_0_blink;
-  }
 
   switch ( state )
   {
@@ -1079,32 +1088,23 @@ void ssdFigure_DrawLowAccu( uint8_t x, uint8_t y, float acc_voltage, float acc_c
   }
 }
 
-void drawBattery( uint8_t x, uint8_t y, float accum_voltage, bool is_charging )
+void drawBattery( uint8_t x, uint8_t y, float accum_voltage, uint8_t soc, bool is_charging )
 {
   animation_counter_process();
-  uint8_t x_charge = 0;
+  uint8_t x_charge = soc * 8 / 100;
 
   //      char buff[20];
   //   sprintf(buff, "%3f", accum_voltage);
   //         oled_printFixed(25, 0, buff, OLED_FONT_SIZE_11);
 
-  if ( accum_voltage < 3.2 )
+  if ( x_charge > 7 )
   {
-    x_charge = 0;
-  }
-  else
-  {
-    x_charge = (uint8_t) ( (float) ( accum_voltage - 3.2 ) * 8.0 );
-
-    if ( x_charge > 7 )
-    {
-      x_charge = 7;
-    }
+    x_charge = 7;
   }
 
   battery_state_t state = BATTERY_NORMAL;
 
-  if ( accum_voltage < 3.48 )
+  if ( soc < 8 )
   {
     state = BATTERY_LOW_VOLTAGE;
   }
@@ -22,13 +22,14 @@ typedef struct
 int ssdFigureDrawLoadBar( loadBar_t* figure );
 int ssdFigureDrawScrollBar( scrollBar_t* figure );
 int ssdFigureFillLine( int y_start, int height );
+void ssdFigureFillRect( uint8_t x, uint8_t y, uint8_t width, uint8_t height, bool set );
 void drawMotor( uint8_t x, uint8_t y );
 void drawMotorCircle( uint8_t x, uint8_t y, uint8_t cnt );
 void drawVibro( uint8_t x, uint8_t y, uint8_t cnt );
 void drawServo( uint8_t x, uint8_t y, uint8_t open );
-void drawBattery( uint8_t x, uint8_t y, float accum_voltage, bool is_charging );
+void drawBattery( uint8_t x, uint8_t y, float accum_voltage, uint8_t soc, bool is_charging );
 void drawSignal( uint8_t x, uint8_t y, uint8_t signal_lvl );
 void drawQR( uint8_t x, uint8_t y );
-void ssdFigure_DrawLowAccu( uint8_t x, uint8_t y, float acc_voltage, float acc_current );
+void ssdFigure_DrawLowAccu( uint8_t x, uint8_t y, uint8_t soc );
 
 #endif
\ No newline at end of file
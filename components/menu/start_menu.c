@@ -4,6 +4,7 @@
 #include "battery.h"
 #include "buzzer.h"
 #include "cmd_client.h"
+#include "deadline.h"
 #include "dictionary.h"
 #include "fast_add.h"
 #include "freertos/timers.h"
@@ -12,7 +13,9 @@
 #include "menu_default.h"
 #include "menu_drv.h"
 #include "oled.h"
+#include "panel_power.h"
 #include "parameters.h"
+#include "render_sched.h"
 #include "ssd1306.h"
 #include "ssdFigure.h"
 #include "wifi_menu.h"
@@ -30,9 +33,11 @@
 
 #define DEVICE_LIST_SIZE         16
 #define CHANGE_MENU_TIMEOUT_MS   1500
-#define POWER_SAVE_TIMEOUT_MS    30 * 1000
 #define CHANGE_VALUE_DISP_OFFSET 40
 #define MENU_START_OFFSET        42
+#define READY_TARGET_FPS         10
+#define READY_MIN_REFRESH_MS     250
+#define POWER_SAVE_REFRESH_MS    1000
 
 typedef enum
 {
@@ -77,8 +82,8 @@ typedef struct
   const char* info_msg;
   char buff[128];
   char ap_name[64];
-  uint32_t timeout_con;
-  uint32_t low_silos_ckeck_timeout;
+  deadline_t timeout_con;
+  deadline_t low_silos_ckeck_timeout;
   error_type_t error_dev;
 
 #if MENU_VIRO_ON_OFF_VERSION
@@ -86,16 +91,26 @@ typedef struct
 #endif
 
   struct menu_data data;
-  TickType_t animation_timeout;
+  deadline_t animation_timeout;
   uint8_t animation_cnt;
-  TickType_t change_menu_timeout;
-  TickType_t go_to_power_save_timeout;
-  TickType_t low_silos_timeout;
+  deadline_t change_menu_timeout;
+  deadline_t low_silos_timeout;
   TimerHandle_t servo_timer;
 } menu_start_context_t;
 
 static menu_start_context_t ctx;
 
+static render_sched_t ready_render =
+  {
+    .target_fps = READY_TARGET_FPS,
+    .min_refresh_ms = READY_MIN_REFRESH_MS,
+};
+
+static render_sched_t power_save_render =
+  {
+    .min_refresh_ms = POWER_SAVE_REFRESH_MS,
+};
+
 loadBar_t motor_bar =
   {
     .x = 40,
@@ -139,6 +154,8 @@ static void change_state( state_start_menu_t new_state )
     if ( ctx.state != new_state )
     {
       LOG( PRINT_INFO, "Start menu %s", state_name[new_state] );
+      renderSchedMarkDirty( &ready_render );
+      renderSchedMarkDirty( &power_save_render );
     }
 
     ctx.state = new_state;
@@ -178,7 +195,7 @@ static void set_change_menu( edit_value_t val )
         return;
     }
 
-    ctx.change_menu_timeout = MS2ST( CHANGE_MENU_TIMEOUT_MS ) + xTaskGetTickCount();
+    deadlineArm( &ctx.change_menu_timeout, CHANGE_MENU_TIMEOUT_MS );
   }
 }
 
@@ -202,10 +219,10 @@ static bool _is_power_save( void )
   return false;
 }
 
-// static void _enter_power_save(void)
-// {
-//  wifiDrvPowerSave(true);
-// }
+static void _enter_power_save( void )
+{
+  wifiDrvPowerSave( true );
+}
 
 static void _exit_power_save( void )
 {
@@ -214,7 +231,7 @@ static void _exit_power_save( void )
 
 static void _reset_power_save_timer( void )
 {
-  ctx.go_to_power_save_timeout = MS2ST( POWER_SAVE_TIMEOUT_MS ) + xTaskGetTickCount();
+  panelPowerActivity();
 }
 
 static bool _check_low_silos_flag( void )
@@ -224,18 +241,18 @@ static bool _check_low_silos_flag( void )
   LOG( PRINT_DEBUG, "------SILOS FLAG %d---------", flag );
   if ( flag > 0 )
   {
-    if ( ctx.low_silos_ckeck_timeout < xTaskGetTickCount() )
+    if ( deadlineExpired( &ctx.low_silos_ckeck_timeout ) )
     {
-      ctx.low_silos_ckeck_timeout = MS2ST( 30000 ) + xTaskGetTickCount();
+      deadlineArm( &ctx.low_silos_ckeck_timeout, 30000 );
       change_state( STATE_LOW_SILOS );
       buzzer_click();
-      ctx.low_silos_timeout = MS2ST( 5000 ) + xTaskGetTickCount();
+      deadlineArm( &ctx.low_silos_timeout, 5000 );
       return true;
     }
   }
   else
   {
-    ctx.low_silos_ckeck_timeout = MS2ST( 10000 ) + xTaskGetTickCount();
+    deadlineArm( &ctx.low_silos_ckeck_timeout, 10000 );
   }
 
   return false;
@@ -829,6 +846,7 @@ static bool menu_enter_cb( void* arg )
 
   _exit_power_save();
   _reset_power_save_timer();
+  renderSchedMarkDirty( &ready_render );
 
   if ( !backendIsConnected() )
   {
@@ -880,6 +898,11 @@ static bool menu_exit_cb( void* arg )
   SERVO_VIBRO_LED_SET_GREEN( 0 );
   MOTOR_LED_SET_RED( 0 );
   SERVO_VIBRO_LED_SET_RED( 0 );
+
+  render_stats_t stats;
+  renderSchedGetStats( &ready_render, &stats );
+  LOG( PRINT_INFO, "Render frames %ld skipped %ld render %ld/%ld us flush %ld us", stats.frames, stats.skipped, stats.last_render_us,
+       stats.max_render_us, stats.last_flush_us );
   return true;
 }
 
@@ -973,6 +996,31 @@ static void menu_start_start( void )
   change_state( STATE_READY );
 }
 
+static uint32_t _ready_signature( bool animated )
+{
+  uint32_t hash = 2166136261UL;
+
+  hash = renderSchedHash( hash, ctx.data.motor_value );
+  hash = renderSchedHash( hash, ctx.data.servo_value );
+  hash = renderSchedHash( hash, ctx.data.motor_on );
+  hash = renderSchedHash( hash, ctx.data.servo_vibro_on );
+#if MENU_VIRO_ON_OFF_VERSION
+  hash = renderSchedHash( hash, ctx.edit_value );
+  hash = renderSchedHash( hash, ctx.data.vibro_on_s );
+  hash = renderSchedHash( hash, ctx.data.vibro_off_s );
+#endif
+  hash = renderSchedHash( hash, wifiMenu_GetDevType() );
+  hash = renderSchedHash( hash, parameters_getValue( PARAM_ACCUM_SOC ) );
+  hash = renderSchedHash( hash, parameters_getValue( PARAM_SILOS_SENSOR_IS_CONNECTED ) );
+  hash = renderSchedHash( hash, parameters_getValue( PARAM_SILOS_LEVEL ) );
+  if ( animated )
+  {
+    hash = renderSchedHash( hash, ctx.animation_cnt );
+  }
+
+  return hash;
+}
+
 static void menu_start_ready( void )
 {
   if ( !backendIsConnected() )
@@ -988,20 +1036,25 @@ static void menu_start_ready( void )
     return;
   }
 
-/* Enter power save. Not used */
-#if 0
-    if (ctx.go_to_power_save_timeout < xTaskGetTickCount())
-    {
-        _enter_power_save();
-        change_state(STATE_POWER_SAVE);
-        return;
-    }
-#endif
+  /* Enter power save when panel is idle and machine is stopped */
+  if ( panelPowerIsPowerSave() && !ctx.data.motor_on && !ctx.data.servo_vibro_on )
+  {
+    _enter_power_save();
+    change_state( STATE_POWER_SAVE );
+    return;
+  }
 
-  if ( ctx.animation_timeout < xTaskGetTickCount() )
+  if ( deadlineExpired( &ctx.animation_timeout ) )
   {
     ctx.animation_cnt++;
-    ctx.animation_timeout = xTaskGetTickCount() + MS2ST( 100 );
+    deadlineArm( &ctx.animation_timeout, 100 );
+  }
+
+  /* Static screen is redrawn on input change only, animation runs at target FPS */
+  bool animated = ctx.data.motor_on || ctx.data.servo_vibro_on;
+  if ( !renderSchedBegin( &ready_render, _ready_signature( animated ), animated ) )
+  {
+    return;
   }
 
   char str[32];
@@ -1022,7 +1075,7 @@ static void menu_start_ready( void )
 
   if ( wifiMenu_GetDevType() == T_DEV_TYPE_SOLARKA || wifiMenu_GetDevType() == T_DEV_TYPE_SIEWNIK )
   {
-    ssdFigure_DrawLowAccu( 60, 1, parameters_getValue( PARAM_VOLTAGE_ACCUM ), parameters_getValue( PARAM_CURRENT_MOTOR ) );
+    ssdFigure_DrawLowAccu( 60, 1, parameters_getValue( PARAM_ACCUM_SOC ) );
 
     if ( parameters_getValue( PARAM_SILOS_SENSOR_IS_CONNECTED ) )
     {
@@ -1107,6 +1160,8 @@ static void menu_start_ready( void )
   {
     oled_printFixed( 2, 3 * LINE_HEIGHT, "Unsupported\ndevice type", OLED_FONT_SIZE_11 );
   }
+
+  renderSchedEnd( &ready_render );
 }
 
 static void menu_start_power_save( void )
@@ -1122,8 +1177,14 @@ static void menu_start_power_save( void )
     return;
   }
 
-  menuPrintfInfo( dictionary_get_string( DICT_POWER_SAVE ) );
   backendEnterMenuStart();
+
+  /* Static screen, reduced refresh rate */
+  if ( renderSchedBegin( &power_save_render, 0, false ) )
+  {
+    menuPrintfInfo( dictionary_get_string( DICT_POWER_SAVE ) );
+    renderSchedEnd( &power_save_render );
+  }
 }
 
 static void menu_start_low_silos( void )
@@ -1134,7 +1195,7 @@ static void menu_start_low_silos( void )
     return;
   }
 
-  if ( ctx.low_silos_timeout < xTaskGetTickCount() )
+  if ( deadlineExpired( &ctx.low_silos_timeout ) )
   {
     change_state( STATE_READY );
     return;
@@ -1225,12 +1286,12 @@ static void menu_start_motor_change( void )
     menu_set_error_msg( dictionary_get_string( DICT_LOST_CONNECTION_WITH_SERVER ) );
     return;
   }
-  ssdFigure_DrawLowAccu( 60, 1, parameters_getValue( PARAM_VOLTAGE_ACCUM ), parameters_getValue( PARAM_CURRENT_MOTOR ) );
+  ssdFigure_DrawLowAccu( 60, 1, parameters_getValue( PARAM_ACCUM_SOC ) );
   oled_printFixed( 0, 0, dictionary_get_string( DICT_MOTOR ), OLED_FONT_SIZE_26 );
   sprintf( ctx.buff, "%ld%%", ctx.data.motor_value );
   oled_printFixed( CHANGE_VALUE_DISP_OFFSET, MENU_HEIGHT + LINE_HEIGHT, ctx.buff, OLED_FONT_SIZE_26 );    // Font_16x26
 
-  if ( ctx.change_menu_timeout < xTaskGetTickCount() )
+  if ( deadlineExpired( &ctx.change_menu_timeout ) )
   {
     change_state( STATE_READY );
   }
@@ -1238,7 +1299,7 @@ static void menu_start_motor_change( void )
 
 static void menu_start_vibro_change( void )
 {
-  ssdFigure_DrawLowAccu( 60, 1, parameters_getValue( PARAM_VOLTAGE_ACCUM ), parameters_getValue( PARAM_CURRENT_MOTOR ) );
+  ssdFigure_DrawLowAccu( 60, 1, parameters_getValue( PARAM_ACCUM_SOC ) );
 
   if ( !backendIsConnected() )
   {
@@ -1274,13 +1335,13 @@ static void menu_start_vibro_change( void )
   }
   else
   {
-    ssdFigure_DrawLowAccu( 60, 1, parameters_getValue( PARAM_VOLTAGE_ACCUM ), parameters_getValue( PARAM_CURRENT_MOTOR ) );
+    ssdFigure_DrawLowAccu( 60, 1, parameters_getValue( PARAM_ACCUM_SOC ) );
     oled_printFixed( 0, 0, dictionary_get_string( DICT_SERVO ), OLED_FONT_SIZE_26 );
     sprintf( ctx.buff, "%ld%%", ctx.data.servo_value );
     oled_printFixed( CHANGE_VALUE_DISP_OFFSET, MENU_HEIGHT + LINE_HEIGHT, ctx.buff, OLED_FONT_SIZE_26 );
   }
 
-  if ( ctx.change_menu_timeout < xTaskGetTickCount() )
+  if ( deadlineExpired( &ctx.change_menu_timeout ) )
   {
     change_state( STATE_READY );
   }
@@ -1328,11 +1389,11 @@ static void _show_wait_connection( void )
 static void menu_wait_connect( void )
 {
   /* Wait to connect wifi */
-  ctx.timeout_con = MS2ST( 10000 ) + xTaskGetTickCount();
+  deadlineArm( &ctx.timeout_con, 10000 );
   ctx.exit_wait_flag = false;
   do
   {
-    if ( ( ctx.timeout_con < xTaskGetTickCount() ) || ctx.exit_wait_flag )
+    if ( deadlineExpired( &ctx.timeout_con ) || ctx.exit_wait_flag )
     {
       menu_set_error_msg( dictionary_get_string( DICT_TIMEOUT_CONNECT ) );
       return;
@@ -1342,10 +1403,10 @@ static void menu_wait_connect( void )
     osDelay( 50 );
   } while ( wifiDrvTryingConnect() );
 
-  ctx.timeout_con = MS2ST( 10000 ) + xTaskGetTickCount();
+  deadlineArm( &ctx.timeout_con, 10000 );
   do
   {
-    if ( ( ctx.timeout_con < xTaskGetTickCount() ) || ctx.exit_wait_flag )
+    if ( deadlineExpired( &ctx.timeout_con ) || ctx.exit_wait_flag )
     {
       menu_set_error_msg( dictionary_get_string( DICT_TIMEOUT_SERVER ) );
       return;
@@ -0,0 +1,101 @@
+#include "text_cache.h"
+
+#include <string.h>
+
+#include "app_config.h"
+
+typedef struct
+{
+  text_run_t runs[TEXT_CACHE_SIZE];
+  uint8_t count;
+  uint32_t use_cnt;
+  uint32_t hits;
+  uint32_t misses;
+} text_cache_ctx_t;
+
+static text_cache_ctx_t ctx;
+
+static void _measure( text_run_t* run )
+{
+  uint8_t glyphs = 0;
+
+  run->lines = 1;
+  run->max_line_glyphs = 0;
+  for ( const char* c = run->text; *c != 0; c++ )
+  {
+    if ( *c == '\n' )
+    {
+      run->lines++;
+      glyphs = 0;
+      continue;
+    }
+
+    /* Count UTF-8 lead bytes only, continuation bytes do not start a glyph */
+    if ( ( *c & 0xC0 ) != 0x80 )
+    {
+      glyphs++;
+      if ( glyphs > run->max_line_glyphs )
+      {
+        run->max_line_glyphs = glyphs;
+      }
+    }
+  }
+}
+
+static text_run_t* _lru_slot( void )
+{
+  if ( ctx.count < TEXT_CACHE_SIZE )
+  {
+    return &ctx.runs[ctx.count++];
+  }
+
+  text_run_t* oldest = &ctx.runs[0];
+  for ( uint8_t i = 1; i < TEXT_CACHE_SIZE; i++ )
+  {
+    if ( ctx.runs[i].last_used < oldest->last_used )
+    {
+      oldest = &ctx.runs[i];
+    }
+  }
+
+  return oldest;
+}
+
+const text_run_t* textCacheGet( enum dictionary_phrase phrase, uint8_t font )
+{
+  menu_language_t language = dictionary_get_language();
+
+  ctx.use_cnt++;
+  for ( uint8_t i = 0; i < ctx.count; i++ )
+  {
+    text_run_t* run = &ctx.runs[i];
+
+    if ( run->phrase == phrase && run->font == font && run->language == language )
+    {
+      run->last_used = ctx.use_cnt;
+      ctx.hits++;
+      return run;
+    }
+  }
+
+  text_run_t* run = _lru_slot();
+  run->phrase = phrase;
+  run->font = font;
+  run->language = language;
+  run->text = dictionary_get_string( phrase );
+  run->last_used = ctx.use_cnt;
+  _measure( run );
+  ctx.misses++;
+  return run;
+}
+
+void textCacheInvalidate( void )
+{
+  ctx.count = 0;
+}
+
+void textCacheGetStats( uint32_t* hits, uint32_t* misses )
+{
+  *hits = ctx.hits;
+  *misses = ctx.misses;
+}
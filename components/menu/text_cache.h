@@ -0,0 +1,24 @@
+#ifndef TEXT_CACHE_H_
+#define TEXT_CACHE_H_
+#include <stdint.h>
+
+#include "dictionary.h"
+
+#define TEXT_CACHE_SIZE 16
+
+typedef struct
+{
+  enum dictionary_phrase phrase;
+  menu_language_t language;
+  uint8_t font;
+  const char* text;
+  uint8_t lines;
+  uint8_t max_line_glyphs;
+  uint32_t last_used;
+} text_run_t;
+
+const text_run_t* textCacheGet( enum dictionary_phrase phrase, uint8_t font );
+void textCacheInvalidate( void );
+void textCacheGetStats( uint32_t* hits, uint32_t* misses );
+
+#endif
@@ -0,0 +1,279 @@
+#include "widget.h"
+
+#include <string.h>
+
+#include "app_config.h"
+#include "esp_timer.h"
+#include "oled.h"
+#include "text_cache.h"
+
+#define MODULE_NAME "[WIDGET] "
+#define DEBUG_LVL   PRINT_INFO
+
+#if CONFIG_DEBUG_MENU_BACKEND
+#define LOG( _lvl, ... ) \
+  debug_printf( DEBUG_LVL, _lvl, MODULE_NAME __VA_ARGS__ )
+#else
+#define LOG( PRINT_INFO, ... )
+#endif
+
+static bool _intersects( const widget_t* widget, const widget_rect_t* rect )
+{
+  return widget->x < rect->x + rect->width && rect->x < widget->x + widget->width
+         && widget->y < rect->y + rect->height && rect->y < widget->y + widget->height;
+}
+
+static void _draw_text( uint8_t x, uint8_t y, uint8_t width, uint8_t height, const char* text, uint8_t font, bool inverted )
+{
+  oled_setGLCDFont( font );
+  if ( inverted )
+  {
+    ssdFigureFillRect( x, y, width, height, true );
+    oled_printFixedBlack( x + 2, y, text, font );
+  }
+  else
+  {
+    oled_printFixed( x + 2, y, text, font );
+  }
+}
+
+static void _draw_list( widget_t* widget )
+{
+  widget_list_t* list = &widget->list;
+
+  for ( uint16_t line = 0; line < WIDGET_LIST_MAX_ROWS && line + list->start < list->count; line++ )
+  {
+    uint8_t y = widget->y + line * list->line_height;
+
+    if ( y + list->line_height > widget->y + widget->height )
+    {
+      break;
+    }
+
+    _draw_text( widget->x, y, widget->width, list->line_height + 1, list->rows[line], list->font, line + list->start == list->position );
+  }
+
+  list->scroll_bar.y_start = widget->y;
+  list->scroll_bar.actual_line = list->position;
+  list->scroll_bar.all_line = list->count > 0 ? list->count - 1 : 0;
+  ssdFigureDrawScrollBar( &list->scroll_bar );
+}
+
+static void _draw( widget_t* widget )
+{
+  switch ( widget->type )
+  {
+    case WIDGET_LABEL:
+      _draw_text( widget->x, widget->y, widget->width, widget->height, widget->label.text, widget->label.font, widget->label.inverted );
+      break;
+
+    case WIDGET_VALUE:
+      oled_printFixed( widget->x, widget->y, widget->value.text, widget->value.font );
+      break;
+
+    case WIDGET_LOAD_BAR:
+      widget->load_bar.x = widget->x;
+      widget->load_bar.y = widget->y;
+      widget->load_bar.width = widget->width;
+      widget->load_bar.height = widget->height;
+      ssdFigureDrawLoadBar( &widget->load_bar );
+      break;
+
+    case WIDGET_ICON:
+      if ( widget->icon.draw != NULL )
+      {
+        widget->icon.draw( widget->x, widget->y, widget->icon.state );
+      }
+
+      break;
+
+    case WIDGET_LIST:
+      _draw_list( widget );
+      break;
+
+    default:
+      break;
+  }
+}
+
+static void _update_list_rows( widget_t* widget )
+{
+  widget_list_t* list = &widget->list;
+
+  for ( uint16_t line = 0; line < WIDGET_LIST_MAX_ROWS && line + list->start < list->count; line++ )
+  {
+    uint16_t row = line + list->start;
+    uint32_t key = list->row_key != NULL ? list->row_key( row ) : row;
+
+    /* Rows are formatted only when the bound value changed */
+    if ( widget->dirty || key != list->keys[line] )
+    {
+      list->keys[line] = key;
+      list->row_format( row, list->rows[line], WIDGET_TEXT_SIZE );
+      widget->dirty = true;
+    }
+  }
+}
+
+void widgetLabelSetText( widget_t* widget, const char* text )
+{
+  assert( widget );
+  if ( strncmp( widget->label.text, text, WIDGET_TEXT_SIZE ) != 0 )
+  {
+    strncpy( widget->label.text, text, WIDGET_TEXT_SIZE - 1 );
+    widget->label.bound_text = NULL;
+    widget->dirty = true;
+  }
+}
+
+void widgetLabelSetPhrase( widget_t* widget, enum dictionary_phrase phrase )
+{
+  assert( widget );
+  const text_run_t* run = textCacheGet( phrase, widget->label.font );
+
+  /* Phrase text is constant for a language, pointer compare is enough */
+  if ( widget->label.bound_text != run->text )
+  {
+    strncpy( widget->label.text, run->text, WIDGET_TEXT_SIZE - 1 );
+    widget->label.bound_text = run->text;
+    widget->dirty = true;
+  }
+}
+
+void widgetLabelSetInverted( widget_t* widget, bool inverted )
+{
+  assert( widget );
+  if ( widget->label.inverted != inverted )
+  {
+    widget->label.inverted = inverted;
+    widget->dirty = true;
+  }
+}
+
+void widgetValueSet( widget_t* widget, int32_t value )
+{
+  assert( widget );
+  if ( !widget->value.valid || widget->value.value != value )
+  {
+    widget->value.value = value;
+    widget->value.valid = true;
+    widget->value.format( value, widget->value.text, WIDGET_TEXT_SIZE );
+    widget->dirty = true;
+  }
+}
+
+void widgetLoadBarSet( widget_t* widget, uint8_t fill )
+{
+  assert( widget );
+  if ( widget->load_bar.fill != fill )
+  {
+    widget->load_bar.fill = fill;
+    widget->dirty = true;
+  }
+}
+
+void widgetIconSet( widget_t* widget, uint32_t state )
+{
+  assert( widget );
+  if ( !widget->icon.valid || widget->icon.state != state )
+  {
+    widget->icon.state = state;
+    widget->icon.valid = true;
+    widget->dirty = true;
+  }
+}
+
+void widgetListSet( widget_t* widget, uint16_t count, uint16_t start, uint16_t position )
+{
+  assert( widget );
+  if ( widget->list.count != count || widget->list.start != start || widget->list.position != position )
+  {
+    widget->list.count = count;
+    widget->list.start = start;
+    widget->list.position = position;
+    widget->dirty = true;
+  }
+
+  _update_list_rows( widget );
+}
+
+void widgetInvalidate( widget_t* widget )
+{
+  assert( widget );
+  widget->dirty = true;
+}
+
+void widgetScreenInvalidate( widget_screen_t* screen )
+{
+  assert( screen );
+  for ( uint8_t i = 0; i < screen->count; i++ )
+  {
+    widgetInvalidate( screen->widgets[i] );
+  }
+}
+
+void widgetScreenInvalidateRect( widget_screen_t* screen, const widget_rect_t* rect )
+{
+  assert( screen );
+  assert( rect );
+  for ( uint8_t i = 0; i < screen->count; i++ )
+  {
+    if ( _intersects( screen->widgets[i], rect ) )
+    {
+      widgetInvalidate( screen->widgets[i] );
+    }
+  }
+}
+
+void widgetScreenSetOverlay( widget_screen_t* screen, const widget_rect_t* rect )
+{
+  assert( screen );
+
+  /* Pixels under closed or moved overlay belong to widgets again */
+  if ( screen->overlay && ( rect == NULL || memcmp( rect, &screen->overlay_rect, sizeof( *rect ) ) != 0 ) )
+  {
+    widgetScreenInvalidateRect( screen, &screen->overlay_rect );
+  }
+
+  screen->overlay = rect != NULL;
+  if ( rect != NULL )
+  {
+    screen->overlay_rect = *rect;
+  }
+}
+
+void widgetScreenRender( widget_screen_t* screen )
+{
+  assert( screen );
+  int64_t start = esp_timer_get_time();
+
+  for ( uint8_t i = 0; i < screen->count; i++ )
+  {
+    widget_t* widget = screen->widgets[i];
+
+    /* Covered widget stays dirty until overlay closes */
+    if ( !widget->dirty || ( screen->overlay && _intersects( widget, &screen->overlay_rect ) ) )
+    {
+      continue;
+    }
+
+    ssdFigureFillRect( widget->x, widget->y, widget->width, widget->height, false );
+    _draw( widget );
+    widget->dirty = false;
+    screen->stats.redraws++;
+  }
+
+  screen->stats.frames++;
+  screen->stats.last_render_us = (uint32_t) ( esp_timer_get_time() - start );
+  if ( screen->stats.last_render_us > screen->stats.max_render_us )
+  {
+    screen->stats.max_render_us = screen->stats.last_render_us;
+  }
+}
+
+void widgetScreenGetStats( widget_screen_t* screen, widget_stats_t* stats )
+{
+  assert( screen );
+  assert( stats );
+  *stats = screen->stats;
+}
@@ -0,0 +1,123 @@
+#ifndef WIDGET_H_
+#define WIDGET_H_
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "dictionary.h"
+#include "ssdFigure.h"
+
+#define WIDGET_TEXT_SIZE     64
+#define WIDGET_LIST_MAX_ROWS 8
+
+typedef enum
+{
+  WIDGET_LABEL,
+  WIDGET_VALUE,
+  WIDGET_LOAD_BAR,
+  WIDGET_ICON,
+  WIDGET_LIST,
+} widget_type_t;
+
+typedef void ( *widget_format_cb )( int32_t value, char* buff, size_t size );
+typedef void ( *widget_draw_cb )( uint8_t x, uint8_t y, uint32_t state );
+typedef uint32_t ( *widget_row_key_cb )( uint16_t row );
+typedef void ( *widget_row_format_cb )( uint16_t row, char* buff, size_t size );
+
+typedef struct
+{
+  char text[WIDGET_TEXT_SIZE];
+  const char* bound_text;
+  uint8_t font;
+  bool inverted;
+} widget_label_t;
+
+typedef struct
+{
+  int32_t value;
+  bool valid;
+  widget_format_cb format;
+  char text[WIDGET_TEXT_SIZE];
+  uint8_t font;
+} widget_value_t;
+
+typedef struct
+{
+  uint32_t state;
+  bool valid;
+  widget_draw_cb draw;
+} widget_icon_t;
+
+typedef struct
+{
+  uint16_t count;
+  uint16_t start;
+  uint16_t position;
+  uint8_t line_height;
+  uint8_t font;
+  widget_row_key_cb row_key;
+  widget_row_format_cb row_format;
+  uint32_t keys[WIDGET_LIST_MAX_ROWS];
+  char rows[WIDGET_LIST_MAX_ROWS][WIDGET_TEXT_SIZE];
+  scrollBar_t scroll_bar;
+} widget_list_t;
+
+typedef struct
+{
+  uint8_t x;
+  uint8_t y;
+  uint8_t width;
+  uint8_t height;
+} widget_rect_t;
+
+typedef struct
+{
+  widget_type_t type;
+  uint8_t x;
+  uint8_t y;
+  uint8_t width;
+  uint8_t height;
+  bool dirty;
+  union
+  {
+    widget_label_t label;
+    widget_value_t value;
+    loadBar_t load_bar;
+    widget_icon_t icon;
+    widget_list_t list;
+  };
+} widget_t;
+
+typedef struct
+{
+  uint32_t frames;
+  uint32_t redraws;
+  uint32_t last_render_us;
+  uint32_t max_render_us;
+} widget_stats_t;
+
+typedef struct
+{
+  widget_t** widgets;
+  uint8_t count;
+  bool overlay;
+  widget_rect_t overlay_rect;
+  widget_stats_t stats;
+} widget_screen_t;
+
+void widgetLabelSetText( widget_t* widget, const char* text );
+void widgetLabelSetPhrase( widget_t* widget, enum dictionary_phrase phrase );
+void widgetLabelSetInverted( widget_t* widget, bool inverted );
+void widgetValueSet( widget_t* widget, int32_t value );
+void widgetLoadBarSet( widget_t* widget, uint8_t fill );
+void widgetIconSet( widget_t* widget, uint32_t state );
+void widgetListSet( widget_t* widget, uint16_t count, uint16_t start, uint16_t position );
+void widgetInvalidate( widget_t* widget );
+
+void widgetScreenInvalidate( widget_screen_t* screen );
+void widgetScreenInvalidateRect( widget_screen_t* screen, const widget_rect_t* rect );
+void widgetScreenSetOverlay( widget_screen_t* screen, const widget_rect_t* rect );
+void widgetScreenRender( widget_screen_t* screen );
+void widgetScreenGetStats( widget_screen_t* screen, widget_stats_t* stats );
+
+#endif
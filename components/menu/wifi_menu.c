@@ -2,6 +2,9 @@
 
 #include "app_config.h"
 #include "cmd_client.h"
+#include "controller_session.h"
+#include "deadline.h"
+#include "device_list.h"
 #include "dictionary.h"
 #include "menu_backend.h"
 #include "menu_default.h"
@@ -21,8 +24,6 @@
 #define LOG( PRINT_INFO, ... )
 #endif
 
-#define DEVICE_LIST_SIZE 32
-
 typedef enum
 {
   ST_WIFI_INIT,
@@ -40,10 +41,9 @@ typedef enum
 typedef struct
 {
   stateWifiMenu_t state;
-  uint16_t ap_count;
   uint16_t devices_count;
-  uint32_t timeout_con;
-  char devices_list[DEVICE_LIST_SIZE][33];
+  deadline_t timeout_con;
+  char selected[DEVICE_LIST_NAME_SIZE];
   bool connect_req;
   bool exit_req;
   bool scan_req;
@@ -79,6 +79,16 @@ static void change_state( stateWifiMenu_t new_state )
   LOG( PRINT_INFO, "WiFi menu %s", state_name[new_state] );
 }
 
+static void _store_selected_device( menu_token_t* menu )
+{
+  device_list_entry_t entry;
+
+  if ( deviceListGetEntry( menu->position, &entry ) )
+  {
+    strncpy( ctx.selected, entry.name, sizeof( ctx.selected ) );
+  }
+}
+
 static void menu_button_up_callback( void* arg )
 {
   menu_token_t* menu = arg;
@@ -99,6 +109,8 @@ static void menu_button_up_callback( void* arg )
   {
     menu->position--;
   }
+
+  _store_selected_device( menu );
 }
 
 static void menu_button_down_callback( void* arg )
@@ -121,6 +133,8 @@ static void menu_button_down_callback( void* arg )
   {
     menu->position++;
   }
+
+  _store_selected_device( menu );
 }
 
 static void menu_button_enter_callback( void* arg )
@@ -192,6 +206,8 @@ static bool menu_enter_cb( void* arg )
   }
 
   ctx.scan_req = true;
+  controllerSessionPublishToDeviceList();
+  deviceListStartScanning();
   return true;
 }
 
@@ -205,24 +221,13 @@ static bool menu_exit_cb( void* arg )
     return false;
   }
 
+  deviceListStopScanning();
   return true;
 }
 
 static void _set_dev_type( const char* dev )
 {
-  dev_type = 0xFF;
-  if ( memcmp( WIFI_SIEWNIK_NAME, dev, strlen( WIFI_SIEWNIK_NAME ) - 1 ) == 0 )
-  {
-    dev_type = T_DEV_TYPE_SIEWNIK;
-  }
-  else if ( memcmp( WIFI_SOLARKA_NAME, dev, strlen( WIFI_SOLARKA_NAME ) - 1 ) == 0 )
-  {
-    dev_type = T_DEV_TYPE_SOLARKA;
-  }
-  else if ( memcmp( WIFI_VALVE_NAME, dev, strlen( WIFI_VALVE_NAME ) - 1 ) == 0 )
-  {
-    dev_type = T_DEV_TYPE_VALVE;
-  }
+  dev_type = deviceListGetDevType( dev );
 }
 
 static bool connectToDevice( char* dev )
@@ -232,7 +237,7 @@ static bool connectToDevice( char* dev )
   /* Check device type */
   _set_dev_type( dev );
 
-  if ( dev_type != 0xFF )
+  if ( dev_type != DEVICE_LIST_UNKNOWN_DEV )
   {
     /* Disconnect if connected */
     if ( wifiDrvIsConnected() )
@@ -248,10 +253,11 @@ static bool connectToDevice( char* dev )
     wifiDrvSetPassword( WIFI_AP_PASSWORD, strlen( WIFI_AP_PASSWORD ) );
 
     /* Wait to wifi drv ready connect */
-    uint32_t wait_to_ready = MS2ST( 1000 ) + xTaskGetTickCount();
+    deadline_t wait_to_ready;
+    deadlineArm( &wait_to_ready, 1000 );
     do
     {
-      if ( wait_to_ready < xTaskGetTickCount() )
+      if ( deadlineExpired( &wait_to_ready ) )
       {
         ctx.error_msg = "Wifi drv not ready";
         return false;
@@ -301,54 +307,55 @@ static void menu_wifi_idle( void )
 
 static void menu_wifi_find_devices( void )
 {
-  static char dev_name[33] = { 0 };
-
-  bool result = wifiDrvStartScan();
-
-  if ( result )
-  {
-    ctx.devices_count = 0;
-    wifiDrvGetScanResult( &ctx.ap_count );
-    for ( uint16_t i = 0; i < ctx.ap_count; i++ )
-    {
-      if ( ctx.ap_count > DEVICE_LIST_SIZE )
-      {
-        break;
-      }
-
-      wifiDrvGetNameFromScannedList( i, dev_name );
-      if ( ( memcmp( WIFI_SIEWNIK_NAME, dev_name, strlen( WIFI_SIEWNIK_NAME ) - 1 ) == 0 )
-           || ( memcmp( WIFI_SOLARKA_NAME, dev_name, strlen( WIFI_SOLARKA_NAME ) - 1 ) == 0 )
-           || ( memcmp( WIFI_VALVE_NAME, dev_name, strlen( WIFI_VALVE_NAME ) - 1 ) == 0 ) )
-      {
-        LOG( PRINT_INFO, "%s\n", dev_name );
-        strncpy( ctx.devices_list[ctx.devices_count++], dev_name, 33 );
-      }
-    }
-
-    change_state( ST_WIFI_DEVICE_LIST );
-  }
-  else
+  /* Scanning runs in background, list is drawn from cache while it refreshes */
+  if ( deviceListScanFailed() && deviceListGetCount() == 0 )
   {
     change_state( ST_WIFI_ERROR_CHECK );
     ctx.error_flag = true;
     ctx.error_code = -1;
     ctx.error_msg = "WiFi Scan Error";
   }
+  else
+  {
+    deviceListStartScanning();
+    change_state( ST_WIFI_DEVICE_LIST );
+  }
 
   ctx.scan_req = false;
 }
 
+static void _keep_selected_device( menu_token_t* menu )
+{
+  /* List is re-sorted by RSSI on every scan, cursor follows the selected device */
+  int idx = ctx.selected[0] != 0 ? deviceListFind( ctx.selected ) : -1;
+
+  if ( idx >= 0 )
+  {
+    menu->position = idx;
+  }
+  else if ( menu->position >= ctx.devices_count )
+  {
+    menu->position = ctx.devices_count > 0 ? ctx.devices_count - 1 : 0;
+  }
+}
+
 static void menu_wifi_show_list( menu_token_t* menu )
 {
   static char buff[128];
+  device_list_entry_t entry;
 
+  ctx.devices_count = deviceListGetCount();
   if ( ctx.devices_count == 0 )
   {
     if ( ctx.scan_req )
+    {
+      ctx.scan_req = false;
+      deviceListRequestScan();
+    }
+
+    if ( deviceListIsScanning() )
     {
       oled_printFixed( 2, MENU_HEIGHT, dictionary_get_string( DICT_FIND_DEVICES ), OLED_FONT_SIZE_11 );
-      change_state( ST_WIFI_FIND_DEVICE );
       return;
     }
 
@@ -359,12 +366,16 @@ static void menu_wifi_show_list( menu_token_t* menu )
   if ( ctx.connect_req )
   {
     ctx.connect_req = false;
-    sprintf( buff, "%s\n%s", dictionary_get_string( DICT_TRY_CONNECT_TO ), ctx.devices_list[menu->position] );
+    _store_selected_device( menu );
+    deviceListStopScanning();
+    sprintf( buff, "%s\n%s", dictionary_get_string( DICT_TRY_CONNECT_TO ), ctx.selected );
     oled_printFixed( 2, MENU_HEIGHT, buff, OLED_FONT_SIZE_11 );
     change_state( ST_WIFI_DEVICE_TRY_CONNECT );
     return;
   }
 
+  _keep_selected_device( menu );
+
   if ( menu->line.end - menu->line.start != MAX_LINE - 1 )
   {
     menu->line.start = menu->position;
@@ -390,14 +401,19 @@ static void menu_wifi_show_list( menu_token_t* menu )
 
   do
   {
+    if ( !deviceListGetEntry( line + menu->line.start, &entry ) )
+    {
+      break;
+    }
+
     if ( line + menu->line.start == menu->position )
     {
       ssdFigureFillLine( MENU_HEIGHT + LINE_HEIGHT * line, LINE_HEIGHT );
-      oled_printFixedBlack( 2, MENU_HEIGHT + LINE_HEIGHT * line, &ctx.devices_list[line + menu->line.start][strlen( WIFI_SOLARKA_NAME ) + 1], OLED_FONT_SIZE_11 );
+      oled_printFixedBlack( 2, MENU_HEIGHT + LINE_HEIGHT * line, &entry.name[strlen( WIFI_SOLARKA_NAME ) + 1], OLED_FONT_SIZE_11 );
     }
     else
     {
-      oled_printFixed( 2, MENU_HEIGHT + LINE_HEIGHT * line, &ctx.devices_list[line + menu->line.start][strlen( WIFI_SOLARKA_NAME ) + 1], OLED_FONT_SIZE_11 );
+      oled_printFixed( 2, MENU_HEIGHT + LINE_HEIGHT * line, &entry.name[strlen( WIFI_SOLARKA_NAME ) + 1], OLED_FONT_SIZE_11 );
     }
 
     line++;
@@ -410,10 +426,10 @@ static void menu_wifi_show_list( menu_token_t* menu )
 
 static void menu_wifi_connect( menu_token_t* menu )
 {
-  if ( connectToDevice( ctx.devices_list[menu->position] ) )
+  if ( connectToDevice( ctx.selected ) )
   {
     oled_printFixed( 2, MENU_HEIGHT, dictionary_get_string( DICT_WAIT_TO_CONNECT ), OLED_FONT_SIZE_11 );
-    oled_printFixed( 2, MENU_HEIGHT + LINE_HEIGHT, ctx.devices_list[menu->position], OLED_FONT_SIZE_11 );
+    oled_printFixed( 2, MENU_HEIGHT + LINE_HEIGHT, ctx.selected, OLED_FONT_SIZE_11 );
     change_state( ST_WIFI_DEVICE_WAIT_CONNECT );
   }
   else
@@ -427,10 +443,10 @@ static void menu_wifi_connect( menu_token_t* menu )
 static void menu_wifi_wait_connect( void )
 {
   /* Wait to connect wifi */
-  ctx.timeout_con = MS2ST( 10000 ) + xTaskGetTickCount();
+  deadlineArm( &ctx.timeout_con, 10000 );
   do
   {
-    if ( ctx.timeout_con < xTaskGetTickCount() )
+    if ( deadlineExpired( &ctx.timeout_con ) )
     {
       ctx.error_msg = dictionary_get_string( DICT_TIMEOUT_CONNECT );
       ctx.error_flag = 1;
@@ -460,10 +476,10 @@ static void menu_wifi_wait_connect( void )
 static void menu_wifi_wait_cmd_client( void )
 {
   /* Wait to cmd server */
-  ctx.timeout_con = MS2ST( 10000 ) + xTaskGetTickCount();
+  deadlineArm( &ctx.timeout_con, 10000 );
   do
   {
-    if ( ctx.timeout_con < xTaskGetTickCount() )
+    if ( deadlineExpired( &ctx.timeout_con ) )
     {
       ctx.error_msg = dictionary_get_string( DICT_TIMEOUT_SERVER );
       ctx.error_flag = 1;
@@ -513,7 +529,7 @@ static void menu_wifi_error_check( void )
 static void menu_wifi_connected( menu_token_t* menu )
 {
   oled_printFixed( 2, MENU_HEIGHT, dictionary_get_string( DICT_CONNECTED_TO ), OLED_FONT_SIZE_11 );
-  oled_printFixed( 2, MENU_HEIGHT + LINE_HEIGHT, ctx.devices_list[menu->position], OLED_FONT_SIZE_11 );
+  oled_printFixed( 2, MENU_HEIGHT + LINE_HEIGHT, ctx.selected, OLED_FONT_SIZE_11 );
 
   if ( ctx.scan_req )
   {
@@ -599,6 +615,7 @@ static bool menu_process( void* arg )
 void menuInitWifiMenu( menu_token_t* menu )
 {
   memset( &ctx, 0, sizeof( ctx ) );
+  deviceListInit();
   menu->menu_cb.enter = menu_enter_cb;
   menu->menu_cb.button_init_cb = menu_button_init_cb;
   menu->menu_cb.exit = menu_exit_cb;
@@ -0,0 +1,287 @@
+#include "black_box.h"
+
+#include <assert.h>
+#include <string.h>
+
+#include "app_config.h"
+#include "esp_partition.h"
+#include "esp_rom_crc.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "nvs.h"
+#include "spi_flash_mmap.h"
+
+#define MODULE_NAME "[BlackBox] "
+#define DEBUG_LVL   PRINT_INFO
+
+#if CONFIG_DEBUG_SERVER_CONTROLLER
+#define LOG( _lvl, ... ) \
+  debug_printf( DEBUG_LVL, _lvl, MODULE_NAME __VA_ARGS__ )
+#else
+#define LOG( PRINT_INFO, ... )
+#endif
+
+#define BLACK_BOX_PARTITION     "black_box"
+#define BLACK_BOX_MAGIC         0x58424242
+#define BLACK_BOX_NVS_NAMESPACE "black_box"
+#define BLACK_BOX_NVS_KEY       "capture"
+/* Blob takes one 32 byte entry per 32 bytes plus index, keep room for parameter records */
+#define NVS_ENTRY_SIZE          32
+#define NVS_RESERVE_ENTRIES     64
+
+/* One capture in one flash sector, overwritten by next fault */
+_Static_assert( sizeof( black_box_header_t ) + sizeof( black_box_capture_t ) <= SPI_FLASH_SEC_SIZE,
+                "black box capture exceeds flash sector" );
+
+typedef enum
+{
+  BLACK_BOX_RECORDING,
+  BLACK_BOX_TRIGGERED,
+  BLACK_BOX_SAVING,
+} black_box_state_t;
+
+typedef struct
+{
+  black_box_record_t ring[BLACK_BOX_RECORDS];
+  uint16_t head;
+  uint16_t count;
+  black_box_record_t frame;
+  black_box_state_t state;
+  uint16_t post_left;
+  black_box_capture_t capture;
+  TaskHandle_t task;
+} black_box_ctx_t;
+
+static black_box_ctx_t ctx;
+static portMUX_TYPE black_box_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static uint16_t _duty_to_u16( float duty )
+{
+  if ( duty <= 0 )
+  {
+    return 0;
+  }
+
+  return duty >= 100.0 ? 10000 : (uint16_t) ( duty * 100 );
+}
+
+static const esp_partition_t* _partition( void )
+{
+  return esp_partition_find_first( ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, BLACK_BOX_PARTITION );
+}
+
+static esp_err_t _save_partition( const esp_partition_t* partition )
+{
+  black_box_header_t header;
+
+  blackBoxSealHeader( &ctx.capture, &header );
+  esp_err_t err = esp_partition_erase_range( partition, 0, SPI_FLASH_SEC_SIZE );
+
+  if ( err == ESP_OK )
+  {
+    err = esp_partition_write( partition, sizeof( header ), &ctx.capture, sizeof( ctx.capture ) );
+  }
+
+  if ( err == ESP_OK )
+  {
+    err = esp_partition_write( partition, 0, &header, sizeof( header ) );
+  }
+
+  return err;
+}
+
+/* Devices updated over the air keep old partition table without black box partition */
+static esp_err_t _save_nvs( void )
+{
+  nvs_stats_t stats;
+  size_t needed = sizeof( ctx.capture ) / NVS_ENTRY_SIZE + 2;
+
+  if ( nvs_get_stats( NULL, &stats ) != ESP_OK || stats.free_entries < needed + NVS_RESERVE_ENTRIES )
+  {
+    return ESP_ERR_NVS_NOT_ENOUGH_SPACE;
+  }
+
+  nvs_handle_t handle;
+  esp_err_t err = nvs_open( BLACK_BOX_NVS_NAMESPACE, NVS_READWRITE, &handle );
+
+  if ( err == ESP_OK )
+  {
+    err = nvs_set_blob( handle, BLACK_BOX_NVS_KEY, &ctx.capture, sizeof( ctx.capture ) );
+    nvs_commit( handle );
+    nvs_close( handle );
+  }
+
+  return err;
+}
+
+static void _black_box_task( void* arg )
+{
+  while ( 1 )
+  {
+    ulTaskNotifyTake( pdTRUE, portMAX_DELAY );
+
+    const esp_partition_t* partition = _partition();
+    esp_err_t err = partition != NULL ? _save_partition( partition ) : _save_nvs();
+
+    LOG( PRINT_INFO, "Capture reason %d saved %s", ctx.capture.reason, esp_err_to_name( err ) );
+
+    portENTER_CRITICAL( &black_box_lock );
+    ctx.state = BLACK_BOX_RECORDING;
+    portEXIT_CRITICAL( &black_box_lock );
+  }
+}
+
+void blackBoxInit( void )
+{
+  xTaskCreate( _black_box_task, "black_box", 3072, NULL, 1, &ctx.task );
+}
+
+void blackBoxSetPwm( float motor_duty, float servo_duty )
+{
+  uint16_t motor = _duty_to_u16( motor_duty );
+  uint16_t servo = _duty_to_u16( servo_duty );
+
+  portENTER_CRITICAL( &black_box_lock );
+  ctx.frame.motor_duty = motor;
+  ctx.frame.servo_duty = servo;
+  portEXIT_CRITICAL( &black_box_lock );
+}
+
+void blackBoxSetState( black_box_src_t src, uint8_t state )
+{
+  assert( src < BLACK_BOX_SRC_TOP );
+
+  portENTER_CRITICAL( &black_box_lock );
+  if ( ctx.frame.state[src] != state )
+  {
+    ctx.frame.state[src] = state;
+    ctx.frame.transitions++;
+  }
+  portEXIT_CRITICAL( &black_box_lock );
+}
+
+void blackBoxSample( const uint16_t* adc )
+{
+  assert( adc );
+  bool save = false;
+
+  portENTER_CRITICAL( &black_box_lock );
+
+  if ( ctx.state != BLACK_BOX_SAVING )
+  {
+    ctx.frame.time_ms = ST2MS( xTaskGetTickCount() );
+    memcpy( ctx.frame.adc, adc, sizeof( ctx.frame.adc ) );
+    ctx.ring[ctx.head] = ctx.frame;
+    ctx.head = ( ctx.head + 1 ) % BLACK_BOX_RECORDS;
+    ctx.count = ctx.count < BLACK_BOX_RECORDS ? ctx.count + 1 : BLACK_BOX_RECORDS;
+    ctx.frame.transitions = 0;
+
+    if ( ctx.state == BLACK_BOX_TRIGGERED && --ctx.post_left == 0 )
+    {
+      blackBoxFreeze( ctx.ring, ctx.head, ctx.count, &ctx.capture );
+      ctx.state = BLACK_BOX_SAVING;
+      save = true;
+    }
+  }
+
+  portEXIT_CRITICAL( &black_box_lock );
+
+  if ( save && ctx.task != NULL )
+  {
+    xTaskNotifyGive( ctx.task );
+  }
+}
+
+void blackBoxTrigger( uint16_t reason )
+{
+  portENTER_CRITICAL( &black_box_lock );
+
+  /* First fault wins, following ones are in its post trigger window */
+  if ( ctx.state == BLACK_BOX_RECORDING )
+  {
+    ctx.state = BLACK_BOX_TRIGGERED;
+    ctx.post_left = BLACK_BOX_POST_RECORDS;
+    ctx.capture.reason = reason;
+  }
+
+  portEXIT_CRITICAL( &black_box_lock );
+}
+
+bool blackBoxReadCapture( black_box_capture_t* capture )
+{
+  assert( capture );
+  const esp_partition_t* partition = _partition();
+
+  if ( partition != NULL )
+  {
+    black_box_header_t header;
+
+    return esp_partition_read( partition, 0, &header, sizeof( header ) ) == ESP_OK
+           && esp_partition_read( partition, sizeof( header ), capture, sizeof( *capture ) ) == ESP_OK
+           && blackBoxHeaderValid( &header, capture );
+  }
+
+  nvs_handle_t handle;
+
+  if ( nvs_open( BLACK_BOX_NVS_NAMESPACE, NVS_READONLY, &handle ) != ESP_OK )
+  {
+    return false;
+  }
+
+  size_t size = sizeof( *capture );
+  esp_err_t err = nvs_get_blob( handle, BLACK_BOX_NVS_KEY, capture, &size );
+
+  nvs_close( handle );
+
+  return err == ESP_OK && size == sizeof( *capture );
+}
+
+void blackBoxEraseCapture( void )
+{
+  const esp_partition_t* partition = _partition();
+
+  if ( partition != NULL )
+  {
+    esp_partition_erase_range( partition, 0, SPI_FLASH_SEC_SIZE );
+    return;
+  }
+
+  nvs_handle_t handle;
+
+  if ( nvs_open( BLACK_BOX_NVS_NAMESPACE, NVS_READWRITE, &handle ) == ESP_OK )
+  {
+    nvs_erase_key( handle, BLACK_BOX_NVS_KEY );
+    nvs_commit( handle );
+    nvs_close( handle );
+  }
+}
+
+void blackBoxFreeze( const black_box_record_t* ring, uint16_t head, uint16_t count, black_box_capture_t* capture )
+{
+  assert( ring );
+  assert( capture );
+  assert( head < BLACK_BOX_RECORDS && count <= BLACK_BOX_RECORDS );
+
+  uint16_t start = ( head + BLACK_BOX_RECORDS - count ) % BLACK_BOX_RECORDS;
+  uint16_t first = BLACK_BOX_RECORDS - start < count ? BLACK_BOX_RECORDS - start : count;
+
+  memcpy( &capture->records[0], &ring[start], first * sizeof( black_box_record_t ) );
+  memcpy( &capture->records[first], &ring[0], ( count - first ) * sizeof( black_box_record_t ) );
+  capture->count = count;
+  capture->trigger_idx = count > BLACK_BOX_POST_RECORDS ? count - BLACK_BOX_POST_RECORDS : 0;
+}
+
+void blackBoxSealHeader( const black_box_capture_t* capture, black_box_header_t* header )
+{
+  assert( capture );
+  assert( header );
+  header->magic = BLACK_BOX_MAGIC;
+  header->crc = esp_rom_crc32_le( 0, (const uint8_t*) capture, sizeof( *capture ) );
+}
+
+bool blackBoxHeaderValid( const black_box_header_t* header, const black_box_capture_t* capture )
+{
+  assert( header );
+  assert( capture );
+  return header->magic == BLACK_BOX_MAGIC && esp_rom_crc32_le( 0, (const uint8_t*) capture, sizeof( *capture ) ) == header->crc;
+}
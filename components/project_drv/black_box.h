@@ -0,0 +1,67 @@
+/**
+ *******************************************************************************
+ * @file    black_box.h
+ * @brief   Raw measurement and state recorder frozen to flash around machine error
+ *******************************************************************************
+ */
+
+#ifndef _BLACK_BOX_H
+#define _BLACK_BOX_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "measure.h"
+
+/* Records are taken once per measure cycle, 100 ms */
+#define BLACK_BOX_PRE_RECORDS  100
+#define BLACK_BOX_POST_RECORDS 30
+#define BLACK_BOX_RECORDS      ( BLACK_BOX_PRE_RECORDS + BLACK_BOX_POST_RECORDS )
+
+typedef enum
+{
+  BLACK_BOX_SRC_CONTROLLER,
+  BLACK_BOX_SRC_ERROR,
+  BLACK_BOX_SRC_TOP,
+} black_box_src_t;
+
+typedef struct
+{
+  uint32_t time_ms;
+  uint16_t adc[MEAS_CH_LAST];
+  uint16_t motor_duty;    // 0.01 %
+  uint16_t servo_duty;    // 0.01 %
+  uint8_t state[BLACK_BOX_SRC_TOP];
+  uint8_t transitions;
+} black_box_record_t;
+
+typedef struct
+{
+  uint16_t reason;
+  uint16_t count;
+  uint16_t trigger_idx;
+  black_box_record_t records[BLACK_BOX_RECORDS];
+} black_box_capture_t;
+
+/* Written last on flash, capture cut by power loss is not valid */
+typedef struct
+{
+  uint32_t magic;
+  uint32_t crc;
+} black_box_header_t;
+
+void blackBoxInit( void );
+void blackBoxSetPwm( float motor_duty, float servo_duty );
+void blackBoxSetState( black_box_src_t src, uint8_t state );
+void blackBoxSample( const uint16_t* adc );
+void blackBoxTrigger( uint16_t reason );
+bool blackBoxReadCapture( black_box_capture_t* capture );
+void blackBoxEraseCapture( void );
+
+/* Ring window copied oldest first, trigger_idx is the first record after the fault */
+void blackBoxFreeze( const black_box_record_t* ring, uint16_t head, uint16_t count, black_box_capture_t* capture );
+void blackBoxSealHeader( const black_box_capture_t* capture, black_box_header_t* header );
+bool blackBoxHeaderValid( const black_box_header_t* header, const black_box_capture_t* capture );
+
+#endif
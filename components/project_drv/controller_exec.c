@@ -0,0 +1,120 @@
+#include "controller_exec.h"
+
+#include "error_siewnik.h"
+#include "error_solarka.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "measure.h"
+#include "param_bridge.h"
+#include "server_controller.h"
+#include "vibro.h"
+
+#if CONFIG_CONTROLLER_EXECUTIVE
+#define MODULE_NAME "[Exec] "
+#define DEBUG_LVL   PRINT_INFO
+
+#if CONFIG_DEBUG_SERVER_CONTROLLER
+#define LOG( _lvl, ... ) \
+  debug_printf( DEBUG_LVL, _lvl, MODULE_NAME __VA_ARGS__ )
+#else
+#define LOG( PRINT_INFO, ... )
+#endif
+
+typedef struct
+{
+  uint32_t tick;
+  uint32_t max_latency_us;
+  uint32_t overruns;
+  uint32_t report_max_latency_us;
+  uint32_t report_overruns;
+} controller_exec_ctx_t;
+
+static controller_exec_ctx_t ctx;
+
+static void _report( void )
+{
+  LOG( PRINT_INFO, "latency max %ld us overruns %ld", ctx.max_latency_us, ctx.overruns );
+  ctx.report_max_latency_us = ctx.max_latency_us;
+  ctx.report_overruns = ctx.overruns;
+  ctx.max_latency_us = 0;
+  ctx.overruns = 0;
+}
+
+static void _fault_check( void )
+{
+#if CONFIG_DEVICE_SIEWNIK
+  errorSiewnikStep();
+#endif
+
+#if CONFIG_DEVICE_SOLARKA
+  errorSolarkaStep();
+#endif
+}
+
+/*
+ * Acquire -> fault check -> control -> actuate in one tick, faults and control
+ * see values measured in the same tick. Acquisition and fault check run on divided ticks.
+ */
+static const controller_exec_stage_fn_t stages[CONTROLLER_EXEC_STAGES] =
+  {
+    [CONTROLLER_EXEC_ACQUIRE] = measure_step,
+    [CONTROLLER_EXEC_FAULT] = _fault_check,
+    [CONTROLLER_EXEC_CONTROL] = srvrControllStep,
+#if CONFIG_DEVICE_SOLARKA
+    [CONTROLLER_EXEC_ACTUATE] = vibro_step,
+#endif
+};
+
+static void _cycle( void )
+{
+  int64_t start_us = esp_timer_get_time();
+  bool acquire = controllerExecRunTick( stages, ctx.tick );
+  uint32_t cycle_us = (uint32_t) ( esp_timer_get_time() - start_us );
+
+  if ( acquire && cycle_us > ctx.max_latency_us )
+  {
+    ctx.max_latency_us = cycle_us;
+  }
+
+  if ( cycle_us > CONTROLLER_EXEC_TICK_MS * 1000 )
+  {
+    ctx.overruns++;
+  }
+}
+
+static void _task( void* arg )
+{
+  TickType_t last_wake = xTaskGetTickCount();
+
+  paramBridgeRegisterProducer();
+
+  while ( 1 )
+  {
+    vTaskDelayUntil( &last_wake, MS2ST( CONTROLLER_EXEC_TICK_MS ) );
+    _cycle();
+
+    if ( ++ctx.tick % CONTROLLER_EXEC_REPORT_TICKS == 0 )
+    {
+      _report();
+    }
+  }
+}
+
+void controllerExecStart( void )
+{
+  xTaskCreatePinnedToCore( _task, "ctrl_exec", CONTROLLER_EXEC_STACK, NULL, CONTROLLER_EXEC_PRIO, NULL,
+                           TASK_CORE( CONTROL_CORE ) );
+}
+
+uint32_t controllerExecGetMaxLatencyUs( void )
+{
+  return ctx.report_max_latency_us;
+}
+
+uint32_t controllerExecGetOverruns( void )
+{
+  return ctx.report_overruns;
+}
+
+#endif
@@ -0,0 +1,68 @@
+/**
+ *******************************************************************************
+ * @file    controller_exec.h
+ * @brief   Single task pipeline for measurement, fault check, control and vibro
+ *******************************************************************************
+ */
+
+#ifndef _CONTROLLER_EXEC_H
+#define _CONTROLLER_EXEC_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "app_config.h"
+
+/* Pipeline stages in execution order */
+typedef enum
+{
+  CONTROLLER_EXEC_ACQUIRE,
+  CONTROLLER_EXEC_FAULT,
+  CONTROLLER_EXEC_CONTROL,
+  CONTROLLER_EXEC_ACTUATE,
+  CONTROLLER_EXEC_STAGES,
+} controller_exec_stage_t;
+
+typedef void ( *controller_exec_stage_fn_t )( void );
+
+/* Fault check runs on every acquisition, it must never see older values than control */
+static inline bool controllerExecStageDue( controller_exec_stage_t stage, uint32_t tick )
+{
+  switch ( stage )
+  {
+    case CONTROLLER_EXEC_ACQUIRE:
+    case CONTROLLER_EXEC_FAULT:
+      return tick % CONTROLLER_EXEC_MEASURE_DIV == 0;
+
+    default:
+      return true;
+  }
+}
+
+/* Runs stages due on tick in pipeline order, NULL stage is skipped. Returns true if tick acquired. */
+static inline bool controllerExecRunTick( const controller_exec_stage_fn_t stages[CONTROLLER_EXEC_STAGES], uint32_t tick )
+{
+  for ( int stage = 0; stage < CONTROLLER_EXEC_STAGES; stage++ )
+  {
+    if ( stages[stage] != NULL && controllerExecStageDue( stage, tick ) )
+    {
+      stages[stage]();
+    }
+  }
+
+  return controllerExecStageDue( CONTROLLER_EXEC_ACQUIRE, tick );
+}
+
+#if CONFIG_CONTROLLER_EXECUTIVE
+
+/* Modules must be started first, with executive enabled they do not create own tasks */
+void controllerExecStart( void );
+
+/* Worst time from start of acquisition to end of actuation since last report */
+uint32_t controllerExecGetMaxLatencyUs( void );
+uint32_t controllerExecGetOverruns( void );
+
+#endif
+
+#endif
@@ -2,18 +2,27 @@
 
 #include <stdint.h>
 
+#include "black_box.h"
 #include "cmd_server.h"
+#include "deadline.h"
 #include "math.h"
 #include "measure.h"
 #include "motor.h"
+#include "motor_calib.h"
+#include "param_access.h"
 #include "parameters.h"
 #include "server_controller.h"
 #include "servo.h"
+#include "task_profiler.h"
 
 #if CONFIG_DEVICE_SIEWNIK
 #define MODULE_NAME "[Err_siew] "
 #define DEBUG_LVL   PRINT_INFO
 
+/* Threshold over calibrated no load current, PARAM_CURRENT_MOTOR units */
+#define MOTOR_CURRENT_HEADROOM_PCT 200
+#define MOTOR_CURRENT_OFFSET       200
+
 #if CONFIG_DEBUG_ERROR_SIEWNIK
 #define LOG( _lvl, ... ) \
   debug_printf( DEBUG_LVL, _lvl, MODULE_NAME __VA_ARGS__ )
@@ -38,18 +47,18 @@ typedef enum
 struct error_siewnik_ctx
 {
   state_t state;
-  TickType_t motor_error_timer;
+  deadline_t motor_error_timer;
   bool motor_find_overcurrent;
 
-  TickType_t motor_not_connected_timer;
+  deadline_t motor_not_connected_timer;
   bool motor_find_not_connected;
 
-  TickType_t temperature_error_timer;
+  deadline_t temperature_error_timer;
   bool temperature_find_overcurrent;
 
-  TickType_t servo_blocking_error_timer;
-  TickType_t servo_error_reset_timer;
-  TickType_t servo_overcurrent_timer;
+  deadline_t servo_blocking_error_timer;
+  deadline_t servo_error_reset_timer;
+  deadline_t servo_overcurrent_timer;
   bool servo_find_overcurrent;
   uint8_t servo_try_counter;
 
@@ -78,6 +87,7 @@ static void _change_state( state_t new_state )
     if ( ctx.state != new_state )
     {
       LOG( PRINT_INFO, "state %s", state_name[new_state] );
+      blackBoxSetState( BLACK_BOX_SRC_ERROR, new_state );
     }
 
     ctx.state = new_state;
@@ -87,32 +97,51 @@ static void _change_state( state_t new_state )
 static void _reset_error( void )
 {
   ctx.is_error_reset = false;
-  ctx.motor_error_timer = 0;
+  deadlineDisarm( &ctx.motor_error_timer );
   ctx.motor_find_overcurrent = false;
   ctx.servo_find_overcurrent = false;
-  ctx.servo_blocking_error_timer = MS2ST( 2000 ) + xTaskGetTickCount();
+  deadlineArm( &ctx.servo_blocking_error_timer, 2000 );
   ctx.servo_try_counter = 0;
 }
 
+static bool _motor_current_table( uint16_t table[MOTOR_CALIB_POINTS] )
+{
+  table[0] = PARAM_MOTOR_CURRENT_20_get();
+  table[1] = PARAM_MOTOR_CURRENT_40_get();
+  table[2] = PARAM_MOTOR_CURRENT_60_get();
+  table[3] = PARAM_MOTOR_CURRENT_80_get();
+  table[4] = PARAM_MOTOR_CURRENT_100_get();
+  return motorCalibTableIsValid( table );
+}
+
 static bool _is_overcurrent( float motor_current )
 {
-  float max_current = 0.1 * parameters_getValue( PARAM_MOTOR ) + 2;
-  float calibration = ( (float) parameters_getValue( PARAM_ERROR_MOTOR_CALIBRATION ) - 50.0 ) * (float) parameters_getValue( PARAM_MOTOR ) / 500.0;
+  /* Duty actually driven, differs from PARAM_MOTOR during calibration sweep */
+  uint8_t duty = srvrControllGetMotorValue();
+  uint16_t table[MOTOR_CALIB_POINTS];
+  float max_current = 0.1 * duty + 2;
+
+  if ( _motor_current_table( table ) )
+  {
+    max_current = (float) motorCalibThreshold( table, duty, MOTOR_CURRENT_HEADROOM_PCT, MOTOR_CURRENT_OFFSET ) / 100;
+  }
+
+  float calibration = ( (float) PARAM_ERROR_MOTOR_CALIBRATION_get() - 50.0 ) * (float) duty / 500.0;
   float overcurrent = max_current + calibration;
 
-  LOG( PRINT_DEBUG, "Motor current %.2f overcurrent %.2f calib_val %d calib %.2f", motor_current, overcurrent, parameters_getValue( PARAM_ERROR_MOTOR_CALIBRATION ), calibration );
+  LOG( PRINT_DEBUG, "Motor current %.2f overcurrent %.2f calib_val %d calib %.2f", motor_current, overcurrent, PARAM_ERROR_MOTOR_CALIBRATION_get(), calibration );
 
   return motor_current > overcurrent;
 }
 
 static bool _is_servo_overcurrent( float servo_voltage )
 {
-  if ( ctx.servo_blocking_error_timer < xTaskGetTickCount() )
+  if ( deadlineExpired( &ctx.servo_blocking_error_timer ) )
   {
-    float calibration = ( (float) parameters_getValue( PARAM_ERROR_SERVO_CALIBRATION ) - 50.0 ) * 10;
+    float calibration = ( (float) PARAM_ERROR_SERVO_CALIBRATION_get() - 50.0 ) * 10;
     float overvoltage_mv = 500;
 
-    LOG( PRINT_DEBUG, "Servo current %.2f overcurrent %.2f calib_val %d calib %.2f", servo_voltage, overvoltage_mv, parameters_getValue( PARAM_ERROR_SERVO_CALIBRATION ), calibration );
+    LOG( PRINT_DEBUG, "Servo current %.2f overcurrent %.2f calib_val %d calib %.2f", servo_voltage, overvoltage_mv, PARAM_ERROR_SERVO_CALIBRATION_get(), calibration );
 
     return servo_voltage > overvoltage_mv;
   }
@@ -127,7 +156,7 @@ static void _state_init( void )
 static void _state_idle( void )
 {
   ctx.motor_find_overcurrent = false;
-  if ( parameters_getValue( PARAM_START_SYSTEM ) )
+  if ( PARAM_START_SYSTEM_get() )
   {
     _change_state( STATE_WORKING );
   }
@@ -135,33 +164,33 @@ static void _state_idle( void )
 
 static void _state_working( void )
 {
-  if ( parameters_getValue( PARAM_START_SYSTEM ) == 0 )
+  if ( !PARAM_START_SYSTEM_get() )
   {
     _change_state( STATE_IDLE );
   }
 
   /* Motor error overcurrent */
 
-  LOG( PRINT_DEBUG, "Error motor %d, servo %d", parameters_getValue( PARAM_ERROR_MOTOR ), parameters_getValue( PARAM_ERROR_SERVO ) );
+  LOG( PRINT_DEBUG, "Error motor %d, servo %d", PARAM_ERROR_MOTOR_get(), PARAM_ERROR_SERVO_get() );
 
-  float motor_current = (float) parameters_getValue( PARAM_CURRENT_MOTOR ) / 100;
+  float motor_current = (float) PARAM_CURRENT_MOTOR_get() / 100;
 
   if ( motor_current > 45 )
   {
     _change_state( STATE_ERROR_MOTOR_CURRENT );
   }
 
-  if ( _is_overcurrent( motor_current ) && parameters_getValue( PARAM_ERROR_MOTOR ) )
+  if ( _is_overcurrent( motor_current ) && PARAM_ERROR_MOTOR_get() )
   {
     if ( !ctx.motor_find_overcurrent )
     {
       LOG( PRINT_INFO, "find motor overcurrent" );
       ctx.motor_find_overcurrent = true;
-      ctx.motor_error_timer = MS2ST( 2500 ) + xTaskGetTickCount();
+      deadlineArm( &ctx.motor_error_timer, 2500 );
     }
     else
     {
-      if ( ctx.motor_error_timer < xTaskGetTickCount() )
+      if ( deadlineExpired( &ctx.motor_error_timer ) )
       {
         _change_state( STATE_ERROR_MOTOR_CURRENT );
       }
@@ -177,24 +206,24 @@ static void _state_working( void )
     ctx.motor_find_overcurrent = false;
   }
 
-  float servo_voltage = (float) parameters_getValue( PARAM_VOLTAGE_SERVO );
+  float servo_voltage = (float) PARAM_VOLTAGE_SERVO_get();
 
-  if ( _is_servo_overcurrent( servo_voltage ) && parameters_getValue( PARAM_ERROR_SERVO ) )
+  if ( _is_servo_overcurrent( servo_voltage ) && PARAM_ERROR_SERVO_get() )
   {
     if ( !ctx.servo_find_overcurrent )
     {
       LOG( PRINT_INFO, "find servo overcurrent" );
       ctx.servo_find_overcurrent = true;
-      ctx.servo_overcurrent_timer = xTaskGetTickCount() + MS2ST( 1000 );
+      deadlineArm( &ctx.servo_overcurrent_timer, 1000 );
     }
     else
     {
-      if ( ctx.servo_overcurrent_timer < xTaskGetTickCount() )
+      if ( deadlineExpired( &ctx.servo_overcurrent_timer ) )
       {
         if ( ctx.servo_try_counter < 3 )
         {
-          ctx.servo_blocking_error_timer = MS2ST( 2000 ) + xTaskGetTickCount();
-          ctx.servo_error_reset_timer = xTaskGetTickCount() + MS2ST( 20000 );
+          deadlineArm( &ctx.servo_blocking_error_timer, 2000 );
+          deadlineArm( &ctx.servo_error_reset_timer, 20000 );
           ctx.servo_try_counter++;
           /* Send to servo try information */
           servo_enable_try();
@@ -209,7 +238,7 @@ static void _state_working( void )
   }
   else
   {
-    if ( ctx.servo_error_reset_timer < xTaskGetTickCount() )
+    if ( deadlineExpired( &ctx.servo_error_reset_timer ) )
     {
       LOG( PRINT_DEBUG, "reset servo counter" );
       ctx.servo_try_counter = 0;
@@ -222,19 +251,19 @@ static void _state_working( void )
     ctx.servo_find_overcurrent = false;
   }
 
-  uint32_t temperature = parameters_getValue( PARAM_TEMPERATURE );
+  uint32_t temperature = PARAM_TEMPERATURE_get();
   LOG( PRINT_DEBUG, "Temperature %d", temperature );
-  if ( temperature > 90 && parameters_getValue( PARAM_ERROR_MOTOR ) )
+  if ( temperature > 90 && PARAM_ERROR_MOTOR_get() )
   {
     if ( !ctx.temperature_find_overcurrent )
     {
       LOG( PRINT_DEBUG, "find temperature" );
       ctx.temperature_find_overcurrent = true;
-      ctx.temperature_error_timer = MS2ST( 1500 ) + xTaskGetTickCount();
+      deadlineArm( &ctx.temperature_error_timer, 1500 );
     }
     else
     {
-      if ( ctx.temperature_error_timer < xTaskGetTickCount() )
+      if ( deadlineExpired( &ctx.temperature_error_timer ) )
       {
         _change_state( STATE_ERROR_TEMPERATURE );
       }
@@ -341,57 +370,67 @@ static void _state_wait_reset_error( void )
   }
 }
 
-static void _error_task( void* arg )
+void errorSiewnikStep( void )
 {
-  // static uint32_t error_event_timer;
-  while ( 1 )
+  taskProfilerLoop( TASK_PROFILER_LOOP_ERROR );
+
+  switch ( ctx.state )
   {
-    switch ( ctx.state )
-    {
-      case STATE_INIT:
-        _state_init();
-        break;
+    case STATE_INIT:
+      _state_init();
+      break;
 
-      case STATE_IDLE:
-        _state_idle();
-        break;
+    case STATE_IDLE:
+      _state_idle();
+      break;
 
-      case STATE_WORKING:
-        _state_working();
-        break;
+    case STATE_WORKING:
+      _state_working();
+      break;
 
-      case STATE_ERROR_TEMPERATURE:
-        _state_error_temperature();
-        break;
+    case STATE_ERROR_TEMPERATURE:
+      _state_error_temperature();
+      break;
 
-      case STATE_ERROR_MOTOR_CURRENT:
-        _state_error_motor_current();
-        break;
+    case STATE_ERROR_MOTOR_CURRENT:
+      _state_error_motor_current();
+      break;
 
-      case STATE_ERROR_MOTOR_NOT_CONNECTED:
-        _state_error_motor_not_connected();
-        break;
+    case STATE_ERROR_MOTOR_NOT_CONNECTED:
+      _state_error_motor_not_connected();
+      break;
 
-      case STATE_ERROR_SERVO:
-        _state_error_servo();
-        break;
+    case STATE_ERROR_SERVO:
+      _state_error_servo();
+      break;
 
-      case STATE_WAIT_RESET_ERROR:
-        _state_wait_reset_error();
-        break;
+    case STATE_WAIT_RESET_ERROR:
+      _state_wait_reset_error();
+      break;
 
-      default:
-        ctx.state = STATE_INIT;
-        break;
-    }
+    default:
+      ctx.state = STATE_INIT;
+      break;
+  }
+}
 
+#if !CONFIG_CONTROLLER_EXECUTIVE
+static void _error_task( void* arg )
+{
+  while ( 1 )
+  {
+    errorSiewnikStep();
     vTaskDelay( MS2ST( 200 ) );
-  }    // error_event_timer
+  }
 }
+#endif
 
 void errorSiewnikStart( void )
 {
-  xTaskCreate( _error_task, "_error_task", 4096, NULL, NORMALPRIO, NULL );
+#if !CONFIG_CONTROLLER_EXECUTIVE
+  xTaskCreatePinnedToCore( _error_task, "_error_task", ERROR_TASK_STACK, NULL, ERROR_TASK_PRIO, NULL,
+                           TASK_CORE( CONTROL_CORE ) );
+#endif
 }
 
 void errorSiewnikErrorReset( void )
@@ -401,8 +440,8 @@ void errorSiewnikErrorReset( void )
 
 void errorSiewnikServoChangeState( void )
 {
-  ctx.servo_blocking_error_timer = MS2ST( 2000 ) + xTaskGetTickCount();
-  ctx.servo_error_reset_timer = xTaskGetTickCount() + MS2ST( 20000 );
+  deadlineArm( &ctx.servo_blocking_error_timer, 2000 );
+  deadlineArm( &ctx.servo_error_reset_timer, 20000 );
   ctx.servo_try_counter = 0;
 }
 
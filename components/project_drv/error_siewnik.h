@@ -51,6 +51,8 @@ void error_led_blink( void );
 void error_servo_timer( void );
 
 void errorSiewnikStart( void );
+/* One fault check cycle, called by own task or by controller executive */
+void errorSiewnikStep( void );
 void errorSiewnikErrorReset( void );
 void errorSiewnikServoChangeState( void );
 
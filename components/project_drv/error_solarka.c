@@ -2,19 +2,28 @@
 
 #include <stdint.h>
 
+#include "black_box.h"
 #include "cmd_server.h"
+#include "deadline.h"
 #include "math.h"
 #include "measure.h"
 #include "motor.h"
+#include "motor_calib.h"
+#include "param_access.h"
 #include "parameters.h"
 #include "server_controller.h"
 #include "servo.h"
+#include "task_profiler.h"
 #include "vibro.h"
 
 #if CONFIG_DEVICE_SOLARKA
 #define MODULE_NAME "[Err_sola] "
 #define DEBUG_LVL   PRINT_INFO
 
+/* Threshold over calibrated no load current, PARAM_CURRENT_MOTOR units */
+#define MOTOR_CURRENT_HEADROOM_PCT 200
+#define MOTOR_CURRENT_OFFSET       6
+
 #if CONFIG_DEBUG_ERROR_SIEWNIK
 #define LOG( _lvl, ... ) \
   debug_printf( DEBUG_LVL, _lvl, MODULE_NAME __VA_ARGS__ )
@@ -39,17 +48,17 @@ typedef enum
 struct error_siewnik_ctx
 {
   state_t state;
-  TickType_t motor_error_timer;
+  deadline_t motor_error_timer;
   bool motor_find_overcurrent;
 
-  TickType_t vibro_error_timer;
+  deadline_t vibro_error_timer;
   bool vibro_find_overcurrent;
 
-  TickType_t temperature_error_timer;
+  deadline_t temperature_error_timer;
   bool temperature_find_overcurrent;
 
-  TickType_t motor_not_connected_timer;
-  TickType_t vibro_not_connected_timer;
+  deadline_t motor_not_connected_timer;
+  deadline_t vibro_not_connected_timer;
   bool motor_find_not_connected;
   bool vibro_find_not_connected;
 
@@ -78,6 +87,7 @@ static void _change_state( state_t new_state )
     if ( ctx.state != new_state )
     {
       LOG( PRINT_INFO, "state %s", state_name[new_state] );
+      blackBoxSetState( BLACK_BOX_SRC_ERROR, new_state );
     }
 
     ctx.state = new_state;
@@ -87,22 +97,41 @@ static void _change_state( state_t new_state )
 static void _reset_error( void )
 {
   ctx.is_error_reset = false;
-  ctx.motor_error_timer = 0;
+  deadlineDisarm( &ctx.motor_error_timer );
   ctx.motor_find_overcurrent = false;
-  ctx.vibro_error_timer = 0;
+  deadlineDisarm( &ctx.vibro_error_timer );
   ctx.vibro_find_overcurrent = false;
-  ctx.temperature_error_timer = 0;
+  deadlineDisarm( &ctx.temperature_error_timer );
   ctx.temperature_find_overcurrent = false;
 }
 
+static bool _motor_current_table( uint16_t table[MOTOR_CALIB_POINTS] )
+{
+  table[0] = PARAM_MOTOR_CURRENT_20_get();
+  table[1] = PARAM_MOTOR_CURRENT_40_get();
+  table[2] = PARAM_MOTOR_CURRENT_60_get();
+  table[3] = PARAM_MOTOR_CURRENT_80_get();
+  table[4] = PARAM_MOTOR_CURRENT_100_get();
+  return motorCalibTableIsValid( table );
+}
+
 static bool _is_overcurrent( void )
 {
-  float motor_current = (float) parameters_getValue( PARAM_CURRENT_MOTOR );
-  float max_current = 0.972 * parameters_getValue( PARAM_MOTOR ) + 6.458;
-  float calibration = ( (float) parameters_getValue( PARAM_ERROR_MOTOR_CALIBRATION ) - 50.0 ) * (float) parameters_getValue( PARAM_MOTOR ) / 100.0;
+  /* Duty actually driven, differs from PARAM_MOTOR during calibration sweep */
+  uint8_t duty = srvrControllGetMotorValue();
+  uint16_t table[MOTOR_CALIB_POINTS];
+  float motor_current = (float) PARAM_CURRENT_MOTOR_get();
+  float max_current = 0.972 * duty + 6.458;
+
+  if ( _motor_current_table( table ) )
+  {
+    max_current = (float) motorCalibThreshold( table, duty, MOTOR_CURRENT_HEADROOM_PCT, MOTOR_CURRENT_OFFSET );
+  }
+
+  float calibration = ( (float) PARAM_ERROR_MOTOR_CALIBRATION_get() - 50.0 ) * (float) duty / 100.0;
   float overcurrent = max_current + calibration;
 
-  LOG( PRINT_DEBUG, "Motor current %.2f overcurrent %.2f calib_val %d calib %.2f", motor_current, overcurrent, parameters_getValue( PARAM_ERROR_MOTOR_CALIBRATION ), calibration );
+  LOG( PRINT_DEBUG, "Motor current %.2f overcurrent %.2f calib_val %d calib %.2f", motor_current, overcurrent, PARAM_ERROR_MOTOR_CALIBRATION_get(), calibration );
 
   return motor_current > overcurrent;
 }
@@ -117,7 +146,7 @@ static void _state_idle( void )
   ctx.motor_find_overcurrent = false;
   ctx.vibro_find_overcurrent = false;
   ctx.temperature_find_overcurrent = false;
-  if ( parameters_getValue( PARAM_START_SYSTEM ) )
+  if ( PARAM_START_SYSTEM_get() )
   {
     _change_state( STATE_WORKING );
   }
@@ -125,31 +154,31 @@ static void _state_idle( void )
 
 static void _state_working( void )
 {
-  if ( parameters_getValue( PARAM_START_SYSTEM ) == 0 )
+  if ( !PARAM_START_SYSTEM_get() )
   {
     _change_state( STATE_IDLE );
   }
 
   /* Motor error overcurrent */
 
-  LOG( PRINT_DEBUG, "Error motor %d, servo %d", parameters_getValue( PARAM_ERROR_MOTOR ), parameters_getValue( PARAM_ERROR_SERVO ) );
+  LOG( PRINT_DEBUG, "Error motor %d, servo %d", PARAM_ERROR_MOTOR_get(), PARAM_ERROR_SERVO_get() );
 
-  if ( parameters_getValue( PARAM_CURRENT_MOTOR ) > 100 && parameters_getValue( PARAM_MOTOR_IS_ON ) /*&& parameters_getValue(PARAM_ERROR_MOTOR) */ )
+  if ( PARAM_CURRENT_MOTOR_get() > 100 && PARAM_MOTOR_IS_ON_get() /*&& parameters_getValue(PARAM_ERROR_MOTOR) */ )
   {
     _change_state( STATE_ERROR_MOTOR_CURRENT );
   }
 
-  if ( _is_overcurrent() && parameters_getValue( PARAM_ERROR_MOTOR ) && parameters_getValue( PARAM_MOTOR_IS_ON ) )
+  if ( _is_overcurrent() && PARAM_ERROR_MOTOR_get() && PARAM_MOTOR_IS_ON_get() )
   {
     if ( !ctx.motor_find_overcurrent )
     {
       LOG( PRINT_INFO, "find motor overcurrent" );
       ctx.motor_find_overcurrent = true;
-      ctx.motor_error_timer = MS2ST( 750 ) + xTaskGetTickCount();
+      deadlineArm( &ctx.motor_error_timer, 750 );
     }
     else
     {
-      if ( ctx.motor_error_timer < xTaskGetTickCount() )
+      if ( deadlineExpired( &ctx.motor_error_timer ) )
       {
         _change_state( STATE_ERROR_MOTOR_CURRENT );
       }
@@ -165,19 +194,19 @@ static void _state_working( void )
     ctx.motor_find_overcurrent = false;
   }
 
-  uint32_t temperature = parameters_getValue( PARAM_TEMPERATURE );
+  uint32_t temperature = PARAM_TEMPERATURE_get();
   LOG( PRINT_DEBUG, "Temperature %d", temperature );
-  if ( ( temperature > 80 && parameters_getValue( PARAM_ERROR_MOTOR ) ) || ( temperature > 90 ) )
+  if ( ( temperature > 80 && PARAM_ERROR_MOTOR_get() ) || ( temperature > 90 ) )
   {
     if ( !ctx.temperature_find_overcurrent )
     {
       LOG( PRINT_INFO, "find temperature" );
       ctx.temperature_find_overcurrent = true;
-      ctx.temperature_error_timer = MS2ST( 1500 ) + xTaskGetTickCount();
+      deadlineArm( &ctx.temperature_error_timer, 1500 );
     }
     else
     {
-      if ( ctx.temperature_error_timer < xTaskGetTickCount() )
+      if ( deadlineExpired( &ctx.temperature_error_timer ) )
       {
         _change_state( STATE_ERROR_TEMPERATURE );
       }
@@ -198,17 +227,17 @@ static void _state_working( void )
   uint32_t check_measure = 0;
   check_measure = measure_get_filtered_value( MEAS_CH_CHECK_VIBRO );
 
-  if ( check_measure > 1300 && parameters_getValue( PARAM_ERROR_SERVO ) && vibro_is_on() )
+  if ( check_measure > 1300 && PARAM_ERROR_SERVO_get() && vibro_is_on() )
   {
     if ( !ctx.vibro_find_overcurrent )
     {
       LOG( PRINT_INFO, "find vibro overcurrent" );
       ctx.vibro_find_overcurrent = true;
-      ctx.vibro_error_timer = MS2ST( 750 ) + xTaskGetTickCount();
+      deadlineArm( &ctx.vibro_error_timer, 750 );
     }
     else
     {
-      if ( ctx.vibro_error_timer < xTaskGetTickCount() )
+      if ( deadlineExpired( &ctx.vibro_error_timer ) )
       {
         _change_state( STATE_ERROR_VIBRO );
       }
@@ -227,17 +256,17 @@ static void _state_working( void )
   /* Motor error not connected */
   check_measure = measure_get_filtered_value( MEAS_CH_CHECK_MOTOR );
   LOG( PRINT_DEBUG, "Motor %d", check_measure );
-  if ( !parameters_getValue( PARAM_MOTOR_IS_ON ) && check_measure < 100 && srvrControllIsWorking() && parameters_getValue( PARAM_ERROR_MOTOR ) )
+  if ( !PARAM_MOTOR_IS_ON_get() && check_measure < 100 && srvrControllIsWorking() && PARAM_ERROR_MOTOR_get() )
   {
     if ( !ctx.motor_find_not_connected )
     {
       LOG( PRINT_INFO, "find motor not connected" );
       ctx.motor_find_not_connected = true;
-      ctx.motor_not_connected_timer = MS2ST( 1250 ) + xTaskGetTickCount();
+      deadlineArm( &ctx.motor_not_connected_timer, 1250 );
     }
     else
     {
-      if ( ctx.motor_not_connected_timer < xTaskGetTickCount() )
+      if ( deadlineExpired( &ctx.motor_not_connected_timer ) )
       {
         _change_state( STATE_ERROR_MOTOR_NOT_CONNECTED );
       }
@@ -256,17 +285,17 @@ static void _state_working( void )
   /* Vibro error not connected */
   check_measure = measure_get_filtered_value( MEAS_CH_CHECK_VIBRO );
   LOG( PRINT_DEBUG, "Vibro %d", check_measure );
-  if ( !vibro_is_on() && check_measure < 100 && srvrControllIsWorking() && parameters_getValue( PARAM_ERROR_SERVO ) )
+  if ( !vibro_is_on() && check_measure < 100 && srvrControllIsWorking() && PARAM_ERROR_SERVO_get() )
   {
     if ( !ctx.vibro_find_not_connected )
     {
       LOG( PRINT_INFO, "find vibro not connected" );
       ctx.vibro_find_not_connected = true;
-      ctx.vibro_not_connected_timer = MS2ST( 1250 ) + xTaskGetTickCount();
+      deadlineArm( &ctx.vibro_not_connected_timer, 1250 );
     }
     else
     {
-      if ( ctx.vibro_not_connected_timer < xTaskGetTickCount() )
+      if ( deadlineExpired( &ctx.vibro_not_connected_timer ) )
       {
         _change_state( STATE_ERROR_VIBRO_NOT_CONNECTED );
       }
@@ -358,61 +387,71 @@ static void _state_wait_reset_error( void )
   }
 }
 
-static void _error_task( void* arg )
+void errorSolarkaStep( void )
 {
-  //static uint32_t error_event_timer;
-  while ( 1 )
+  taskProfilerLoop( TASK_PROFILER_LOOP_ERROR );
+
+  switch ( ctx.state )
   {
-    switch ( ctx.state )
-    {
-      case STATE_INIT:
-        _state_init();
-        break;
+    case STATE_INIT:
+      _state_init();
+      break;
 
-      case STATE_IDLE:
-        _state_idle();
-        break;
+    case STATE_IDLE:
+      _state_idle();
+      break;
 
-      case STATE_WORKING:
-        _state_working();
-        break;
+    case STATE_WORKING:
+      _state_working();
+      break;
 
-      case STATE_ERROR_TEMPERATURE:
-        _state_error_temperature();
-        break;
+    case STATE_ERROR_TEMPERATURE:
+      _state_error_temperature();
+      break;
 
-      case STATE_ERROR_MOTOR_CURRENT:
-        _state_error_motor_current();
-        break;
+    case STATE_ERROR_MOTOR_CURRENT:
+      _state_error_motor_current();
+      break;
 
-      case STATE_ERROR_MOTOR_NOT_CONNECTED:
-        _state_error_motor_not_connected();
-        break;
+    case STATE_ERROR_MOTOR_NOT_CONNECTED:
+      _state_error_motor_not_connected();
+      break;
 
-      case STATE_ERROR_VIBRO_NOT_CONNECTED:
-        _state_error_vibro_not_connected();
-        break;
+    case STATE_ERROR_VIBRO_NOT_CONNECTED:
+      _state_error_vibro_not_connected();
+      break;
 
-      case STATE_ERROR_VIBRO:
-        _state_error_vibro();
-        break;
+    case STATE_ERROR_VIBRO:
+      _state_error_vibro();
+      break;
 
-      case STATE_WAIT_RESET_ERROR:
-        _state_wait_reset_error();
-        break;
+    case STATE_WAIT_RESET_ERROR:
+      _state_wait_reset_error();
+      break;
 
-      default:
-        ctx.state = STATE_INIT;
-        break;
-    }
+    default:
+      ctx.state = STATE_INIT;
+      break;
+  }
+}
 
+#if !CONFIG_CONTROLLER_EXECUTIVE
+static void _error_task( void* arg )
+{
+  while ( 1 )
+  {
+    errorSolarkaStep();
     vTaskDelay( MS2ST( 200 ) );
-  }    //error_event_timer
+  }
 }
+#endif
 
 void errorSolarkaStart( void )
 {
-  xTaskCreate( _error_task, "_error_task", 4096, NULL, NORMALPRIO, NULL );
+#if !CONFIG_CONTROLLER_EXECUTIVE
+  xTaskCreatePinnedToCore( _error_task, "_error_task", ERROR_TASK_STACK, NULL, ERROR_TASK_PRIO, NULL,
+                           TASK_CORE( CONTROL_CORE ) );
+#endif
 }
 
 void errorSolarkaErrorReset( void )
@@ -43,6 +43,8 @@ typedef enum
 } err_servo_t;
 
 void errorSolarkaStart( void );
+/* One fault check cycle, called by own task or by controller executive */
+void errorSolarkaStep( void );
 void errorSolarkaErrorReset( void );
 
 #endif    //#if CONFIG_DEVICE_SIEWNIK
@@ -0,0 +1,92 @@
+#include "history_export.h"
+
+#include <stdlib.h>
+
+#include "app_config.h"
+#include "esp_http_server.h"
+#include "measure_history.h"
+
+#define MODULE_NAME "[History] "
+#define DEBUG_LVL   PRINT_INFO
+
+#if CONFIG_DEBUG_MEASURE
+#define LOG( _lvl, ... ) \
+  debug_printf( DEBUG_LVL, _lvl, MODULE_NAME __VA_ARGS__ )
+#else
+#define LOG( PRINT_INFO, ... )
+#endif
+
+typedef struct
+{
+  httpd_handle_t server;
+  /* Handlers run one by one in server task */
+  uint8_t block[MEASURE_HISTORY_BLOCK_SIZE];
+} history_export_ctx_t;
+
+static history_export_ctx_t ctx;
+
+static uint32_t _cursor( httpd_req_t* req )
+{
+  char query[32];
+  char value[12];
+  uint32_t oldest;
+  uint32_t newest;
+
+  if ( httpd_req_get_url_query_str( req, query, sizeof( query ) ) == ESP_OK
+       && httpd_query_key_value( query, "from", value, sizeof( value ) ) == ESP_OK )
+  {
+    return strtoul( value, NULL, 10 );
+  }
+
+  measureHistoryGetSeqRange( &oldest, &newest );
+  return oldest;
+}
+
+static esp_err_t _history_get( httpd_req_t* req )
+{
+  uint32_t cursor = _cursor( req );
+  size_t len;
+
+  httpd_resp_set_type( req, "application/octet-stream" );
+
+  /* Block is copied under history lock, measurement is never held by slow client */
+  while ( ( len = measureHistoryExport( &cursor, ctx.block, sizeof( ctx.block ) ) ) > 0 )
+  {
+    if ( httpd_resp_send_chunk( req, (const char*) ctx.block, len ) != ESP_OK )
+    {
+      LOG( PRINT_WARNING, "Export aborted at %ld", cursor );
+      return ESP_FAIL;
+    }
+  }
+
+  return httpd_resp_send_chunk( req, NULL, 0 );
+}
+
+static const httpd_uri_t history_uri =
+  {
+    .uri = "/history",
+    .method = HTTP_GET,
+    .handler = _history_get,
+};
+
+void historyExportStart( void )
+{
+  httpd_config_t config = HTTPD_DEFAULT_CONFIG();
+
+  config.server_port = HISTORY_EXPORT_PORT;
+  config.ctrl_port = HISTORY_EXPORT_CTRL_PORT;
+  config.stack_size = HISTORY_EXPORT_STACK;
+  config.task_priority = HISTORY_EXPORT_PRIO;
+  config.core_id = TASK_CORE( NETWORK_CORE );
+  config.max_open_sockets = 2;
+  config.max_uri_handlers = 1;
+  config.lru_purge_enable = true;
+
+  if ( httpd_start( &ctx.server, &config ) != ESP_OK )
+  {
+    LOG( PRINT_ERROR, "Server start failed" );
+    return;
+  }
+
+  httpd_register_uri_handler( ctx.server, &history_uri );
+}
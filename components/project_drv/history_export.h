@@ -0,0 +1,18 @@
+/**
+ *******************************************************************************
+ * @file    history_export.h
+ * @brief   HTTP endpoint streaming measurement history blocks
+ *******************************************************************************
+ */
+
+#ifndef _HISTORY_EXPORT_H
+#define _HISTORY_EXPORT_H
+
+/*
+ * GET /history?from=<seq> on HISTORY_EXPORT_PORT streams completed blocks
+ * from measure_history in raw block layout. Without from all kept blocks are sent.
+ * Next request continues from seq of last received block + 1.
+ */
+void historyExportStart( void );
+
+#endif
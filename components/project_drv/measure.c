@@ -8,9 +8,15 @@
 #include "esp_adc/adc_cali_scheme.h"
 #include "esp_adc/adc_oneshot.h"
 #include "freertos/timers.h"
+#include "black_box.h"
 #include "measure.h"
+#include "measure_history.h"
+#include "param_bridge.h"
+#include "param_access.h"
 #include "parameters.h"
 #include "parse_cmd.h"
+#include "soc_estimator.h"
+#include "task_profiler.h"
 #include "ultrasonar.h"
 
 #define MODULE_NAME "[Meas] "
@@ -25,6 +31,8 @@
 
 static const adc_bitwidth_t width = ADC_BITWIDTH_12;
 static const adc_atten_t atten = ADC_ATTEN_DB_11;
+static adc_oneshot_unit_handle_t adc1_handle;
+static adc_oneshot_unit_handle_t adc2_handle;
 
 #define ADC_IN_CH    ADC_CHANNEL_6
 #define ADC_MOTOR_CH ADC_CHANNEL_7
@@ -42,6 +50,14 @@ static const adc_atten_t atten = ADC_ATTEN_DB_11;
 #define DEFAULT_MOTOR_CALIBRATION_VALUE 1830
 #define SILOS_START_MEASURE             100
 
+/* PARAM_VOLTAGE_ACCUM is in 10 mV, motor current unit differs per device */
+#define ACCUM_PARAM_TO_MV( _x ) ( ( _x ) * 10 )
+#if CONFIG_DEVICE_SOLARKA
+#define CURRENT_PARAM_TO_MA( _x ) ( ( _x ) * 100 )
+#else
+#define CURRENT_PARAM_TO_MA( _x ) ( ( _x ) * 10 )
+#endif
+
 typedef struct
 {
   char* ch_name;
@@ -73,6 +89,9 @@ static meas_data_t meas_data[MEAS_CH_LAST] =
 
 static uint32_t table_size;
 static uint32_t table_iter;
+static soc_estimator_t accum_soc;
+static uint32_t accum_capacity;
+static TickType_t accum_soc_timer;
 uint32_t motor_calibration_meas;
 // #if CONFIG_DEVICE_SOLARKA
 static TimerHandle_t motorCalibrationTimer;
@@ -150,11 +169,64 @@ static void _read_adc_values( adc_oneshot_unit_handle_t adc1_handle, adc_oneshot
   }
 }
 
-static void measure_process( void* arg )
+static void _accum_soc_process( uint32_t voltage_accum, uint32_t current_motor )
+{
+  TickType_t now = xTaskGetTickCount();
+
+  /* Wait for filter to fill, first estimate is taken from OCV */
+  if ( table_iter < FILTER_TABLE_SIZE )
+  {
+    accum_soc_timer = now;
+    return;
+  }
+
+  if ( accum_capacity != parameters_getValue( PARAM_ACCUM_CAPACITY ) )
+  {
+    accum_capacity = parameters_getValue( PARAM_ACCUM_CAPACITY );
+    socEstimatorInit( &accum_soc, &soc_config_accum, accum_capacity * 1000 );
+  }
+
+  socEstimatorUpdate( &accum_soc, ACCUM_PARAM_TO_MV( voltage_accum ), CURRENT_PARAM_TO_MA( current_motor ), ST2MS( now - accum_soc_timer ) );
+  accum_soc_timer = now;
+
+  PARAM_ACCUM_SOC_publish( socEstimatorGetSoc( &accum_soc ) );
+  PARAM_ACCUM_TIME_LEFT_publish( socEstimatorGetTimeLeftMin( &accum_soc ) );
+  LOG( PRINT_DEBUG, "Accum %ld mV %ld mA SoC %d", ACCUM_PARAM_TO_MV( voltage_accum ), CURRENT_PARAM_TO_MA( current_motor ), socEstimatorGetSoc( &accum_soc ) );
+}
+
+static void _black_box_sample( void )
+{
+  uint16_t adc[MEAS_CH_LAST];
+
+  for ( int i = 0; i < MEAS_CH_LAST; i++ )
+  {
+    adc[i] = (uint16_t) meas_data[i].adc;
+  }
+
+  blackBoxSample( adc );
+}
+
+static void _history_append( void )
+{
+  history_sample_t sample =
+    {
+      .time_ms = ST2MS( xTaskGetTickCount() ),
+      .values =
+        {
+          [HISTORY_CH_CURRENT_MOTOR] = PARAM_CURRENT_MOTOR_get(),
+          [HISTORY_CH_VOLTAGE_ACCUM] = PARAM_VOLTAGE_ACCUM_get(),
+          [HISTORY_CH_TEMPERATURE] = PARAM_TEMPERATURE_get(),
+          [HISTORY_CH_VOLTAGE_SERVO] = PARAM_VOLTAGE_SERVO_get(),
+          [HISTORY_CH_SILOS_LEVEL] = PARAM_SILOS_LEVEL_get(),
+        },
+    };
+
+  measureHistoryAppend( &sample );
+}
+
+static void _adc_init( void )
 {
-  (void) arg;
   //-------------ADC1 Init---------------//
-  adc_oneshot_unit_handle_t adc1_handle;
   adc_oneshot_unit_init_cfg_t init_config1 = {
     .unit_id = ADC_UNIT_1,
   };
@@ -175,7 +247,6 @@ static void measure_process( void* arg )
   }
 
   //-------------ADC2 Init---------------//
-  adc_oneshot_unit_handle_t adc2_handle;
   adc_oneshot_unit_init_cfg_t init_config2 = {
     .unit_id = ADC_UNIT_2,
     .ulp_mode = ADC_ULP_MODE_DISABLE,
@@ -190,57 +261,83 @@ static void measure_process( void* arg )
       ESP_ERROR_CHECK( adc_oneshot_config_channel( adc2_handle, meas_data[i].channel, &config ) );
     }
   }
+}
 
-  while ( 1 )
-  {
-    vTaskDelay( MS2ST( 100 ) );
+void measure_step( void )
+{
+  taskProfilerLoop( TASK_PROFILER_LOOP_MEASURE );
 
-    _read_adc_values( adc1_handle, adc2_handle );
+  _read_adc_values( adc1_handle, adc2_handle );
+  _black_box_sample();
 
-    // LOG(PRINT_INFO, "%s %d", meas_data[MEAS_CH_CHECK_VIBRO].ch_name, meas_data[MEAS_CH_CHECK_VIBRO].filtered_adc);
-    // LOG(PRINT_INFO, "%s %d", meas_data[MEAS_CH_CHECK_MOTOR].ch_name, meas_data[MEAS_CH_CHECK_MOTOR].filtered_adc);
+  // LOG(PRINT_INFO, "%s %d", meas_data[MEAS_CH_CHECK_VIBRO].ch_name, meas_data[MEAS_CH_CHECK_VIBRO].filtered_adc);
+  // LOG(PRINT_INFO, "%s %d", meas_data[MEAS_CH_CHECK_MOTOR].ch_name, meas_data[MEAS_CH_CHECK_MOTOR].filtered_adc);
 
-    if ( ultrasonar_is_connected() )
+  if ( ultrasonar_is_connected() )
+  {
+    uint32_t silos_height = parameters_getValue( PARAM_SILOS_HEIGHT ) * 10;
+    uint32_t silos_distance = ultrasonar_get_distance() > SILOS_START_MEASURE ? ultrasonar_get_distance() - SILOS_START_MEASURE : 0;
+    if ( silos_distance > silos_height )
     {
-      uint32_t silos_height = parameters_getValue( PARAM_SILOS_HEIGHT ) * 10;
-      uint32_t silos_distance = ultrasonar_get_distance() > SILOS_START_MEASURE ? ultrasonar_get_distance() - SILOS_START_MEASURE : 0;
-      if ( silos_distance > silos_height )
-      {
-        silos_distance = silos_height;
-      }
-
-      int silos_percent = ( silos_height - silos_distance ) * 100 / silos_height;
-      if ( ( silos_percent < 0 ) || ( silos_percent > 100 ) )
-      {
-        silos_percent = 0;
-      }
-      uint32_t silos_is_low = silos_percent < 10;
-      LOG( PRINT_INFO, "Silos %d %d", silos_percent, silos_is_low );
-      parameters_setValue( PARAM_LOW_LEVEL_SILOS, silos_is_low );
-      parameters_setValue( PARAM_SILOS_LEVEL, (uint32_t) silos_percent );
-      parameters_setValue( PARAM_SILOS_SENSOR_IS_CONNECTED, 1 );
+      silos_distance = silos_height;
     }
-    else
+
+    int silos_percent = ( silos_height - silos_distance ) * 100 / silos_height;
+    if ( ( silos_percent < 0 ) || ( silos_percent > 100 ) )
     {
-      parameters_setValue( PARAM_SILOS_SENSOR_IS_CONNECTED, 0 );
-      parameters_setValue( PARAM_LOW_LEVEL_SILOS, 0 );
-      parameters_setValue( PARAM_SILOS_LEVEL, 0 );
+      silos_percent = 0;
     }
+    uint32_t silos_is_low = silos_percent < 10;
+    LOG( PRINT_INFO, "Silos %d %d", silos_percent, silos_is_low );
+    PARAM_LOW_LEVEL_SILOS_set( silos_is_low );
+    PARAM_SILOS_LEVEL_set( (uint32_t) silos_percent );
+    PARAM_SILOS_SENSOR_IS_CONNECTED_set( 1 );
+  }
+  else
+  {
+    PARAM_SILOS_SENSOR_IS_CONNECTED_set( 0 );
+    PARAM_LOW_LEVEL_SILOS_set( 0 );
+    PARAM_SILOS_LEVEL_set( 0 );
+  }
 
-    parameters_setValue( PARAM_VOLTAGE_ACCUM, (uint32_t) ( accum_get_voltage() * 10000.0 ) );
-    parameters_setValue( PARAM_CURRENT_MOTOR, (uint32_t) ( measure_get_current( MEAS_CH_MOTOR, 0.1 ) ) );
-    parameters_setValue( PARAM_TEMPERATURE, (uint32_t) ( measure_get_temperature() ) );
-    parameters_setValue( PARAM_VOLTAGE_SERVO, (uint32_t) ( measure_get_servo_voltage() * 1000.0 ) );
-    /* DEBUG */
-    // parameters_debugPrintValue(PARAM_VOLTAGE_ACCUM);
-    // parameters_debugPrintValue(PARAM_CURRENT_MOTOR);
-    // parameters_debugPrintValue(PARAM_TEMPERATURE);
+  uint32_t voltage_accum = (uint32_t) ( accum_get_voltage() * 10000.0 );
+  uint32_t current_motor = (uint32_t) ( measure_get_current( MEAS_CH_MOTOR, 0.1 ) );
+
+  PARAM_VOLTAGE_ACCUM_publish( voltage_accum );
+  PARAM_CURRENT_MOTOR_publish( current_motor );
+  _accum_soc_process( voltage_accum, current_motor );
+  PARAM_TEMPERATURE_publish( (uint32_t) ( measure_get_temperature() ) );
+  PARAM_VOLTAGE_SERVO_publish( (uint32_t) ( measure_get_servo_voltage() * 1000.0 ) );
+  _history_append();
+  /* DEBUG */
+  // parameters_debugPrintValue(PARAM_VOLTAGE_ACCUM);
+  // parameters_debugPrintValue(PARAM_CURRENT_MOTOR);
+  // parameters_debugPrintValue(PARAM_TEMPERATURE);
+}
+
+#if !CONFIG_CONTROLLER_EXECUTIVE
+static void measure_process( void* arg )
+{
+  (void) arg;
+
+  paramBridgeRegisterProducer();
+
+  while ( 1 )
+  {
+    vTaskDelay( MS2ST( 100 ) );
+    measure_step();
   }
 }
+#endif
 
 void measure_start( void )
 {
-  xTaskCreate( measure_process, "measure_process", 4096, NULL, 10, NULL );
+  measureHistoryInit();
+  _adc_init();
+#if !CONFIG_CONTROLLER_EXECUTIVE
+  xTaskCreatePinnedToCore( measure_process, "measure_process", MEASURE_TASK_STACK, NULL, MEASURE_TASK_PRIO, NULL,
+                           TASK_CORE( CONTROL_CORE ) );
+#endif
 #if CONFIG_DEVICE_SIEWNIK
   servoCalibrationTimer = xTimerCreate( "servoCalibrationTimer", MS2ST( 1000 ), pdFALSE, (void*) 0,
                                         measure_get_servo_calibration );
@@ -383,7 +480,7 @@ float measure_get_current( enum_meas_ch type, float resistor )
   LOG( PRINT_DEBUG, "Adc %d calib %d", measure_get_filtered_value( type ), motor_calibration_meas );
   uint32_t adc = measure_get_filtered_value( type ) < motor_calibration_meas ? 0 : measure_get_filtered_value( type ) - motor_calibration_meas;
 
-  float voltage = parameters_getValue( PARAM_VOLTAGE_ACCUM ) / 100.0;
+  float voltage = PARAM_VOLTAGE_ACCUM_get() / 100.0;
   float correction = ( 14.2 - voltage ) * 100;
   float current_meas = (float) adc * 0.92;
   float current = current_meas /* + correction*/ /* Amp */;
@@ -394,6 +491,16 @@ float measure_get_current( enum_meas_ch type, float resistor )
   return current;
 }
 
+bool measure_accum_soc_is_valid( void )
+{
+  return socEstimatorIsValid( &accum_soc );
+}
+
+uint8_t measure_get_accum_soc( void )
+{
+  return socEstimatorGetSoc( &accum_soc );
+}
+
 float accum_get_voltage( void )
 {
   float voltage = 0;
@@ -1,6 +1,8 @@
 #ifndef _MEASURE_H
 #define _MEASURE_H
 
+#include <stdbool.h>
+
 #include "app_config.h"
 
 #define FILTER_TABLE_SIZE   8
@@ -37,10 +39,14 @@ typedef enum
 
 void init_measure( void );
 void measure_start( void );
+/* One acquisition cycle, called by own task or by controller executive */
+void measure_step( void );
 void measure_meas_calibration_value( void );
 uint32_t measure_get_filtered_value( enum_meas_ch type );
 float measure_get_current( enum_meas_ch type, float resistor );
 float accum_get_voltage( void );
+bool measure_accum_soc_is_valid( void );
+uint8_t measure_get_accum_soc( void );
 float measure_get_temperature( void );
 float measure_get_servo_voltage( void );
 
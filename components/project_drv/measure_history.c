@@ -0,0 +1,298 @@
+#include "measure_history.h"
+
+#include <assert.h>
+#include <string.h>
+
+#include "app_config.h"
+#include "freertos/FreeRTOS.h"
+
+#define VARINT_MAX_SIZE    5
+#define SAMPLE_MAX_SIZE    ( VARINT_MAX_SIZE * ( HISTORY_CH_TOP + 1 ) )
+#define PAYLOAD_SIZE       ( MEASURE_HISTORY_BLOCK_SIZE - MEASURE_HISTORY_HEADER_SIZE )
+#define HEADER_SEQ_OFF     0
+#define HEADER_TIME_OFF    4
+#define HEADER_LEN_OFF     8
+#define HEADER_COUNT_OFF   10
+
+typedef struct
+{
+  uint8_t blocks[MEASURE_HISTORY_BLOCK_COUNT][MEASURE_HISTORY_BLOCK_SIZE];
+  uint32_t seq;
+  uint32_t oldest_seq;
+  uint16_t len;
+  uint16_t count;
+  history_sample_t last;
+  bool started;
+} measure_history_ctx_t;
+
+static measure_history_ctx_t ctx;
+static portMUX_TYPE history_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static void _put_u32( uint8_t* p, uint32_t v )
+{
+  p[0] = v;
+  p[1] = v >> 8;
+  p[2] = v >> 16;
+  p[3] = v >> 24;
+}
+
+static void _put_u16( uint8_t* p, uint16_t v )
+{
+  p[0] = v;
+  p[1] = v >> 8;
+}
+
+static uint32_t _get_u32( const uint8_t* p )
+{
+  return p[0] | ( p[1] << 8 ) | ( p[2] << 16 ) | ( (uint32_t) p[3] << 24 );
+}
+
+static uint16_t _get_u16( const uint8_t* p )
+{
+  return p[0] | ( p[1] << 8 );
+}
+
+static size_t _put_varint( uint8_t* p, uint32_t v )
+{
+  size_t n = 0;
+
+  while ( v >= 0x80 )
+  {
+    p[n++] = (uint8_t) v | 0x80;
+    v >>= 7;
+  }
+
+  p[n++] = (uint8_t) v;
+  return n;
+}
+
+static size_t _get_varint( const uint8_t* p, size_t len, uint32_t* v )
+{
+  uint32_t result = 0;
+
+  for ( size_t n = 0; n < len && n < VARINT_MAX_SIZE; n++ )
+  {
+    result |= (uint32_t) ( p[n] & 0x7F ) << ( 7 * n );
+
+    if ( !( p[n] & 0x80 ) )
+    {
+      *v = result;
+      return n + 1;
+    }
+  }
+
+  return 0;
+}
+
+static uint32_t _zigzag( int32_t v )
+{
+  return ( (uint32_t) v << 1 ) ^ (uint32_t) ( v >> 31 );
+}
+
+static int32_t _unzigzag( uint32_t v )
+{
+  return (int32_t) ( v >> 1 ) ^ -(int32_t) ( v & 1 );
+}
+
+static uint8_t* _block( uint32_t seq )
+{
+  return ctx.blocks[seq % MEASURE_HISTORY_BLOCK_COUNT];
+}
+
+static void _start_block( uint32_t time_ms )
+{
+  if ( ctx.started )
+  {
+    ctx.seq++;
+  }
+
+  if ( ctx.seq - ctx.oldest_seq >= MEASURE_HISTORY_BLOCK_COUNT )
+  {
+    ctx.oldest_seq = ctx.seq - MEASURE_HISTORY_BLOCK_COUNT + 1;
+  }
+
+  uint8_t* block = _block( ctx.seq );
+
+  _put_u32( &block[HEADER_SEQ_OFF], ctx.seq );
+  _put_u32( &block[HEADER_TIME_OFF], time_ms );
+  ctx.len = 0;
+  ctx.count = 0;
+  ctx.started = true;
+
+  /* Keyframe, block decodes without previous ones */
+  memset( &ctx.last, 0, sizeof( ctx.last ) );
+  ctx.last.time_ms = time_ms;
+}
+
+static size_t _encode( uint8_t* out, const history_sample_t* sample )
+{
+  size_t n = _put_varint( out, sample->time_ms - ctx.last.time_ms );
+
+  for ( int ch = 0; ch < HISTORY_CH_TOP; ch++ )
+  {
+    n += _put_varint( &out[n], _zigzag( (int32_t) sample->values[ch] - ctx.last.values[ch] ) );
+  }
+
+  return n;
+}
+
+void measureHistoryInit( void )
+{
+  portENTER_CRITICAL( &history_lock );
+  memset( &ctx, 0, sizeof( ctx ) );
+  portEXIT_CRITICAL( &history_lock );
+}
+
+void measureHistoryAppend( const history_sample_t* sample )
+{
+  assert( sample );
+  uint8_t encoded[SAMPLE_MAX_SIZE];
+
+  portENTER_CRITICAL( &history_lock );
+
+  if ( !ctx.started )
+  {
+    _start_block( sample->time_ms );
+  }
+
+  size_t n = _encode( encoded, sample );
+
+  if ( ctx.len + n > PAYLOAD_SIZE )
+  {
+    _start_block( sample->time_ms );
+    n = _encode( encoded, sample );
+  }
+
+  uint8_t* block = _block( ctx.seq );
+
+  memcpy( &block[MEASURE_HISTORY_HEADER_SIZE + ctx.len], encoded, n );
+  ctx.len += n;
+  ctx.count++;
+  _put_u16( &block[HEADER_LEN_OFF], ctx.len );
+  _put_u16( &block[HEADER_COUNT_OFF], ctx.count );
+  ctx.last = *sample;
+
+  portEXIT_CRITICAL( &history_lock );
+}
+
+void measureHistoryGetSeqRange( uint32_t* oldest, uint32_t* newest )
+{
+  assert( oldest );
+  assert( newest );
+
+  portENTER_CRITICAL( &history_lock );
+  *oldest = ctx.oldest_seq;
+  *newest = ctx.seq;
+  portEXIT_CRITICAL( &history_lock );
+}
+
+size_t measureHistoryCopyBlock( uint32_t seq, uint8_t* out, size_t size )
+{
+  assert( out );
+  size_t len = 0;
+
+  portENTER_CRITICAL( &history_lock );
+
+  if ( ctx.started && (int32_t) ( seq - ctx.oldest_seq ) >= 0 && (int32_t) ( ctx.seq - seq ) >= 0 )
+  {
+    const uint8_t* block = _block( seq );
+    len = MEASURE_HISTORY_HEADER_SIZE + _get_u16( &block[HEADER_LEN_OFF] );
+
+    if ( len <= size )
+    {
+      memcpy( out, block, len );
+    }
+    else
+    {
+      len = 0;
+    }
+  }
+
+  portEXIT_CRITICAL( &history_lock );
+
+  return len;
+}
+
+size_t measureHistoryExport( uint32_t* cursor, uint8_t* out, size_t size )
+{
+  assert( cursor );
+  uint32_t oldest;
+  uint32_t newest;
+
+  measureHistoryGetSeqRange( &oldest, &newest );
+
+  if ( (int32_t) ( *cursor - oldest ) < 0 )
+  {
+    *cursor = oldest;
+  }
+
+  /* Block being filled is not complete yet */
+  if ( (int32_t) ( newest - *cursor ) <= 0 )
+  {
+    return 0;
+  }
+
+  size_t len = measureHistoryCopyBlock( *cursor, out, size );
+
+  if ( len > 0 )
+  {
+    ( *cursor )++;
+  }
+
+  return len;
+}
+
+size_t measureHistoryDecodeBlock( const uint8_t* block, size_t len, history_sample_t* samples, size_t max_samples )
+{
+  assert( block );
+  assert( samples );
+
+  if ( len < MEASURE_HISTORY_HEADER_SIZE )
+  {
+    return 0;
+  }
+
+  size_t payload_len = _get_u16( &block[HEADER_LEN_OFF] );
+  uint16_t count = _get_u16( &block[HEADER_COUNT_OFF] );
+  const uint8_t* p = &block[MEASURE_HISTORY_HEADER_SIZE];
+
+  if ( MEASURE_HISTORY_HEADER_SIZE + payload_len > len )
+  {
+    return 0;
+  }
+
+  history_sample_t last = { .time_ms = _get_u32( &block[HEADER_TIME_OFF] ) };
+  size_t pos = 0;
+  size_t decoded = 0;
+
+  while ( decoded < count && decoded < max_samples )
+  {
+    uint32_t v;
+    size_t n = _get_varint( &p[pos], payload_len - pos, &v );
+
+    if ( n == 0 )
+    {
+      break;
+    }
+
+    pos += n;
+    last.time_ms += v;
+
+    for ( int ch = 0; ch < HISTORY_CH_TOP; ch++ )
+    {
+      n = _get_varint( &p[pos], payload_len - pos, &v );
+
+      if ( n == 0 )
+      {
+        return decoded;
+      }
+
+      pos += n;
+      last.values[ch] = (uint16_t) ( last.values[ch] + _unzigzag( v ) );
+    }
+
+    samples[decoded++] = last;
+  }
+
+  return decoded;
+}
@@ -0,0 +1,56 @@
+/**
+ *******************************************************************************
+ * @file    measure_history.h
+ * @brief   Measurement history, delta and varint encoded blocks in RAM ring
+ *******************************************************************************
+ */
+
+#ifndef _MEASURE_HISTORY_H
+#define _MEASURE_HISTORY_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* 40 kB, about 10 minutes at 10 Hz with typical 6.5 bytes per sample */
+#define MEASURE_HISTORY_BLOCK_SIZE  256
+#define MEASURE_HISTORY_BLOCK_COUNT 160
+
+typedef enum
+{
+  HISTORY_CH_CURRENT_MOTOR,
+  HISTORY_CH_VOLTAGE_ACCUM,
+  HISTORY_CH_TEMPERATURE,
+  HISTORY_CH_VOLTAGE_SERVO,
+  HISTORY_CH_SILOS_LEVEL,
+  HISTORY_CH_TOP,
+} history_ch_t;
+
+typedef struct
+{
+  uint32_t time_ms;
+  uint16_t values[HISTORY_CH_TOP];
+} history_sample_t;
+
+/*
+ * Block layout, little endian:
+ *  u32 seq, u32 time_ms of first sample, u16 payload length, u16 sample count
+ *  per sample: varint time delta in ms, zigzag varint delta of each channel
+ *  first sample of block is keyframe, deltas against zero
+ */
+#define MEASURE_HISTORY_HEADER_SIZE 12
+
+void measureHistoryInit( void );
+void measureHistoryAppend( const history_sample_t* sample );
+
+/* Copies block by sequence number, also the one being filled. Returns length or 0 if overwritten. */
+size_t measureHistoryCopyBlock( uint32_t seq, uint8_t* out, size_t size );
+void measureHistoryGetSeqRange( uint32_t* oldest, uint32_t* newest );
+
+/* Streams completed blocks from cursor, skips blocks already overwritten. Returns 0 if nothing new. */
+size_t measureHistoryExport( uint32_t* cursor, uint8_t* out, size_t size );
+
+/* Decodes exported block, returns number of samples */
+size_t measureHistoryDecodeBlock( const uint8_t* block, size_t len, history_sample_t* samples, size_t max_samples );
+
+#endif
@@ -80,7 +80,7 @@ int motor_start( mDriver* motorD )
     if ( motorD->pwm >= 40 )
     {
       motorD->state = MOTOR_AXELERATE;
-      motorD->timeout = xTaskGetTickCount() + MS2ST( 1000 );
+      deadlineArm( &motorD->timeout, 1000 );
     }
     else
     {
@@ -220,7 +220,7 @@ float dcmotor_process( mDriver* motorD, uint8_t value )
       dcmotor_set_pwm( motorD, 40 );
 
       //printf("MOTOR_AXELERATE %d\n", motorD->pwm_value);
-      if ( motorD->timeout < xTaskGetTickCount() )
+      if ( deadlineExpired( &motorD->timeout ) )
       {
         motorD->state = MOTOR_ON;
       }
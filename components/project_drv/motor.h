@@ -1,6 +1,7 @@
 #ifndef motor_H
 #define motor_H
 #include "app_config.h"
+#include "deadline.h"
 #include "freertos/timers.h"
 #include "stdint.h"
 
@@ -31,7 +32,7 @@ typedef struct
   uint8_t error_code;
   uint8_t pwm;
   float pwm_value;
-  TickType_t timeout;
+  deadline_t timeout;
   uint8_t try_cnt;
 
 } mDriver;
@@ -0,0 +1,209 @@
+#include "motor_calib.h"
+
+#include <assert.h>
+
+static void _start_point( motor_calib_t* calib, uint8_t point )
+{
+  calib->point = point;
+  calib->settle = 0;
+  calib->sample_cnt = 0;
+  calib->sample_sum = 0;
+}
+
+static uint8_t _range_duty( uint8_t point )
+{
+  return ( point + 1 ) * MOTOR_CALIB_RANGE_STEP;
+}
+
+static bool _fit_range( motor_calib_t* calib )
+{
+  uint32_t full = calib->sweep[MOTOR_CALIB_RANGE_POINTS - 1];
+  uint8_t min_point = MOTOR_CALIB_RANGE_POINTS - 1;
+  uint8_t max_point = MOTOR_CALIB_RANGE_POINTS - 1;
+
+  if ( full < calib->min_current )
+  {
+    return false;
+  }
+
+  for ( uint8_t i = MOTOR_CALIB_RANGE_POINTS; i-- > 0; )
+  {
+    if ( calib->sweep[i] * 100 >= full * MOTOR_CALIB_START_PCT )
+    {
+      min_point = i;
+    }
+    else
+    {
+      /* Motor stopped below this duty */
+      break;
+    }
+  }
+
+  for ( uint8_t i = min_point; i < MOTOR_CALIB_RANGE_POINTS; i++ )
+  {
+    if ( calib->sweep[i] * 100 >= full * ( 100 - MOTOR_CALIB_FLAT_PCT ) )
+    {
+      max_point = i;
+      break;
+    }
+  }
+
+  calib->min_duty = _range_duty( min_point );
+  calib->max_duty = _range_duty( max_point );
+
+  return calib->max_duty - calib->min_duty >= MOTOR_CALIB_RANGE_MIN;
+}
+
+/* Friction only grows with speed, measured dips are noise, curve is made non decreasing */
+static bool _fit_curve( motor_calib_t* calib )
+{
+  for ( uint8_t i = 1; i < MOTOR_CALIB_POINTS; i++ )
+  {
+    if ( calib->table[i] < calib->table[i - 1] )
+    {
+      calib->table[i] = calib->table[i - 1];
+    }
+  }
+
+  return calib->table[MOTOR_CALIB_POINTS - 1] >= calib->min_current;
+}
+
+void motorCalibStart( motor_calib_t* calib, uint16_t min_current, uint16_t max_current )
+{
+  assert( calib );
+  calib->phase = MOTOR_CALIB_RANGE;
+  calib->min_current = min_current;
+  calib->max_current = max_current;
+  calib->min_duty = 0;
+  calib->max_duty = 100;
+
+  for ( uint8_t i = 0; i < MOTOR_CALIB_RANGE_POINTS; i++ )
+  {
+    calib->sweep[i] = 0;
+  }
+
+  for ( uint8_t i = 0; i < MOTOR_CALIB_POINTS; i++ )
+  {
+    calib->table[i] = 0;
+  }
+
+  _start_point( calib, 0 );
+}
+
+motor_calib_phase_t motorCalibStep( motor_calib_t* calib, uint16_t current )
+{
+  assert( calib );
+
+  if ( calib->phase != MOTOR_CALIB_RANGE && calib->phase != MOTOR_CALIB_CURVE )
+  {
+    return calib->phase;
+  }
+
+  /* Checked on settle samples too, jammed motor must not be driven through the rest of the sweep */
+  if ( current > calib->max_current )
+  {
+    calib->phase = MOTOR_CALIB_OVERCURRENT;
+    return calib->phase;
+  }
+
+  /* First point of each stage includes motor start and acceleration or range change */
+  uint8_t settle = calib->point == 0 ? MOTOR_CALIB_START_SETTLE : MOTOR_CALIB_SETTLE;
+
+  if ( calib->settle < settle )
+  {
+    calib->settle++;
+    return calib->phase;
+  }
+
+  calib->sample_sum += current;
+  if ( ++calib->sample_cnt < MOTOR_CALIB_SAMPLES )
+  {
+    return calib->phase;
+  }
+
+  uint32_t average = calib->sample_sum / MOTOR_CALIB_SAMPLES;
+
+  if ( average > UINT16_MAX )
+  {
+    average = UINT16_MAX;
+  }
+
+  if ( calib->phase == MOTOR_CALIB_RANGE )
+  {
+    calib->sweep[calib->point] = average;
+
+    if ( calib->point + 1 < MOTOR_CALIB_RANGE_POINTS )
+    {
+      _start_point( calib, calib->point + 1 );
+      return calib->phase;
+    }
+
+    calib->phase = _fit_range( calib ) ? MOTOR_CALIB_CURVE : MOTOR_CALIB_FAILED;
+    _start_point( calib, 0 );
+    return calib->phase;
+  }
+
+  /* Stored 0 means not calibrated, measured point is at least 1 */
+  calib->table[calib->point] = average == 0 ? 1 : average;
+
+  if ( calib->point + 1 < MOTOR_CALIB_POINTS )
+  {
+    _start_point( calib, calib->point + 1 );
+    return calib->phase;
+  }
+
+  calib->phase = _fit_curve( calib ) ? MOTOR_CALIB_DONE : MOTOR_CALIB_FAILED;
+  return calib->phase;
+}
+
+uint8_t motorCalibDuty( const motor_calib_t* calib )
+{
+  assert( calib );
+
+  if ( calib->phase == MOTOR_CALIB_RANGE )
+  {
+    return _range_duty( calib->point );
+  }
+
+  return ( calib->point + 1 ) * MOTOR_CALIB_DUTY_STEP;
+}
+
+bool motorCalibTableIsValid( const uint16_t table[MOTOR_CALIB_POINTS] )
+{
+  assert( table );
+
+  for ( uint8_t i = 0; i < MOTOR_CALIB_POINTS; i++ )
+  {
+    if ( table[i] == 0 )
+    {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+uint32_t motorCalibThreshold( const uint16_t table[MOTOR_CALIB_POINTS], uint8_t duty, uint16_t headroom_pct, uint16_t offset )
+{
+  assert( table );
+
+  uint32_t curve;
+
+  if ( duty <= MOTOR_CALIB_DUTY_STEP )
+  {
+    curve = table[0];
+  }
+  else if ( duty >= MOTOR_CALIB_DUTY_STEP * MOTOR_CALIB_POINTS )
+  {
+    curve = table[MOTOR_CALIB_POINTS - 1];
+  }
+  else
+  {
+    uint8_t idx = duty / MOTOR_CALIB_DUTY_STEP - 1;
+    uint32_t rest = duty % MOTOR_CALIB_DUTY_STEP;
+    int32_t delta = (int32_t) table[idx + 1] - (int32_t) table[idx];
+    curve = (uint32_t) ( (int32_t) table[idx] + delta * (int32_t) rest / MOTOR_CALIB_DUTY_STEP );
+  }
+
+  return curve * headroom_pct / 100 + offset;
+}
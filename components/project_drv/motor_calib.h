@@ -0,0 +1,82 @@
+/**
+ *******************************************************************************
+ * @file    motor_calib.h
+ * @brief   Motor PWM range and no load current curve with overcurrent threshold
+ *******************************************************************************
+ */
+
+#ifndef _MOTOR_CALIB_H
+#define _MOTOR_CALIB_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Duty points as PARAM_MOTOR, 0..100, first point at MOTOR_CALIB_DUTY_STEP */
+#define MOTOR_CALIB_POINTS       5
+#define MOTOR_CALIB_DUTY_STEP    20
+#define MOTOR_CALIB_SETTLE       10
+#define MOTOR_CALIB_START_SETTLE 20
+#define MOTOR_CALIB_SAMPLES      10
+
+/*
+ * Range sweep in raw PWM percent, first point at MOTOR_CALIB_RANGE_STEP.
+ * Min is first duty drawing MOTOR_CALIB_START_PCT of full duty current, motor turns.
+ * Max is first duty within MOTOR_CALIB_FLAT_PCT of full duty current, more PWM adds no speed.
+ */
+#define MOTOR_CALIB_RANGE_STEP   5
+#define MOTOR_CALIB_RANGE_POINTS ( 100 / MOTOR_CALIB_RANGE_STEP )
+#define MOTOR_CALIB_START_PCT    20
+#define MOTOR_CALIB_FLAT_PCT     5
+/* Narrower min..max means sweep found no usable speed control, calibration fails */
+#define MOTOR_CALIB_RANGE_MIN    20
+
+typedef enum
+{
+  MOTOR_CALIB_RANGE,
+  MOTOR_CALIB_CURVE,
+  MOTOR_CALIB_DONE,
+  MOTOR_CALIB_FAILED,
+  MOTOR_CALIB_OVERCURRENT,
+} motor_calib_phase_t;
+
+typedef struct
+{
+  motor_calib_phase_t phase;
+  uint8_t point;
+  uint8_t settle;
+  uint8_t sample_cnt;
+  uint32_t sample_sum;
+  uint16_t min_current;
+  uint16_t max_current;
+  uint16_t sweep[MOTOR_CALIB_RANGE_POINTS];
+  /* Valid from MOTOR_CALIB_CURVE, raw PWM percent for PARAM_MOTOR_MIN/MAX_CALIBRATION */
+  uint8_t min_duty;
+  uint8_t max_duty;
+  uint16_t table[MOTOR_CALIB_POINTS];
+} motor_calib_t;
+
+/*
+ * min_current - current at full duty below which motor is treated as not connected
+ * max_current - hard limit, any sample above it ends calibration in MOTOR_CALIB_OVERCURRENT
+ */
+void motorCalibStart( motor_calib_t* calib, uint16_t min_current, uint16_t max_current );
+
+/*
+ * Feed one motor current sample per step, in units of PARAM_CURRENT_MOTOR.
+ * Duty to apply is returned by motorCalibDuty(). In MOTOR_CALIB_RANGE it is raw PWM,
+ * caller maps 0..100 one to one, in MOTOR_CALIB_CURVE it is mapped through min_duty..max_duty.
+ */
+motor_calib_phase_t motorCalibStep( motor_calib_t* calib, uint16_t current );
+
+uint8_t motorCalibDuty( const motor_calib_t* calib );
+
+/* Table is usable when every point was measured */
+bool motorCalibTableIsValid( const uint16_t table[MOTOR_CALIB_POINTS] );
+
+/*
+ * Threshold for duty, linear between points, flat below first and above last point:
+ * curve * headroom_pct / 100 + offset
+ */
+uint32_t motorCalibThreshold( const uint16_t table[MOTOR_CALIB_POINTS], uint8_t duty, uint16_t headroom_pct, uint16_t offset );
+
+#endif
@@ -2,12 +2,15 @@
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "app_config.h"
+#include "deadline.h"
 #include "menu_drv.h"
 
+#include "param_persist.h"
 #include "parameters.h"
 #include "power_on.h"
 #include "driver/gpio.h"
 #include "menu_backend.h"
+#include "panel_power.h"
 
 #define MODULE_NAME           "[Power] "
 #define DEBUG_LVL             PRINT_WARNING
@@ -22,6 +25,8 @@
 #define POWER_HOLD_PIN        13
 
 #define POWER_OFF_TIME_MIN    parameters_getValue(PARAM_POWER_ON_MIN)
+#define POLL_PERIOD_MS        1000
+#define WAIT_CHECK_PERIOD_MS  10000
 
 enum state_t
 {
@@ -43,7 +48,8 @@ __attribute__((unused)) static const char *_state_name[] =
 struct power_off_context
 {
     enum state_t state;
-    TickType_t power_off_timer;
+    deadline_t power_off_timer;
+    TaskHandle_t task;
 };
 
 static struct power_off_context ctx;
@@ -66,7 +72,7 @@ static void _state_idle(void)
     if (((parameters_getValue(PARAM_MOTOR_IS_ON) == 0) && (parameters_getValue(PARAM_SERVO_IS_ON) == 0) && backendIsConnected()) ||
         !backendIsConnected())
     {
-        ctx.power_off_timer = xTaskGetTickCount() + MS2ST(POWER_OFF_TIME_MIN * 60 * 1000);
+        deadlineArm(&ctx.power_off_timer, POWER_OFF_TIME_MIN * 60 * 1000);
         _change_state(STATE_WAIT_TO_DISABLE);
         return;
     }
@@ -80,9 +86,9 @@ static void _state_wait_to_disable(void)
         return;
     }
 
-    LOG(PRINT_DEBUG, "Time to off %d ms", ST2MS(ctx.power_off_timer - xTaskGetTickCount()));
+    LOG(PRINT_DEBUG, "Time to off %d ms", ST2MS(deadlineRemaining(&ctx.power_off_timer)));
 
-    if (ctx.power_off_timer < xTaskGetTickCount())
+    if (deadlineExpired(&ctx.power_off_timer))
     {
         _change_state(STATE_DISABLE_SYSTEM);
     }
@@ -99,6 +105,17 @@ static void _state_off(void)
     menuDrvDisableSystemProcess();
 }
 
+static TickType_t _get_wait_time(void)
+{
+    /* Buttons reset the timer and wake task, machine state is only rechecked occasionally */
+    if (ctx.state == STATE_WAIT_TO_DISABLE)
+    {
+        return deadlineWaitTicks(&ctx.power_off_timer, MS2ST(WAIT_CHECK_PERIOD_MS));
+    }
+
+    return MS2ST(POLL_PERIOD_MS);
+}
+
 static void _power_on_task(void *arg)
 {
     while (1)
@@ -125,7 +142,7 @@ static void _power_on_task(void *arg)
             ctx.state = STATE_IDLE;
         }
 
-        osDelay(1000);
+        ulTaskNotifyTake(pdTRUE, _get_wait_time());
     }
 }
 
@@ -146,6 +163,8 @@ void power_on_enable_system(void)
 
 void power_on_disable_system(void)
 {
+    /* Pending parameter writes are lost once power hold is released */
+    paramPersistFlush();
     MOTOR_LED_SET_RED(0);
     SERVO_VIBRO_LED_SET_RED(0);
     MOTOR_LED_SET_GREEN(0);
@@ -155,13 +174,19 @@ void power_on_disable_system(void)
 
 void power_on_reset_timer(void)
 {
+    panelPowerActivity();
+
     if (ctx.state == STATE_WAIT_TO_DISABLE)
     {
         _change_state(STATE_IDLE);
+        if (ctx.task != NULL)
+        {
+            xTaskNotifyGive(ctx.task);
+        }
     }
 }
 
 void power_on_start_task(void)
 {
-    xTaskCreate(_power_on_task, "_power_on_task", 2056, NULL, NORMALPRIO, NULL);
+    xTaskCreate(_power_on_task, "_power_on_task", 2056, NULL, NORMALPRIO, &ctx.task);
 }
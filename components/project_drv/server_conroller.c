@@ -1,16 +1,25 @@
 #include <stdbool.h>
 
+#include "black_box.h"
 #include "cmd_server.h"
+#include "deadline.h"
 #include "error_siewnik.h"
 #include "error_solarka.h"
 #include "http_server.h"
 #include "measure.h"
 #include "motor.h"
+#include "motor_calib.h"
+#include "param_access.h"
+#include "param_persist.h"
+#include "param_snapshot.h"
 #include "parameters.h"
 #include "parse_cmd.h"
 #include "pwm_drv.h"
 #include "server_controller.h"
 #include "servo.h"
+#include "servo_calib.h"
+#include "spread_account.h"
+#include "task_profiler.h"
 #include "vibro.h"
 #include "wifidrv.h"
 
@@ -31,6 +40,23 @@
 #define SERVO_PWM_PIN  26
 #define MOTOR_PWM_PIN2 25
 
+#define LOW_VOLTAGE_EXIT_SOC 5
+
+/*
+ * Full duty no load current below MIN means motor is not connected, PARAM_CURRENT_MOTOR units.
+ * MAX is uncalibrated overcurrent threshold at full duty, no load sweep never gets there.
+ */
+#if CONFIG_DEVICE_SIEWNIK
+#define MOTOR_CALIB_MIN_CURRENT 50
+#define MOTOR_CALIB_MAX_CURRENT 1200
+#else
+#define MOTOR_CALIB_MIN_CURRENT 5
+#define MOTOR_CALIB_MAX_CURRENT 100
+#endif
+
+/* Settled servo sense above this during endpoint search is a fault, error module overcurrent is 500 mV */
+#define SERVO_CALIB_MAX_MV 1500
+
 typedef enum
 {
   STATE_INIT,
@@ -40,11 +66,25 @@ typedef enum
   STATE_SERVO_OPEN_REGULATION,
   STATE_SERVO_CLOSE_REGULATION,
   STATE_MOTOR_REGULATION,
+  STATE_SERVO_AUTO_CALIBRATION,
   STATE_EMERGENCY_DISABLE,
   STATE_ERROR,
   STATE_LAST,
 } state_t;
 
+typedef enum
+{
+  WORKING_SNAP_START_SYSTEM,
+  WORKING_SNAP_SERVO,
+  WORKING_SNAP_MOTOR,
+  WORKING_SNAP_MOTOR_IS_ON,
+  WORKING_SNAP_SERVO_IS_ON,
+  WORKING_SNAP_EMERGENCY_DISABLE,
+  WORKING_SNAP_OPEN_FLAG,
+  WORKING_SNAP_CLOSE_FLAG,
+  WORKING_SNAP_TOP,
+} working_snap_t;
+
 typedef struct
 {
   state_t state;
@@ -53,7 +93,8 @@ typedef struct
   uint8_t servo_value;
   uint8_t servo_new_value;
   uint8_t servo_set_value;
-  uint32_t servo_set_timer;
+  deadline_t servo_set_timer;
+  deadline_t wait;
   uint8_t motor_value;
 
   uint8_t motor_on;
@@ -69,6 +110,13 @@ typedef struct
   bool motor_calibration_req;
   bool servo_open_calibration_req;
   bool servo_close_calibration_req;
+  bool servo_auto_calibration_req;
+  servo_calib_t servo_calib;
+  uint8_t servo_calib_close_backup;
+  uint8_t servo_calib_open_backup;
+  motor_calib_t motor_calib;
+  uint8_t motor_calib_min_backup;
+  uint8_t motor_calib_max_backup;
   pwm_drv_t motor1_pwm;
   pwm_drv_t motor2_pwm;
   pwm_drv_t servo_pwm_drv;
@@ -87,6 +135,7 @@ static char* state_name[] =
     [STATE_SERVO_OPEN_REGULATION] = "STATE_SERVO_OPEN_REGULATION",
     [STATE_SERVO_CLOSE_REGULATION] = "STATE_SERVO_CLOSE_REGULATION",
     [STATE_MOTOR_REGULATION] = "STATE_MOTOR_REGULATION",
+    [STATE_SERVO_AUTO_CALIBRATION] = "STATE_SERVO_AUTO_CALIBRATION",
     [STATE_EMERGENCY_DISABLE] = "STATE_EMERGENCY_DISABLE",
     [STATE_ERROR] = "STATE_ERROR" };
 
@@ -101,9 +150,31 @@ static void change_state( state_t state )
   {
     LOG( PRINT_INFO, "Change state -> %s", state_name[state] );
     ctx.state = state;
+    blackBoxSetState( BLACK_BOX_SRC_CONTROLLER, state );
   }
 }
 
+/* Executive must not block, state wait is kept as deadline checked by srvrControllStep() */
+static void _wait( uint32_t ms )
+{
+#if CONFIG_CONTROLLER_EXECUTIVE
+  deadlineArm( &ctx.wait, ms );
+#else
+  osDelay( ms );
+#endif
+}
+
+static void _clear_outputs_on( void )
+{
+  static const param_value_t outputs_off[] =
+    {
+      { .param = PARAM_MOTOR_IS_ON, .value = 0 },
+      { .param = PARAM_SERVO_IS_ON, .value = 0 },
+    };
+
+  paramSnapshotWrite( outputs_off, sizeof( outputs_off ) / sizeof( outputs_off[0] ) );
+}
+
 static void count_working_data( void )
 {
   ctx.motor_pwm = dcmotor_process( &ctx.motorD1, ctx.motor_value );
@@ -112,7 +183,7 @@ static void count_working_data( void )
   if ( ctx.servo_new_value != ctx.servo_value )
   {
     ctx.servo_new_value = ctx.servo_value;
-    ctx.servo_set_timer = xTaskGetTickCount() + MS2ST( 750 );
+    deadlineArm( &ctx.servo_set_timer, 750 );
     errorSiewnikServoChangeState();
   }
 #endif
@@ -129,7 +200,7 @@ static void count_working_data( void )
   }
 
 #if CONFIG_DEVICE_SIEWNIK
-  if ( ctx.servo_set_timer < xTaskGetTickCount() )
+  if ( deadlineExpired( &ctx.servo_set_timer ) )
   {
     ctx.servo_set_value = ctx.servo_new_value;
   }
@@ -140,6 +211,8 @@ static void count_working_data( void )
 static void set_working_data( void )
 {
   // #if CONFIG_DEVICE_SIEWNIK
+  float motor_duty = 0;
+  float servo_duty = 0;
 
   if ( ctx.system_on )
   {
@@ -160,6 +233,7 @@ static void set_working_data( void )
       duty = 99.99;
     }
     PWMDrv_SetDuty( &ctx.motor1_pwm, duty );
+    motor_duty = duty;
   }
   else
   {
@@ -177,7 +251,8 @@ static void set_working_data( void )
   if ( vibro_is_on() && ctx.servo_on )
   {
     // ToDo napiecie 2 progi
-    PWMDrv_SetDuty( &ctx.servo_pwm_drv, parameters_getValue( PARAM_VIBRO_DUTY_PWM ) );
+    servo_duty = parameters_getValue( PARAM_VIBRO_DUTY_PWM );
+    PWMDrv_SetDuty( &ctx.servo_pwm_drv, servo_duty );
   }
   else
   {
@@ -193,7 +268,10 @@ static void set_working_data( void )
   }
   LOG( PRINT_DEBUG, "duty servo %f %d %d", duty, ctx.servo_value, ctx.servo_pwm );
   PWMDrv_SetDuty( &ctx.servo_pwm_drv, duty );
+  servo_duty = duty;
 #endif
+
+  blackBoxSetPwm( motor_duty, servo_duty );
 }
 
 static void state_init( void )
@@ -233,8 +311,7 @@ static void state_idle( void )
   ctx.working_state_req = (bool) parameters_getValue( PARAM_START_SYSTEM );
   ctx.emergency_disable = (bool) parameters_getValue( PARAM_EMERGENCY_DISABLE );
   vibro_stop();
-  parameters_setValue( PARAM_MOTOR_IS_ON, 0 );
-  parameters_setValue( PARAM_SERVO_IS_ON, 0 );
+  _clear_outputs_on();
 
   if ( ctx.emergency_disable )
   {
@@ -256,40 +333,84 @@ static void state_idle( void )
     return;
   }
 
+  ctx.motor_calibration_req = PARAM_MOTOR_AUTO_CALIBRATION_get();
+  if ( ctx.motor_calibration_req && ctx.working_state_req && HTTPServer_IsClientConnected() )
+  {
+    ctx.motor_calib_min_backup = PARAM_MOTOR_MIN_CALIBRATION_get();
+    ctx.motor_calib_max_backup = PARAM_MOTOR_MAX_CALIBRATION_get();
+    /* Range sweep drives raw PWM */
+    PARAM_MOTOR_MIN_CALIBRATION_set( 0 );
+    PARAM_MOTOR_MAX_CALIBRATION_set( 100 );
+    motorCalibStart( &ctx.motor_calib, MOTOR_CALIB_MIN_CURRENT, MOTOR_CALIB_MAX_CURRENT );
+    change_state( STATE_MOTOR_REGULATION );
+    return;
+  }
+
+#if CONFIG_DEVICE_SIEWNIK
+  ctx.servo_auto_calibration_req = PARAM_SERVO_AUTO_CALIBRATION_get();
+  if ( ctx.servo_auto_calibration_req && ctx.working_state_req && HTTPServer_IsClientConnected() )
+  {
+    ctx.servo_calib_close_backup = PARAM_CLOSE_SERVO_REGULATION_get();
+    ctx.servo_calib_open_backup = PARAM_OPEN_SERVO_REGULATION_get();
+    servoCalibStart( &ctx.servo_calib, SERVO_CALIB_MAX_MV );
+    change_state( STATE_SERVO_AUTO_CALIBRATION );
+    return;
+  }
+#endif
+
   if ( ctx.working_state_req && HTTPServer_IsClientConnected() )
   {
     measure_meas_calibration_value();
     count_working_data();
     ctx.system_on = (bool) parameters_getValue( PARAM_START_SYSTEM );
     set_working_data();
-    osDelay( 1000 );
+    _wait( 1000 );
     change_state( STATE_WORKING );
     return;
   }
 
-  osDelay( 100 );
+  _wait( 100 );
 }
 
 static void state_working( void )
 {
-  ctx.system_on = (bool) parameters_getValue( PARAM_START_SYSTEM );
-  ctx.servo_value = (uint8_t) parameters_getValue( PARAM_SERVO );
-  ctx.motor_value = (uint8_t) parameters_getValue( PARAM_MOTOR );
-  ctx.motor_on = (uint8_t) parameters_getValue( PARAM_MOTOR_IS_ON );
-  ctx.servo_on = parameters_getValue( PARAM_SERVO_IS_ON ) > 0;
+  param_value_t snapshot[WORKING_SNAP_TOP] =
+    {
+      [WORKING_SNAP_START_SYSTEM] = { .param = PARAM_START_SYSTEM },
+      [WORKING_SNAP_SERVO] = { .param = PARAM_SERVO },
+      [WORKING_SNAP_MOTOR] = { .param = PARAM_MOTOR },
+      [WORKING_SNAP_MOTOR_IS_ON] = { .param = PARAM_MOTOR_IS_ON },
+      [WORKING_SNAP_SERVO_IS_ON] = { .param = PARAM_SERVO_IS_ON },
+      [WORKING_SNAP_EMERGENCY_DISABLE] = { .param = PARAM_EMERGENCY_DISABLE },
+      [WORKING_SNAP_OPEN_FLAG] = { .param = PARAM_OPEN_SERVO_REGULATION_FLAG },
+      [WORKING_SNAP_CLOSE_FLAG] = { .param = PARAM_CLOSE_SERVO_REGULATION_FLAG },
+    };
+
+  if ( !paramSnapshotRead( snapshot, WORKING_SNAP_TOP ) )
+  {
+    LOG( PRINT_WARNING, "Torn parameters, skip cycle" );
+    _wait( 10 );
+    return;
+  }
 
-  ctx.working_state_req = (bool) parameters_getValue( PARAM_START_SYSTEM );
-  ctx.emergency_disable = (bool) parameters_getValue( PARAM_EMERGENCY_DISABLE );
-  ctx.servo_open_calibration_req = (bool) parameters_getValue( PARAM_OPEN_SERVO_REGULATION_FLAG );
-  ctx.servo_close_calibration_req = (bool) parameters_getValue( PARAM_CLOSE_SERVO_REGULATION_FLAG );
+  ctx.system_on = snapshot[WORKING_SNAP_START_SYSTEM].value != 0;
+  ctx.servo_value = (uint8_t) snapshot[WORKING_SNAP_SERVO].value;
+  ctx.motor_value = (uint8_t) snapshot[WORKING_SNAP_MOTOR].value;
+  ctx.motor_on = snapshot[WORKING_SNAP_MOTOR_IS_ON].value != 0;
+  ctx.servo_on = snapshot[WORKING_SNAP_SERVO_IS_ON].value != 0;
+
+  ctx.working_state_req = ctx.system_on;
+  ctx.emergency_disable = snapshot[WORKING_SNAP_EMERGENCY_DISABLE].value != 0;
+  ctx.servo_open_calibration_req = snapshot[WORKING_SNAP_OPEN_FLAG].value != 0;
+  ctx.servo_close_calibration_req = snapshot[WORKING_SNAP_CLOSE_FLAG].value != 0;
 
 #if CONFIG_DEVICE_SOLARKA
 #if MENU_VIRO_ON_OFF_VERSION
-  vibro_config( parameters_getValue( PARAM_VIBRO_ON_S ) * 1000, parameters_getValue( PARAM_VIBRO_OFF_S ) * 1000 );
+  vibro_config( PARAM_VIBRO_ON_S_get() * 1000, PARAM_VIBRO_OFF_S_get() * 1000 );
 #else
-  vibro_config( parameters_getValue( PARAM_PERIOD ) * 1000, parameters_getValue( PARAM_SERVO ) );
+  vibro_config( PARAM_PERIOD_get() * 1000, ctx.servo_value );
 #endif
-  if ( parameters_getValue( PARAM_SERVO_IS_ON ) )
+  if ( ctx.servo_on )
   {
     vibro_start();
   }
@@ -327,7 +448,7 @@ static void state_working( void )
     return;
   }
 
-  osDelay( 50 );
+  _wait( 50 );
 }
 
 static void state_servo_open_regulation( void )
@@ -344,27 +465,27 @@ static void state_servo_open_regulation( void )
 
   if ( ctx.emergency_disable )
   {
-    parameters_save();
+    paramPersistMarkDirty( PARAM_OPEN_SERVO_REGULATION );
     change_state( STATE_EMERGENCY_DISABLE );
     return;
   }
 
   if ( !ctx.servo_open_calibration_req )
   {
-    parameters_save();
+    paramPersistMarkDirty( PARAM_OPEN_SERVO_REGULATION );
     change_state( STATE_IDLE );
     return;
   }
 
   if ( !ctx.working_state_req || !HTTPServer_IsClientConnected() )
   {
-    parameters_save();
-    parameters_setValue( PARAM_OPEN_SERVO_REGULATION_FLAG, 0 );
+    paramPersistMarkDirty( PARAM_OPEN_SERVO_REGULATION );
+    PARAM_OPEN_SERVO_REGULATION_FLAG_set( 0 );
     change_state( STATE_IDLE );
     return;
   }
 
-  osDelay( 100 );
+  _wait( 100 );
 }
 
 static void state_servo_close_regulation( void )
@@ -381,34 +502,200 @@ static void state_servo_close_regulation( void )
 
   if ( ctx.emergency_disable )
   {
-    parameters_save();
+    paramPersistMarkDirty( PARAM_CLOSE_SERVO_REGULATION );
     change_state( STATE_EMERGENCY_DISABLE );
     return;
   }
 
   if ( !ctx.servo_close_calibration_req )
   {
-    parameters_save();
+    paramPersistMarkDirty( PARAM_CLOSE_SERVO_REGULATION );
     change_state( STATE_IDLE );
     return;
   }
 
   if ( !ctx.working_state_req || !HTTPServer_IsClientConnected() )
   {
-    parameters_save();
-    parameters_setValue( PARAM_OPEN_SERVO_REGULATION_FLAG, 0 );
+    paramPersistMarkDirty( PARAM_CLOSE_SERVO_REGULATION );
+    PARAM_OPEN_SERVO_REGULATION_FLAG_set( 0 );
     change_state( STATE_IDLE );
     return;
   }
 
-  osDelay( 100 );
+  _wait( 100 );
 }
 
+static void _motor_calibration_restore( void )
+{
+  PARAM_MOTOR_MIN_CALIBRATION_set( ctx.motor_calib_min_backup );
+  PARAM_MOTOR_MAX_CALIBRATION_set( ctx.motor_calib_max_backup );
+  PARAM_MOTOR_AUTO_CALIBRATION_set( 0 );
+}
+
+static void _motor_calibration_store( void )
+{
+  paramPersistMarkDirty( PARAM_MOTOR_MIN_CALIBRATION );
+  paramPersistMarkDirty( PARAM_MOTOR_MAX_CALIBRATION );
+  PARAM_MOTOR_CURRENT_20_set( ctx.motor_calib.table[0] );
+  PARAM_MOTOR_CURRENT_40_set( ctx.motor_calib.table[1] );
+  PARAM_MOTOR_CURRENT_60_set( ctx.motor_calib.table[2] );
+  PARAM_MOTOR_CURRENT_80_set( ctx.motor_calib.table[3] );
+  PARAM_MOTOR_CURRENT_100_set( ctx.motor_calib.table[4] );
+  paramPersistMarkDirty( PARAM_MOTOR_CURRENT_20 );
+  paramPersistMarkDirty( PARAM_MOTOR_CURRENT_40 );
+  paramPersistMarkDirty( PARAM_MOTOR_CURRENT_60 );
+  paramPersistMarkDirty( PARAM_MOTOR_CURRENT_80 );
+  paramPersistMarkDirty( PARAM_MOTOR_CURRENT_100 );
+}
+
+/* Motor runs with servo closed, so PWM range and current curve are measured without load */
 static void state_motor_regulation( void )
 {
-  change_state( STATE_IDLE );
+  ctx.system_on = 1;
+  ctx.servo_value = 0;
+  ctx.servo_on = 0;
+  ctx.motor_on = 1;
+
+  ctx.working_state_req = (bool) parameters_getValue( PARAM_START_SYSTEM );
+  ctx.emergency_disable = (bool) parameters_getValue( PARAM_EMERGENCY_DISABLE );
+  ctx.motor_calibration_req = PARAM_MOTOR_AUTO_CALIBRATION_get();
+
+  if ( ctx.emergency_disable )
+  {
+    _motor_calibration_restore();
+    change_state( STATE_EMERGENCY_DISABLE );
+    return;
+  }
+
+  if ( !ctx.motor_calibration_req || !ctx.working_state_req || !HTTPServer_IsClientConnected() )
+  {
+    LOG( PRINT_INFO, "Motor auto calibration aborted" );
+    _motor_calibration_restore();
+    change_state( STATE_IDLE );
+    return;
+  }
+
+  motor_calib_phase_t prev_phase = ctx.motor_calib.phase;
+
+  switch ( motorCalibStep( &ctx.motor_calib, PARAM_CURRENT_MOTOR_get() ) )
+  {
+    case MOTOR_CALIB_RANGE:
+      ctx.motor_value = motorCalibDuty( &ctx.motor_calib );
+      break;
+
+    case MOTOR_CALIB_CURVE:
+      if ( prev_phase == MOTOR_CALIB_RANGE )
+      {
+        LOG( PRINT_INFO, "Motor PWM range %d..%d", ctx.motor_calib.min_duty, ctx.motor_calib.max_duty );
+        PARAM_MOTOR_MIN_CALIBRATION_set( ctx.motor_calib.min_duty );
+        PARAM_MOTOR_MAX_CALIBRATION_set( ctx.motor_calib.max_duty );
+      }
+
+      ctx.motor_value = motorCalibDuty( &ctx.motor_calib );
+      break;
+
+    case MOTOR_CALIB_DONE:
+      LOG( PRINT_INFO, "Motor calib %d..%d", ctx.motor_calib.table[0], ctx.motor_calib.table[MOTOR_CALIB_POINTS - 1] );
+      _motor_calibration_store();
+      PARAM_MOTOR_AUTO_CALIBRATION_set( 0 );
+      change_state( STATE_IDLE );
+      return;
+
+    case MOTOR_CALIB_OVERCURRENT:
+      LOG( PRINT_ERROR, "Motor calib overcurrent at duty %d", ctx.motor_value );
+      ctx.motor_value = 0;
+      ctx.motor_on = 0;
+      srvrConrollerSetError( ERROR_MOTOR_OVER_CURRENT );
+      return;
+
+    default:
+      LOG( PRINT_WARNING, "Motor calib failed" );
+      _motor_calibration_restore();
+      change_state( STATE_IDLE );
+      return;
+  }
+
+  _wait( 100 );
 }
 
+#if CONFIG_DEVICE_SIEWNIK
+static void _servo_auto_calibration_restore( void )
+{
+  PARAM_CLOSE_SERVO_REGULATION_set( ctx.servo_calib_close_backup );
+  PARAM_OPEN_SERVO_REGULATION_set( ctx.servo_calib_open_backup );
+  PARAM_SERVO_AUTO_CALIBRATION_set( 0 );
+}
+
+static void state_servo_auto_calibration( void )
+{
+  ctx.system_on = 1;
+  ctx.motor_value = 0;
+  ctx.motor_on = 0;
+  ctx.servo_on = 1;
+
+  ctx.working_state_req = (bool) parameters_getValue( PARAM_START_SYSTEM );
+  ctx.emergency_disable = (bool) parameters_getValue( PARAM_EMERGENCY_DISABLE );
+  ctx.servo_auto_calibration_req = PARAM_SERVO_AUTO_CALIBRATION_get();
+
+  if ( ctx.emergency_disable )
+  {
+    _servo_auto_calibration_restore();
+    change_state( STATE_EMERGENCY_DISABLE );
+    return;
+  }
+
+  if ( !ctx.servo_auto_calibration_req || !ctx.working_state_req || !HTTPServer_IsClientConnected() )
+  {
+    LOG( PRINT_INFO, "Servo auto calibration aborted" );
+    _servo_auto_calibration_restore();
+    change_state( STATE_IDLE );
+    return;
+  }
+
+  switch ( servoCalibStep( &ctx.servo_calib, PARAM_VOLTAGE_SERVO_get() ) )
+  {
+    case SERVO_CALIB_CLOSE:
+      ctx.servo_value = 0;
+      PARAM_CLOSE_SERVO_REGULATION_set( ctx.servo_calib.regulation );
+      break;
+
+    case SERVO_CALIB_OPEN:
+      /* Skip change debounce, sweep needs servo on open endpoint at once */
+      ctx.servo_value = 100;
+      ctx.servo_new_value = 100;
+      ctx.servo_set_value = 100;
+      PARAM_CLOSE_SERVO_REGULATION_set( ctx.servo_calib.close_result );
+      PARAM_OPEN_SERVO_REGULATION_set( ctx.servo_calib.regulation );
+      break;
+
+    case SERVO_CALIB_DONE:
+      LOG( PRINT_INFO, "Servo calib close %d open %d", ctx.servo_calib.close_result, ctx.servo_calib.open_result );
+      PARAM_CLOSE_SERVO_REGULATION_set( ctx.servo_calib.close_result );
+      PARAM_OPEN_SERVO_REGULATION_set( ctx.servo_calib.open_result );
+      paramPersistMarkDirty( PARAM_CLOSE_SERVO_REGULATION );
+      paramPersistMarkDirty( PARAM_OPEN_SERVO_REGULATION );
+      PARAM_SERVO_AUTO_CALIBRATION_set( 0 );
+      change_state( STATE_IDLE );
+      return;
+
+    case SERVO_CALIB_OVERCURRENT:
+      LOG( PRINT_ERROR, "Servo calib overcurrent at regulation %d", ctx.servo_calib.regulation );
+      ctx.servo_value = 0;
+      ctx.servo_on = 0;
+      srvrConrollerSetError( ERROR_SERVO_OVER_CURRENT );
+      return;
+
+    default:
+      LOG( PRINT_WARNING, "Servo calib failed, no stall found" );
+      _servo_auto_calibration_restore();
+      change_state( STATE_IDLE );
+      return;
+  }
+
+  _wait( 100 );
+}
+#endif
+
 static void state_emergency_disable( void )
 {
   // Tą linijke usunąć jeżeli niepotrzebne wyłączenie przekaźnika w trybie STOP
@@ -425,7 +712,25 @@ static void state_emergency_disable( void )
     return;
   }
 
-  osDelay( 100 );
+  _wait( 100 );
+}
+
+static void state_low_voltage( void )
+{
+  ctx.servo_value = 0;
+  ctx.motor_value = 0;
+  ctx.motor_on = false;
+  ctx.servo_on = false;
+  vibro_stop();
+  _clear_outputs_on();
+
+  if ( measure_get_accum_soc() >= LOW_VOLTAGE_EXIT_SOC )
+  {
+    change_state( STATE_IDLE );
+    return;
+  }
+
+  _wait( 100 );
 }
 
 static void state_error( void )
@@ -449,90 +754,118 @@ static void state_error( void )
     return;
   }
 
-  osDelay( 100 );
+  _wait( 100 );
 }
 
-static void _task( void* arg )
+static uint8_t _spread_servo_open( void )
 {
-  parameters_setValue( PARAM_CLOSE_SERVO_REGULATION_FLAG, 0 );
-  parameters_setValue( PARAM_OPEN_SERVO_REGULATION_FLAG, 0 );
-  while ( 1 )
+  if ( !ctx.servo_on )
+  {
+    return 0;
+  }
+
+#if CONFIG_DEVICE_SIEWNIK
+  return ctx.servo_set_value;
+#else
+  return ctx.servo_value;
+#endif
+}
+
+void srvrControllStep( void )
+{
+#if CONFIG_CONTROLLER_EXECUTIVE
+  /* State asked to wait, executive calls again on next tick */
+  if ( !deadlineExpired( &ctx.wait ) )
+  {
+    return;
+  }
+
+#endif
+  taskProfilerLoop( TASK_PROFILER_LOOP_CONTROLLER );
+
+  switch ( ctx.state )
+  {
+    case STATE_INIT:
+      state_init();
+      break;
+
+    case STATE_IDLE:
+      state_idle();
+      break;
+
+    case STATE_WORKING:
+      state_working();
+      break;
+
+    case STATE_SERVO_OPEN_REGULATION:
+      state_servo_open_regulation();
+      break;
+
+    case STATE_SERVO_CLOSE_REGULATION:
+      state_servo_close_regulation();
+      break;
+
+    case STATE_MOTOR_REGULATION:
+      state_motor_regulation();
+      break;
+
+#if CONFIG_DEVICE_SIEWNIK
+    case STATE_SERVO_AUTO_CALIBRATION:
+      state_servo_auto_calibration();
+      break;
+#endif
+
+    case STATE_EMERGENCY_DISABLE:
+      state_emergency_disable();
+      break;
+
+    case STATE_ERROR:
+      state_error();
+      break;
+
+    case STATE_LOW_VOLTAGE:
+      state_low_voltage();
+      break;
+
+    default:
+      change_state( STATE_IDLE );
+      break;
+  }
+
+  /* Estimator is load compensated and filtered, empty means really discharged */
+  if ( ( ctx.state == STATE_WORKING ) && measure_accum_soc_is_valid() && ( measure_get_accum_soc() == 0 ) )
+  {
+    change_state( STATE_LOW_VOLTAGE );
+  }
+
+  count_working_data();
+  set_working_data();
+  spreadAccountUpdate( ctx.state == STATE_WORKING, _spread_servo_open(), ctx.motor_on ? ctx.motor_value : 0 );
+
+  //TEST
+  if ( ctx.motor_on != test_last_motor_state )
   {
-    switch ( ctx.state )
+    test_last_motor_state = ctx.motor_on;
+    if ( ctx.motor_on )
     {
-      case STATE_INIT:
-        state_init();
-        break;
-
-      case STATE_IDLE:
-        state_idle();
-        break;
-
-      case STATE_WORKING:
-        state_working();
-        break;
-
-      case STATE_SERVO_OPEN_REGULATION:
-        state_servo_open_regulation();
-        break;
-
-      case STATE_SERVO_CLOSE_REGULATION:
-        state_servo_close_regulation();
-        break;
-
-      case STATE_MOTOR_REGULATION:
-        state_motor_regulation();
-        break;
-
-      case STATE_EMERGENCY_DISABLE:
-        state_emergency_disable();
-        break;
-
-      case STATE_ERROR:
-        state_error();
-        break;
-
-      case STATE_LOW_VOLTAGE:
-        ctx.servo_value = 0;
-        ctx.motor_value = 0;
-        ctx.motor_on = false;
-        ctx.servo_on = false;
-        float voltage = accum_get_voltage();
-        // printf("voltage: %f\n\r", voltage);
-        if ( 5 < voltage )
-        {
-          change_state( STATE_IDLE );
-        }
-        break;
-
-      default:
-        change_state( STATE_IDLE );
-        break;
+      LOG( PRINT_DEBUG, "----MOTOR ON" );
     }
-    float voltage = accum_get_voltage();
-    // printf("voltage: %f\n\r", voltage);
-    if ( 5 > voltage )
+    else
     {
-      // change_state(STATE_LOW_VOLTAGE);
+      LOG( PRINT_DEBUG, "----MOTOR OFF" );
     }
-    count_working_data();
-    set_working_data();
+  }
+}
 
-    //TEST
-    if ( ctx.motor_on != test_last_motor_state )
-    {
-      test_last_motor_state = ctx.motor_on;
-      if ( ctx.motor_on )
-      {
-        LOG( PRINT_DEBUG, "----MOTOR ON" );
-      }
-      else
-      {
-        LOG( PRINT_DEBUG, "----MOTOR OFF" );
-      }
-    }
+#if !CONFIG_CONTROLLER_EXECUTIVE
+static void _task( void* arg )
+{
+  while ( 1 )
+  {
+    srvrControllStep();
   }
 }
+#endif
 
 bool srvrControllIsWorking( void )
 {
@@ -554,6 +887,11 @@ uint8_t srvrControllGetMotorPwm( void )
   return ctx.motor_pwm;
 }
 
+uint8_t srvrControllGetMotorValue( void )
+{
+  return ctx.motor_on ? ctx.motor_value : 0;
+}
+
 uint16_t srvrControllGetServoPwm( void )
 {
   return ctx.servo_pwm;
@@ -576,20 +914,48 @@ void srvrControllStart( void )
   vibro_init();
 #endif
 
-  xTaskCreate( _task, "srvrController", 4096, NULL, 10, NULL );
+  PARAM_CLOSE_SERVO_REGULATION_FLAG_set( 0 );
+  PARAM_OPEN_SERVO_REGULATION_FLAG_set( 0 );
+  PARAM_SERVO_AUTO_CALIBRATION_set( 0 );
+  PARAM_MOTOR_AUTO_CALIBRATION_set( 0 );
+
+  blackBoxInit();
+  spreadAccountInit();
+#if !CONFIG_CONTROLLER_EXECUTIVE
+  xTaskCreatePinnedToCore( _task, "srvrController", CONTROLLER_TASK_STACK, NULL, CONTROLLER_TASK_PRIO, NULL,
+                           TASK_CORE( CONTROL_CORE ) );
+#endif
 }
 
 bool srvrConrollerSetError( uint16_t error_reason )
 {
-  if ( ctx.state == STATE_WORKING )
+  switch ( ctx.state )
   {
-    change_state( STATE_ERROR );
-    uint16_t error = ( 1 << error_reason );
-    parameters_setValue( PARAM_MACHINE_ERRORS, error );
-    return true;
+    case STATE_WORKING:
+      change_state( STATE_ERROR );
+      break;
+
+    /* Calibration drives outputs too, values under test must not stay after fault */
+    case STATE_MOTOR_REGULATION:
+      change_state( STATE_ERROR );
+      _motor_calibration_restore();
+      break;
+
+#if CONFIG_DEVICE_SIEWNIK
+    case STATE_SERVO_AUTO_CALIBRATION:
+      change_state( STATE_ERROR );
+      _servo_auto_calibration_restore();
+      break;
+#endif
+
+    default:
+      return false;
   }
 
-  return false;
+  uint16_t error = ( 1 << error_reason );
+  PARAM_MACHINE_ERRORS_set( error );
+  blackBoxTrigger( error_reason );
+  return true;
 }
 
 bool srvrControllerErrorReset( void )
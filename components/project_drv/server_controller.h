@@ -6,9 +6,13 @@
 bool srvrControllGetMotorStatus( void );
 bool srvrControllGetServoStatus( void );
 uint8_t srvrControllGetMotorPwm( void );
+/* Duty being driven in PARAM_MOTOR units, calibration sweep included */
+uint8_t srvrControllGetMotorValue( void );
 uint16_t srvrControllGetServoPwm( void );
 bool srvrControllGetEmergencyDisable( void );
 void srvrControllStart( void );
+/* One control and actuation cycle, called by own task or by controller executive */
+void srvrControllStep( void );
 bool srvrConrollerSetError( uint16_t error_reason );
 bool srvrControllerErrorReset( void );
 bool srvrControllIsWorking( void );
@@ -57,11 +57,11 @@ void servo_error( uint8_t close )
 
 static void servo_error_process( void )
 {
-  static TickType_t timeout;
+  static deadline_t timeout;
 
-  if ( timeout != 0 )
+  if ( deadlineIsArmed( &timeout ) )
   {
-    if ( timeout < xTaskGetTickCount() )
+    if ( deadlineExpired( &timeout ) )
     {
       servoD.state = SERVO_ERROR;
       OFF_SERVO;
@@ -69,7 +69,7 @@ static void servo_error_process( void )
   }
   else
   {
-    timeout = xTaskGetTickCount() + MS2ST( 3500 );
+    deadlineArm( &timeout, 3500 );
   }
 }
 
@@ -154,31 +154,31 @@ int servo_close( void )
 
 void servo_try_reset_timeout( uint32_t time_ms )
 {
-  servoD.timeout = xTaskGetTickCount() + MS2ST( time_ms );
+  deadlineArm( &servoD.timeout, time_ms );
 }
 
 static void servo_try_process( void )
 {
-  static TickType_t timeout;
+  static deadline_t timeout;
 
   if ( try_count == 0 )
   {
-    timeout = xTaskGetTickCount() + MS2ST( 50 );
+    deadlineArm( &timeout, 50 );
     try_count++;
     servo_set_pwm_val( servoD.value + try_count );
   }
   else if ( ( try_count > 0 ) && ( try_count < TRY_OPEN_VAL ) )
   {
-    if ( ( timeout < xTaskGetTickCount() ) && ( timeout != 0 ) )
+    if ( deadlineIsArmed( &timeout ) && deadlineExpired( &timeout ) )
     {
-      timeout = xTaskGetTickCount() + MS2ST( 50 );
+      deadlineArm( &timeout, 50 );
       try_count++;
       servo_set_pwm_val( servoD.value + try_count * 8 );
     }
   }
   else
   {
-    timeout = 0;
+    deadlineDisarm( &timeout );
     try_count = 0;
     servo_set_pwm_val( servoD.value );
     servoD.state = servoD.last_state;
@@ -246,10 +246,10 @@ uint16_t servo_process( uint8_t value )
       break;
   }
 
-  if ( ( servoD.timeout < xTaskGetTickCount() ) && ( servoD.timeout != 0 ) )
+  if ( deadlineIsArmed( &servoD.timeout ) && deadlineExpired( &servoD.timeout ) )
   {
     servoD.try_cnt = 0;
-    servoD.timeout = 0;
+    deadlineDisarm( &servoD.timeout );
     printf( "SERVO: Zero try cnt\n" );
   }
 
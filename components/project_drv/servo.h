@@ -8,6 +8,7 @@
 #ifndef PWM_H_
 #define PWM_H_
 #include "app_config.h"
+#include "deadline.h"
 
 //#define SERVO_PORT DDRD
 //#define SERVO_PIN
@@ -39,7 +40,7 @@ typedef struct
   uint8_t error_code;
   uint16_t pwm_value;    // PWM 16bit timer
   uint8_t value;    // Open procent timer
-  TickType_t timeout;
+  deadline_t timeout;
   uint8_t try_cnt;
 } sDriver;
 
@@ -0,0 +1,128 @@
+#include "servo_calib.h"
+
+#include <assert.h>
+
+/*
+ * Lower close regulation moves closed position further into stop,
+ * higher open regulation moves open position further into stop.
+ */
+static void _start_phase( servo_calib_t* calib, servo_calib_phase_t phase )
+{
+  calib->phase = phase;
+  calib->regulation = phase == SERVO_CALIB_CLOSE ? SERVO_CALIB_START_CLOSE : SERVO_CALIB_START_OPEN;
+  calib->settle = 0;
+  calib->stall_cnt = 0;
+  calib->baseline_cnt = 0;
+  calib->baseline_sum = 0;
+}
+
+/* Returns false if stop was not found in whole range */
+static bool _next_step( servo_calib_t* calib )
+{
+  calib->settle = 0;
+
+  if ( calib->phase == SERVO_CALIB_CLOSE )
+  {
+    if ( calib->regulation < SERVO_CALIB_STEP )
+    {
+      return false;
+    }
+
+    calib->regulation -= SERVO_CALIB_STEP;
+  }
+  else
+  {
+    if ( calib->regulation + SERVO_CALIB_STEP > SERVO_CALIB_REG_MAX )
+    {
+      return false;
+    }
+
+    calib->regulation += SERVO_CALIB_STEP;
+  }
+
+  return true;
+}
+
+static void _store_endpoint( servo_calib_t* calib )
+{
+  if ( calib->phase == SERVO_CALIB_CLOSE )
+  {
+    uint32_t result = calib->regulation + SERVO_CALIB_MARGIN;
+    calib->close_result = result > SERVO_CALIB_REG_MAX ? SERVO_CALIB_REG_MAX : result;
+    _start_phase( calib, SERVO_CALIB_OPEN );
+  }
+  else
+  {
+    calib->open_result = calib->regulation > SERVO_CALIB_MARGIN ? calib->regulation - SERVO_CALIB_MARGIN : 0;
+    calib->phase = SERVO_CALIB_DONE;
+  }
+}
+
+void servoCalibStart( servo_calib_t* calib, uint32_t max_mv )
+{
+  assert( calib );
+  _start_phase( calib, SERVO_CALIB_CLOSE );
+  calib->max_mv = max_mv;
+  calib->close_result = 0;
+  calib->open_result = 0;
+}
+
+servo_calib_phase_t servoCalibStep( servo_calib_t* calib, uint32_t sense_mv )
+{
+  assert( calib );
+
+  if ( calib->phase != SERVO_CALIB_CLOSE && calib->phase != SERVO_CALIB_OPEN )
+  {
+    return calib->phase;
+  }
+
+  /* Servo needs time to reach new position, current spikes while moving */
+  uint8_t settle = calib->baseline_cnt < SERVO_CALIB_BASELINE_CNT ? SERVO_CALIB_START_SETTLE : SERVO_CALIB_SETTLE;
+
+  if ( calib->settle < settle )
+  {
+    calib->settle++;
+    return calib->phase;
+  }
+
+  if ( sense_mv > calib->max_mv )
+  {
+    calib->phase = SERVO_CALIB_OVERCURRENT;
+    return calib->phase;
+  }
+
+  /* Start position is far from stops, current there is the free running reference */
+  if ( calib->baseline_cnt < SERVO_CALIB_BASELINE_CNT )
+  {
+    calib->baseline_sum += sense_mv;
+    calib->baseline_cnt++;
+
+    if ( calib->baseline_cnt == SERVO_CALIB_BASELINE_CNT )
+    {
+      calib->baseline_mv = calib->baseline_sum / SERVO_CALIB_BASELINE_CNT;
+      _next_step( calib );
+    }
+
+    return calib->phase;
+  }
+
+  if ( sense_mv > calib->baseline_mv + SERVO_CALIB_STALL_MV )
+  {
+    if ( ++calib->stall_cnt >= SERVO_CALIB_STALL_CNT )
+    {
+      _store_endpoint( calib );
+    }
+
+    return calib->phase;
+  }
+
+  calib->stall_cnt = 0;
+  calib->baseline_mv = ( calib->baseline_mv * ( SERVO_CALIB_TRACK_DIV - 1 ) + sense_mv ) / SERVO_CALIB_TRACK_DIV;
+
+  if ( !_next_step( calib ) )
+  {
+    calib->phase = SERVO_CALIB_FAILED;
+  }
+
+  return calib->phase;
+}
@@ -0,0 +1,63 @@
+/**
+ *******************************************************************************
+ * @file    servo_calib.h
+ * @brief   Servo endpoint search by stall current, no hardware dependency
+ *******************************************************************************
+ */
+
+#ifndef _SERVO_CALIB_H
+#define _SERVO_CALIB_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Regulation values as in PARAM_CLOSE/OPEN_SERVO_REGULATION, 0..99 */
+#define SERVO_CALIB_REG_MAX      99
+#define SERVO_CALIB_START_CLOSE  70
+#define SERVO_CALIB_START_OPEN   30
+#define SERVO_CALIB_STEP         2
+#define SERVO_CALIB_MARGIN       4
+#define SERVO_CALIB_SETTLE       3
+#define SERVO_CALIB_START_SETTLE 10
+#define SERVO_CALIB_BASELINE_CNT 4
+#define SERVO_CALIB_STALL_MV     200
+#define SERVO_CALIB_STALL_CNT    3
+/* Baseline follows free running samples by 1/N per step, supply drift is not a stall */
+#define SERVO_CALIB_TRACK_DIV    4
+
+typedef enum
+{
+  SERVO_CALIB_CLOSE,
+  SERVO_CALIB_OPEN,
+  SERVO_CALIB_DONE,
+  SERVO_CALIB_FAILED,
+  SERVO_CALIB_OVERCURRENT,
+} servo_calib_phase_t;
+
+typedef struct
+{
+  servo_calib_phase_t phase;
+  uint8_t regulation;
+  uint8_t settle;
+  uint8_t stall_cnt;
+  uint8_t baseline_cnt;
+  uint32_t baseline_sum;
+  uint32_t baseline_mv;
+  uint32_t max_mv;
+  uint8_t close_result;
+  uint8_t open_result;
+} servo_calib_t;
+
+/*
+ * max_mv - hard limit on settled sense samples, ends calibration in SERVO_CALIB_OVERCURRENT.
+ * Checked against absolute value, catches stall that baseline tracking followed.
+ */
+void servoCalibStart( servo_calib_t* calib, uint32_t max_mv );
+
+/*
+ * Feed one servo sense sample per step, in mV as PARAM_VOLTAGE_SERVO.
+ * Regulation to apply for active endpoint is in calib->regulation.
+ */
+servo_calib_phase_t servoCalibStep( servo_calib_t* calib, uint32_t sense_mv );
+
+#endif
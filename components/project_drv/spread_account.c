@@ -0,0 +1,165 @@
+#include "spread_account.h"
+
+#include <stddef.h>
+
+#include "app_config.h"
+#include "deadline.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "param_access.h"
+#include "param_persist.h"
+
+#define MODULE_NAME "[Spread] "
+#define DEBUG_LVL   PRINT_INFO
+
+#if CONFIG_DEBUG_SERVER_CONTROLLER
+#define LOG( _lvl, ... ) \
+  debug_printf( DEBUG_LVL, _lvl, MODULE_NAME __VA_ARGS__ )
+#else
+#define LOG( PRINT_INFO, ... )
+#endif
+
+#define ARRAY_SIZE( _a )      ( sizeof( _a ) / sizeof( _a[0] ) )
+#define PERSIST_PERIOD_MS     ( 60 * 1000 )
+#define MS_PER_MIN            ( 60 * 1000 )
+#define MG_PER_KG             1000000
+#define MG_PER_SESSION_UNIT   10000
+
+/* Servo opening to flow in g/s at full disc speed, scaled by PARAM_FLOW_CALIBRATION */
+static const spread_flow_point_t servo_flow[] =
+  {
+    { .input_percent = 0,   .output = 0    },
+    { .input_percent = 10,  .output = 50   },
+    { .input_percent = 20,  .output = 150  },
+    { .input_percent = 40,  .output = 450  },
+    { .input_percent = 60,  .output = 900  },
+    { .input_percent = 80,  .output = 1400 },
+    { .input_percent = 100, .output = 2000 },
+};
+
+/* Motor duty to flow factor in permille, slow disc lets less material through */
+static const spread_flow_point_t motor_factor[] =
+  {
+    { .input_percent = 0,   .output = 0    },
+    { .input_percent = 1,   .output = 800  },
+    { .input_percent = 50,  .output = 950  },
+    { .input_percent = 100, .output = 1000 },
+};
+
+typedef struct
+{
+  bool working;
+  TickType_t last_tick;
+  deadline_t persist_timer;
+  uint64_t total_mg;
+  uint64_t session_mg;
+  uint32_t mass_rest;
+  uint64_t total_ms;
+  uint32_t session_ms;
+} spread_account_ctx_t;
+
+static spread_account_ctx_t ctx;
+
+static uint32_t _interpolate( const spread_flow_point_t* table, size_t size, uint8_t input )
+{
+  if ( input >= table[size - 1].input_percent )
+  {
+    return table[size - 1].output;
+  }
+
+  for ( size_t i = 1; i < size; i++ )
+  {
+    if ( input < table[i].input_percent )
+    {
+      uint32_t span_in = table[i].input_percent - table[i - 1].input_percent;
+      int32_t span_out = (int32_t) table[i].output - table[i - 1].output;
+      return table[i - 1].output + span_out * ( input - table[i - 1].input_percent ) / (int32_t) span_in;
+    }
+  }
+
+  return table[0].output;
+}
+
+static void _publish( void )
+{
+  PARAM_MASS_TOTAL_set( ctx.total_mg / MG_PER_KG );
+  PARAM_WORK_TIME_set( ctx.total_ms / MS_PER_MIN );
+  PARAM_SESSION_MASS_set( ctx.session_mg / MG_PER_SESSION_UNIT );
+  PARAM_SESSION_TIME_set( ctx.session_ms / MS_PER_MIN );
+}
+
+static void _persist( void )
+{
+  paramPersistMarkDirty( PARAM_MASS_TOTAL );
+  paramPersistMarkDirty( PARAM_WORK_TIME );
+  deadlineArm( &ctx.persist_timer, PERSIST_PERIOD_MS );
+}
+
+void spreadAccountInit( void )
+{
+  ctx.total_mg = (uint64_t) PARAM_MASS_TOTAL_get() * MG_PER_KG;
+  ctx.total_ms = (uint64_t) PARAM_WORK_TIME_get() * MS_PER_MIN;
+  ctx.last_tick = xTaskGetTickCount();
+  PARAM_SESSION_MASS_set( 0 );
+  PARAM_SESSION_TIME_set( 0 );
+}
+
+uint32_t spreadAccountFlowMgPerS( uint8_t servo_open, uint8_t motor_duty )
+{
+  uint32_t flow_g = _interpolate( servo_flow, ARRAY_SIZE( servo_flow ), servo_open );
+  uint32_t factor = _interpolate( motor_factor, ARRAY_SIZE( motor_factor ), motor_duty );
+
+  /* g/s * permille * percent gives mg/s / 100 */
+  return flow_g * factor * PARAM_FLOW_CALIBRATION_get() / 100;
+}
+
+void spreadAccountUpdate( bool working, uint8_t servo_open, uint8_t motor_duty )
+{
+  spreadAccountUpdateAt( xTaskGetTickCount(), working, servo_open, motor_duty );
+}
+
+void spreadAccountUpdateAt( TickType_t now, bool working, uint8_t servo_open, uint8_t motor_duty )
+{
+  uint32_t dt_ms = ST2MS( now - ctx.last_tick );
+
+  ctx.last_tick = now;
+
+  if ( working && !ctx.working )
+  {
+    ctx.session_mg = 0;
+    ctx.session_ms = 0;
+    deadlineArmAt( &ctx.persist_timer, now, PERSIST_PERIOD_MS );
+    LOG( PRINT_INFO, "Session start" );
+  }
+
+  if ( !working )
+  {
+    if ( ctx.working )
+    {
+      _publish();
+      _persist();
+      LOG( PRINT_INFO, "Session end %lu kg", (uint32_t) ( ctx.session_mg / MG_PER_KG ) );
+    }
+
+    ctx.working = false;
+    return;
+  }
+
+  ctx.working = true;
+
+  /* mg/s * ms, whole mg carried to totals, rest kept for next cycle */
+  uint64_t mass = (uint64_t) spreadAccountFlowMgPerS( servo_open, motor_duty ) * dt_ms + ctx.mass_rest;
+  uint64_t mass_mg = mass / 1000;
+
+  ctx.mass_rest = mass % 1000;
+  ctx.total_mg += mass_mg;
+  ctx.session_mg += mass_mg;
+  ctx.total_ms += dt_ms;
+  ctx.session_ms += dt_ms;
+  _publish();
+
+  if ( deadlineExpiredAt( &ctx.persist_timer, now ) )
+  {
+    _persist();
+  }
+}
@@ -0,0 +1,30 @@
+/**
+ *******************************************************************************
+ * @file    spread_account.h
+ * @brief   Applied mass and working time totals from estimated flow
+ *******************************************************************************
+ */
+
+#ifndef _SPREAD_ACCOUNT_H
+#define _SPREAD_ACCOUNT_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "freertos/FreeRTOS.h"
+
+/* Flow point for servo opening or motor duty, table sorted by increasing input */
+typedef struct
+{
+  uint8_t input_percent;
+  uint16_t output;
+} spread_flow_point_t;
+
+void spreadAccountInit( void );
+
+/* Called each controller cycle, inputs in percent */
+void spreadAccountUpdate( bool working, uint8_t servo_open, uint8_t motor_duty );
+void spreadAccountUpdateAt( TickType_t now, bool working, uint8_t servo_open, uint8_t motor_duty );
+uint32_t spreadAccountFlowMgPerS( uint8_t servo_open, uint8_t motor_duty );
+
+#endif
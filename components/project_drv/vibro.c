@@ -1,10 +1,21 @@
 #include "vibro.h"
 
 #include "app_config.h"
+#include "deadline.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 
 vibro_t vibroD;
+static TaskHandle_t vibro_task;
+static deadline_t phase_end;
+
+static void _wake( void )
+{
+  if ( vibro_task != NULL )
+  {
+    xTaskNotifyGive( vibro_task );
+  }
+}
 
 #if MENU_VIRO_ON_OFF_VERSION
 void vibro_config( uint32_t vibro_on_ms, uint32_t vibro_off_ms )
@@ -12,17 +23,28 @@ void vibro_config( uint32_t vibro_on_ms, uint32_t vibro_off_ms )
 void vibro_config( uint32_t period, uint32_t filling )
 #endif
 {
+  bool changed;
+
 #if MENU_VIRO_ON_OFF_VERSION
+  changed = ( vibroD.vibro_on_ms != vibro_on_ms ) || ( vibroD.vibro_off_ms != vibro_off_ms );
   vibroD.vibro_on_ms = vibro_on_ms;
   vibroD.vibro_off_ms = vibro_off_ms;
 #else
-  vibroD.period = period < 10 ? 10 : period;
-  vibroD.filling = filling > 100 ? 100 : filling;
+  period = period < 10 ? 10 : period;
+  filling = filling > 100 ? 100 : filling;
+  changed = ( vibroD.period != period ) || ( vibroD.filling != filling );
+  vibroD.period = period;
+  vibroD.filling = filling;
 #endif
   if ( vibroD.state < VIBRO_STATE_CONFIGURED )
   {
     vibroD.state = VIBRO_STATE_CONFIGURED;
   }
+
+  if ( changed )
+  {
+    _wake();
+  }
 }
 
 void vibro_start( void )
@@ -32,7 +54,11 @@ void vibro_start( void )
     return;
   }
 
-  vibroD.state = VIBRO_STATE_START;
+  if ( vibroD.state != VIBRO_STATE_START )
+  {
+    vibroD.state = VIBRO_STATE_START;
+    _wake();
+  }
 }
 
 void vibro_stop( void )
@@ -42,8 +68,12 @@ void vibro_stop( void )
     return;
   }
 
-  vibroD.state = VIBRO_STATE_STOP;
-  vibroD.type = VIBRO_TYPE_OFF;
+  if ( vibroD.state != VIBRO_STATE_STOP )
+  {
+    vibroD.state = VIBRO_STATE_STOP;
+    vibroD.type = VIBRO_TYPE_OFF;
+    _wake();
+  }
 }
 
 uint8_t vibro_is_on( void )
@@ -56,75 +86,74 @@ uint8_t vibro_is_started( void )
   return vibroD.state == VIBRO_STATE_START;
 }
 
-static void vibro_process( void* pv )
+static uint32_t _on_ms( void )
 {
-  while ( 1 )
-  {
-    if ( vibroD.filling == 0 )
-    {
-      vibroD.type = VIBRO_TYPE_OFF;
-      vTaskDelay( MS2ST( 100 ) );
-      continue;
-    }
-
-    if ( vibroD.state == VIBRO_STATE_START )
-    {
-      vibroD.type = VIBRO_TYPE_ON;
-      vibroD.vibro_on_start_time = xTaskGetTickCount();
-
-      while ( vibroD.state == VIBRO_STATE_START )
-      {
 #if MENU_VIRO_ON_OFF_VERSION
-        if ( vibroD.vibro_on_start_time + MS2ST( vibroD.vibro_on_ms ) < xTaskGetTickCount() )
-        {
-          break;
-        }
+  return vibroD.vibro_on_ms;
 #else
-        uint32_t vibro_on_ms = vibroD.period * vibroD.filling / 100;
-        if ( vibroD.vibro_on_start_time + MS2ST( vibro_on_ms ) < xTaskGetTickCount() )
-        {
-          break;
-        }
+  return vibroD.period * vibroD.filling / 100;
 #endif
-        osDelay( 100 );
-      }
-#if MENU_VIRO_ON_OFF_VERSION
-      if ( vibroD.vibro_off_ms != 0 )
-#else
-      if ( vibroD.filling != 0 )
-#endif
-      {
-        vibroD.type = VIBRO_TYPE_OFF;
-        vibroD.vibro_off_start_time = xTaskGetTickCount();
-        while ( vibroD.state == VIBRO_STATE_START )
-        {
+}
+
+static uint32_t _off_ms( void )
+{
 #if MENU_VIRO_ON_OFF_VERSION
-          if ( vibroD.vibro_off_start_time + MS2ST( vibroD.vibro_off_ms ) < xTaskGetTickCount() )
-          {
-            break;
-          }
+  return vibroD.vibro_off_ms;
 #else
-          uint32_t vibro_off_ms = ( vibroD.period - vibroD.period * vibroD.filling / 100 );
-          if ( vibroD.vibro_off_start_time + MS2ST( vibro_off_ms ) < xTaskGetTickCount() )
-          {
-            break;
-          }
+  return vibroD.period - vibroD.period * vibroD.filling / 100;
 #endif
-          osDelay( 100 );
-        }
-      }
-    }
-    else
-    {
-      vibroD.type = VIBRO_TYPE_OFF;
-      vTaskDelay( MS2ST( 100 ) );
-    }
+}
+
+/* Sets output for current phase, phase length is rechecked on every call, returns ticks to phase end */
+static TickType_t _vibro_phase( void )
+{
+  if ( ( vibroD.state != VIBRO_STATE_START ) || ( _on_ms() == 0 ) )
+  {
+    vibroD.type = VIBRO_TYPE_OFF;
+    deadlineDisarm( &phase_end );
+    return portMAX_DELAY;
+  }
+
+  if ( !deadlineIsArmed( &phase_end ) )
+  {
+    vibroD.type = VIBRO_TYPE_ON;
+    vibroD.phase_start_time = xTaskGetTickCount();
+  }
+  else if ( deadlineExpired( &phase_end ) )
+  {
+    vibroD.type = ( ( vibroD.type == VIBRO_TYPE_ON ) && ( _off_ms() != 0 ) ) ? VIBRO_TYPE_OFF : VIBRO_TYPE_ON;
+    vibroD.phase_start_time = xTaskGetTickCount();
+  }
+
+  deadlineArmAt( &phase_end, vibroD.phase_start_time, vibroD.type == VIBRO_TYPE_ON ? _on_ms() : _off_ms() );
+
+  /* Phase shorter than a tick must still block */
+  TickType_t wait = deadlineRemaining( &phase_end );
+  return wait == 0 ? 1 : wait;
+}
+
+void vibro_step( void )
+{
+  _vibro_phase();
+}
+
+#if !CONFIG_CONTROLLER_EXECUTIVE
+/* Sleeps until phase end or until start/stop/config wakes it */
+static void vibro_process( void* pv )
+{
+  while ( 1 )
+  {
+    ulTaskNotifyTake( pdTRUE, _vibro_phase() );
   }
 }
+#endif
 
 void vibro_init( void )
 {
   memset( &vibroD, 0, sizeof( vibroD ) );
   vibroD.state = VIBRO_STATE_READY;
-  xTaskCreate( vibro_process, "vibro_process", 4096, NULL, 10, NULL );
+#if !CONFIG_CONTROLLER_EXECUTIVE
+  xTaskCreatePinnedToCore( vibro_process, "vibro_process", VIBRO_TASK_STACK, NULL, VIBRO_TASK_PRIO, &vibro_task,
+                           TASK_CORE( CONTROL_CORE ) );
+#endif
 }
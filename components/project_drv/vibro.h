@@ -30,8 +30,7 @@ typedef struct
   uint32_t period;
   uint32_t filling;
 #endif
-  uint32_t vibro_on_start_time;
-  uint32_t vibro_off_start_time;
+  uint32_t phase_start_time;
 } vibro_t;
 
 #if MENU_VIRO_ON_OFF_VERSION
@@ -43,6 +42,8 @@ void vibro_config( uint32_t period, uint32_t filling );
 void vibro_start( void );
 void vibro_stop( void );
 void vibro_init( void );
+/* Phase update, called by controller executive instead of vibro task */
+void vibro_step( void );
 uint8_t vibro_is_on( void );
 uint8_t vibro_is_started( void );
 
@@ -82,6 +82,10 @@
 #define CONFIG_DEBUG_SERVER_CONTROLLER TRUE
 #define CONFIG_DEBUG_MENU_BACKEND      TRUE
 #define CONFIG_DEBUG_SLEEP             TRUE
+#define CONFIG_DEBUG_BOOT_TRACE        TRUE
+#define CONFIG_DEBUG_PARAM_PERSIST     TRUE
+#define CONFIG_DEBUG_TASK_PROFILER     TRUE
+#define CONFIG_DEBUG_PARAM_BRIDGE      TRUE
 
 /////////////////////  CONFIG PERIPHERALS  ////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////////////////
@@ -101,6 +105,86 @@
 #define MOTOR_LED_SET_GREEN( x )       set_motor_green_led( x );
 #define SERVO_VIBRO_LED_SET_GREEN( x ) set_servo_green_led( x );
 
+///////////////////////////////////////////////////////////////////////////////////////////
+//// LOW POWER
+// PM and tickless idle are enabled in shared sdkconfig, light sleep is configured only on panel by lowPowerInit(),
+// controller pins PM to full clock without light sleep in main.c
+// Panel button interrupt line (active low, input only pin) waking panel from light sleep
+#define BUTTON_WAKEUP_PIN      GPIO_NUM_34
+#define LOW_POWER_MIN_FREQ_MHZ 40
+
+///////////////////////////////////////////////////////////////////////////////////////////
+//// ROLE
+// Strap pin forcing device role, GPIO_NUM_NC to detect role by display probe
+#define ROLE_STRAP_PIN          GPIO_NUM_NC
+#define ROLE_STRAP_CLIENT_LEVEL 0
+// Probe waits at least 2 ticks, controller is chosen only when every attempt gets NACK
+#define ROLE_PROBE_TIMEOUT_MS   20
+#define ROLE_PROBE_ATTEMPTS     3
+#define ROLE_PROBE_RETRY_MS     20
+
+///////////////////////////////////////////////////////////////////////////////////////////
+//// HISTORY EXPORT
+// Own small server so a long export does not occupy parameter API sockets
+#define HISTORY_EXPORT_PORT      8081
+#define HISTORY_EXPORT_CTRL_PORT 32769
+#define HISTORY_EXPORT_STACK     3072
+#define HISTORY_EXPORT_PRIO      ( NORMALPRIO - 1 )
+
+///////////////////////////////////////////////////////////////////////////////////////////
+//// PARAM PERSIST
+// Parameter writes are stored together after delay, power off flushes at once
+#define PARAM_PERSIST_DELAY_MS      5000
+#define PARAM_PERSIST_MAX_ID        128
+#define PARAM_PERSIST_COMPACT_COUNT 32
+
+///////////////////////////////////////////////////////////////////////////////////////////
+//// TASKS
+// Stack in bytes, task profiler warns when less than half of it is ever used
+#define MEASURE_TASK_STACK      4096
+#define MEASURE_TASK_PRIO       10
+#define CONTROLLER_TASK_STACK   4096
+#define CONTROLLER_TASK_PRIO    10
+#define ERROR_TASK_STACK        4096
+#define ERROR_TASK_PRIO         NORMALPRIO
+#define VIBRO_TASK_STACK        4096
+#define VIBRO_TASK_PRIO         10
+#define MENU_BACKEND_TASK_STACK 4096
+#define MENU_BACKEND_TASK_PRIO  5
+#define TASK_PROFILER_STACK     3072
+#define TASK_PROFILER_PRIO      1
+#define TASK_PROFILER_PERIOD_MS 10000
+
+///////////////////////////////////////////////////////////////////////////////////////////
+//// CONTROLLER EXECUTIVE
+// TRUE runs measurement, fault check, control and vibro as one pipeline in a single task
+#define CONFIG_CONTROLLER_EXECUTIVE  FALSE
+#define CONTROLLER_EXEC_TICK_MS      50
+#define CONTROLLER_EXEC_MEASURE_DIV  2
+#define CONTROLLER_EXEC_REPORT_TICKS 200
+#define CONTROLLER_EXEC_STACK        4096
+#define CONTROLLER_EXEC_PRIO         10
+
+///////////////////////////////////////////////////////////////////////////////////////////
+//// CORE AFFINITY
+// Measurement, control and fault tasks run on control core, Wi-Fi driver is pinned
+// to core 0 by sdkconfig so network side stays there. Telemetry published from
+// control core reaches parameters through SPSC queues drained on network core.
+#define CONFIG_TASK_AFFINITY   TRUE
+#define NETWORK_CORE           0
+#define CONTROL_CORE           1
+#define PARAM_BRIDGE_PRODUCERS 2
+#define PARAM_BRIDGE_QUEUE_LEN 32
+#define PARAM_BRIDGE_PERIOD_MS 20
+#define PARAM_BRIDGE_STACK     3072
+#define PARAM_BRIDGE_PRIO      NORMALPRIO
+
+#if CONFIG_TASK_AFFINITY && !CONFIG_FREERTOS_UNICORE
+#define TASK_CORE( _core ) ( _core )
+#else
+#define TASK_CORE( _core ) tskNO_AFFINITY
+#endif
+
 //////////////////////////////////////  END  //////////////////////////////////////////////
 
 #define NORMALPRIO 5
@@ -0,0 +1,99 @@
+#include "boot_trace.h"
+
+#include "app_config.h"
+#include "esp_timer.h"
+
+#define MODULE_NAME "[BOOT] "
+#define DEBUG_LVL   PRINT_INFO
+
+#if CONFIG_DEBUG_BOOT_TRACE
+#define LOG( _lvl, ... ) \
+  debug_printf( DEBUG_LVL, _lvl, MODULE_NAME __VA_ARGS__ )
+#else
+#define LOG( PRINT_INFO, ... )
+#endif
+
+typedef struct
+{
+  boot_trace_entry_t ring[BOOT_TRACE_SIZE];
+  uint8_t head;
+  uint8_t count;
+  uint32_t last_time_ms;
+  uint32_t over_budget;
+} boot_trace_ctx_t;
+
+static boot_trace_ctx_t ctx;
+static portMUX_TYPE boot_trace_lock = portMUX_INITIALIZER_UNLOCKED;
+
+void bootTraceMark( const char* name, uint32_t budget_ms )
+{
+  uint32_t now_ms = (uint32_t) ( esp_timer_get_time() / 1000 );
+  boot_trace_entry_t entry =
+    {
+      .name = name,
+      .time_ms = now_ms,
+      .budget_ms = budget_ms,
+    };
+
+  portENTER_CRITICAL( &boot_trace_lock );
+  entry.duration_ms = now_ms - ctx.last_time_ms;
+  ctx.last_time_ms = now_ms;
+  ctx.ring[ctx.head] = entry;
+  ctx.head = ( ctx.head + 1 ) % BOOT_TRACE_SIZE;
+  if ( ctx.count < BOOT_TRACE_SIZE )
+  {
+    ctx.count++;
+  }
+
+  bool over_budget = budget_ms != BOOT_TRACE_NO_BUDGET && entry.duration_ms > budget_ms;
+  if ( over_budget )
+  {
+    ctx.over_budget++;
+  }
+
+  portEXIT_CRITICAL( &boot_trace_lock );
+
+  if ( over_budget )
+  {
+    LOG( PRINT_WARNING, "%s %ld ms > %ld", name, entry.duration_ms, budget_ms );
+  }
+}
+
+uint8_t bootTraceGetCount( void )
+{
+  return ctx.count;
+}
+
+bool bootTraceGetEntry( uint8_t idx, boot_trace_entry_t* entry )
+{
+  bool ret = false;
+
+  assert( entry );
+  portENTER_CRITICAL( &boot_trace_lock );
+  if ( idx < ctx.count )
+  {
+    /* Index 0 is the oldest entry */
+    *entry = ctx.ring[( ctx.head + BOOT_TRACE_SIZE - ctx.count + idx ) % BOOT_TRACE_SIZE];
+    ret = true;
+  }
+
+  portEXIT_CRITICAL( &boot_trace_lock );
+  return ret;
+}
+
+uint32_t bootTraceGetOverBudgetCount( void )
+{
+  return ctx.over_budget;
+}
+
+void bootTraceDump( void )
+{
+  boot_trace_entry_t entry;
+
+  for ( uint8_t i = 0; bootTraceGetEntry( i, &entry ); i++ )
+  {
+    LOG( PRINT_INFO, "%5ld +%4ld %s", entry.time_ms, entry.duration_ms, entry.name );
+  }
+
+  LOG( PRINT_INFO, "Over budget %ld", ctx.over_budget );
+}
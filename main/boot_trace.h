@@ -0,0 +1,32 @@
+/**
+ *******************************************************************************
+ * @file    boot_trace.h
+ * @brief   Boot phase timestamps kept in RAM ring
+ *******************************************************************************
+ */
+
+#ifndef _BOOT_TRACE_H
+#define _BOOT_TRACE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define BOOT_TRACE_SIZE      32
+#define BOOT_TRACE_NO_BUDGET 0
+
+typedef struct
+{
+  const char* name;
+  uint32_t time_ms;
+  uint32_t duration_ms;
+  uint32_t budget_ms;
+} boot_trace_entry_t;
+
+/* Phase duration is counted from previous mark, budget 0 means no limit */
+void bootTraceMark( const char* name, uint32_t budget_ms );
+uint8_t bootTraceGetCount( void );
+bool bootTraceGetEntry( uint8_t idx, boot_trace_entry_t* entry );
+uint32_t bootTraceGetOverBudgetCount( void );
+void bootTraceDump( void );
+
+#endif
@@ -0,0 +1,81 @@
+/**
+ *******************************************************************************
+ * @file    deadline.h
+ * @brief   Wrap safe tick deadlines
+ *******************************************************************************
+ */
+
+#ifndef _DEADLINE_H
+#define _DEADLINE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "app_config.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+/*
+ * Zero initialized deadline is not armed and counts as expired,
+ * same as old code comparing against a timer left at 0.
+ * Expiry is compared as signed tick difference, valid for spans below 2^31 ticks.
+ */
+typedef struct
+{
+  TickType_t expiry;
+  bool armed;
+} deadline_t;
+
+static inline void deadlineArmAt( deadline_t* deadline, TickType_t start, uint32_t ms )
+{
+  deadline->expiry = start + MS2ST( ms );
+  deadline->armed = true;
+}
+
+static inline void deadlineArm( deadline_t* deadline, uint32_t ms )
+{
+  deadlineArmAt( deadline, xTaskGetTickCount(), ms );
+}
+
+static inline void deadlineDisarm( deadline_t* deadline )
+{
+  deadline->armed = false;
+}
+
+static inline bool deadlineIsArmed( const deadline_t* deadline )
+{
+  return deadline->armed;
+}
+
+static inline bool deadlineExpiredAt( const deadline_t* deadline, TickType_t now )
+{
+  return !deadline->armed || (int32_t) ( now - deadline->expiry ) >= 0;
+}
+
+static inline bool deadlineExpired( const deadline_t* deadline )
+{
+  return deadlineExpiredAt( deadline, xTaskGetTickCount() );
+}
+
+/* Ticks left, 0 when expired */
+static inline TickType_t deadlineRemaining( const deadline_t* deadline )
+{
+  TickType_t now = xTaskGetTickCount();
+
+  if ( deadlineExpiredAt( deadline, now ) )
+  {
+    return 0;
+  }
+
+  return deadline->expiry - now;
+}
+
+/* Block time for notify or queue wait, sleeps until expiry but not longer than max_ticks */
+static inline TickType_t deadlineWaitTicks( const deadline_t* deadline, TickType_t max_ticks )
+{
+  TickType_t remaining = deadlineRemaining( deadline );
+
+  return remaining < max_ticks ? remaining : max_ticks;
+}
+
+#endif
@@ -2,10 +2,14 @@
 
 #include "app_config.h"
 #include "battery.h"
+#include "boot_trace.h"
 #include "but.h"
 #include "buzzer.h"
 #include "cmd_client.h"
 #include "cmd_server.h"
+#include "controller_exec.h"
+#include "controller_session.h"
+#include "device_list.h"
 #include "dictionary.h"
 #include "driver/gpio.h"
 #include "driver/i2c.h"
@@ -13,29 +17,39 @@
 #include "error_siewnik.h"
 #include "error_solarka.h"
 #include "esp_attr.h"
+#include "esp_pm.h"
 #include "esp_sleep.h"
 #include "esp_system.h"
 #include "fast_add.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "history_export.h"
 #include "http_parameters_client.h"
 #include "http_server.h"
 #include "intf/i2c/ssd1306_i2c.h"
 #include "keepalive.h"
+#include "low_power.h"
 #include "measure.h"
 #include "menu_backend.h"
 #include "menu_drv.h"
 #include "motor.h"
+#include "nvs.h"
 #include "nvs_flash.h"
 #include "oled.h"
 #include "ota_drv.h"
+#include "param_bridge.h"
+#include "param_persist.h"
+#include "param_snapshot.h"
 #include "parameters.h"
 #include "parameters_api.h"
 #include "pcf8574.h"
 #include "power_on.h"
 #include "pwm_drv.h"
+#include "role_detect.h"
 #include "server_controller.h"
 #include "sleep_e.h"
+#include "soc_estimator.h"
+#include "task_profiler.h"
 #include "ssd1306.h"
 #include "vibro.h"
 #include "wifi_menu.h"
@@ -47,10 +61,13 @@ static gpio_config_t io_conf;
 static uint32_t blink_pin = GPIO_NUM_23;
 portMUX_TYPE portMux = portMUX_INITIALIZER_UNLOCKED;
 static uint8_t wifi_type;
+static bool role_verify_req;
 
-static bool check_i2c_communication( void )
+#define ROLE_NVS_NAMESPACE "boot"
+#define ROLE_NVS_KEY       "role"
+
+static esp_err_t _i2c_probe( void )
 {
-  ssd1306_i2cInitEx( I2C_MASTER_SCL_IO, I2C_MASTER_SDA_IO, SSD1306_I2C_ADDR );
   uint8_t s_i2c_addr = 0x3C;
   int ret;
   i2c_cmd_handle_t cmd = i2c_cmd_link_create();
@@ -58,10 +75,18 @@ static bool check_i2c_communication( void )
   i2c_master_write_byte( cmd, ( s_i2c_addr << 1 ) | I2C_MASTER_WRITE, 0x1 );
   i2c_master_write_byte( cmd, 0x00, 0x1 );
   i2c_master_stop( cmd );
-  ret = i2c_master_cmd_begin( I2C_NUM_1, cmd, MS2ST( 1000 ) );
+  /* One tick timeout can expire at once, wait at least two */
+  TickType_t timeout = MS2ST( ROLE_PROBE_TIMEOUT_MS );
+  ret = i2c_master_cmd_begin( I2C_NUM_1, cmd, timeout < 2 ? 2 : timeout );
   i2c_cmd_link_delete( cmd );
   printf( "I2C TEST %d\n\r", ret );
-  return ret == ESP_OK;
+  return ret;
+}
+
+static uint8_t _probe_role( bool* confirmed )
+{
+  ssd1306_i2cInitEx( I2C_MASTER_SCL_IO, I2C_MASTER_SDA_IO, SSD1306_I2C_ADDR );
+  return roleDetectProbe( _i2c_probe, confirmed );
 }
 
 void debug_function_name( const char* name )
@@ -86,21 +111,90 @@ void graphic_init( void )
   oled_init();
 }
 
-static void checkDevType( void )
+static bool _read_role_hint( uint8_t* role )
 {
-  pcf8574_init();
-  bool read_i2c_value = check_i2c_communication();
-  if ( read_i2c_value )
+  nvs_handle_t handle;
+
+  if ( nvs_open( ROLE_NVS_NAMESPACE, NVS_READONLY, &handle ) != ESP_OK )
   {
-    wifi_type = T_WIFI_TYPE_CLIENT;
+    return false;
   }
-  else
+
+  esp_err_t err = nvs_get_u8( handle, ROLE_NVS_KEY, role );
+  nvs_close( handle );
+  return err == ESP_OK;
+}
+
+static void _store_role_hint( uint8_t role )
+{
+  nvs_handle_t handle;
+
+  if ( nvs_open( ROLE_NVS_NAMESPACE, NVS_READWRITE, &handle ) != ESP_OK )
   {
-    wifi_type = T_WIFI_TYPE_SERVER;
+    return;
   }
+
+  nvs_set_u8( handle, ROLE_NVS_KEY, role );
+  nvs_commit( handle );
+  nvs_close( handle );
+}
+
+static void _verify_role_task( void* arg )
+{
+  bool confirmed = false;
+  uint8_t role = _probe_role( &confirmed );
+
+  if ( roleDetectRestart( wifi_type, role, confirmed ) )
+  {
+    DevConfig_Printf( PRINT_DEBUG, PRINT_DEBUG, "[MENU] Role hint wrong, restart as %d", role );
+    _store_role_hint( role );
+    esp_restart();
+  }
+
+  vTaskDelete( NULL );
+}
+
+static void checkDevType( void )
+{
+  uint8_t hint = 0;
+  bool hint_valid = _read_role_hint( &hint );
+  bool confirmed = false;
+
+  pcf8574_init();
+  switch ( roleDetectSource( ROLE_STRAP_PIN != GPIO_NUM_NC, hint_valid, hint ) )
+  {
+    case ROLE_SOURCE_STRAP:
+      gpio_set_direction( ROLE_STRAP_PIN, GPIO_MODE_INPUT );
+      gpio_set_pull_mode( ROLE_STRAP_PIN, GPIO_PULLUP_ONLY );
+      wifi_type = gpio_get_level( ROLE_STRAP_PIN ) == ROLE_STRAP_CLIENT_LEVEL ? T_WIFI_TYPE_CLIENT : T_WIFI_TYPE_SERVER;
+      break;
+
+    case ROLE_SOURCE_HINT:
+      wifi_type = hint;
+      role_verify_req = true;
+      break;
+
+    default:
+      wifi_type = _probe_role( &confirmed );
+      if ( roleDetectStoreHint( hint_valid, hint, wifi_type, confirmed ) )
+      {
+        _store_role_hint( wifi_type );
+      }
+
+      break;
+  }
+
+  bootTraceMark( "role detect", 50 );
   wifiDrvSetWifiType( wifi_type );
 }
 
+static void _show_splash( void )
+{
+  oled_clearScreen();
+  oled_printFixed( 2, 0, dictionary_get_string( DICT_LOGO_CLIENT_NAME ), OLED_FONT_SIZE_16 );
+  oled_update();
+}
+
 static void _toggle_emergency_disable( void )
 {
   backendToggleEmergencyDisable();
@@ -108,9 +202,13 @@ static void _toggle_emergency_disable( void )
 
 void app_init( void )
 {
+  bootTraceMark( "app_main", BOOT_TRACE_NO_BUDGET );
   nvs_flash_init();
+  bootTraceMark( "nvs", 100 );
   DevConfig_Init();
+  bootTraceMark( "dev config", 50 );
   OTA_Init();
+  bootTraceMark( "ota", 50 );
 }
 
 static void _on_connect_cb( void )
@@ -118,18 +216,50 @@ static void _on_connect_cb( void )
   char ap_name[64] = {};
   wifiDrvGetAPName( ap_name );
   wifiMenu_SetDevType( ap_name );
+  controllerSessionSetForeground( ap_name );
+  backendSyncSession();
+}
+
+static void _full_power( void )
+{
+#if CONFIG_PM_ENABLE
+  /* sdkconfig is shared with panel, controller keeps PWM and control loop at full clock */
+  esp_pm_config_t pm_config =
+    {
+      .max_freq_mhz = CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ,
+      .min_freq_mhz = CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ,
+      .light_sleep_enable = false,
+    };
+
+  esp_err_t err = esp_pm_configure( &pm_config );
+
+  if ( err != ESP_OK )
+  {
+    printf( "PM configure %s\n\r", esp_err_to_name( err ) );
+  }
+#endif
 }
 
 static void _init_server( void )
 {
+  _full_power();
   parameters_setString( PARAM_STR_CONTROLLER_SN, DevConfig_GetSerialNumber() );
   wifiDrvInit();
+  bootTraceMark( "wifi init", 500 );
   keepAliveStartTask();
+  bootTraceMark( "task keepalive", 20 );
   parameters_init();
+  paramPersistInit();
+  taskProfilerInit();
+  paramBridgeInit();
+  bootTraceMark( "parameters", 100 );
 
   measure_start();
+  bootTraceMark( "task measure", 20 );
   srvrControllStart();
+  bootTraceMark( "task controller", 20 );
   ultrasonar_start();
+  bootTraceMark( "task ultrasonar", 20 );
 
 #if CONFIG_DEVICE_SIEWNIK
   errorSiewnikStart();
@@ -138,6 +268,12 @@ static void _init_server( void )
 #if CONFIG_DEVICE_SOLARKA
   errorSolarkaStart();
 #endif
+  bootTraceMark( "task error", 20 );
+
+#if CONFIG_CONTROLLER_EXECUTIVE
+  controllerExecStart();
+  bootTraceMark( "task executive", 20 );
+#endif
 
   //LED on
   io_conf.intr_type = GPIO_INTR_DISABLE;
@@ -151,20 +287,49 @@ static void _init_server( void )
   // cmdServerStartTask();
   HTTPServer_Init();
   ParametersAPI_Init();
+  historyExportStart();
+  bootTraceMark( "http server", 200 );
+
+  if ( role_verify_req )
+  {
+    xTaskCreate( _verify_role_task, "role_verify", 2048, NULL, 1, NULL );
+  }
+
+  bootTraceDump();
 }
 
 static void _init_client( void )
 {
   graphic_init();
-  menuBackendInit();
+  bootTraceMark( "display", 100 );
   battery_init();
-  init_leds();
-  osDelay( 10 );
 
+  /*
+   * Wi-Fi goes first, driver reconnects to AP cached in NVS in own task while
+   * parameters load and battery is measured. Connect callback looks up device
+   * list, it must exist before Wi-Fi can connect.
+   */
+  deviceListInit();
+  wifiDrvInit();
+  wifiDrvRegisterConnectCb( _on_connect_cb );
+  HTTPParamClient_Init();
+  bootTraceMark( "wifi init", 500 );
+
+  parameters_init();
+  paramPersistInit();
+  taskProfilerInit();
+  bootTraceMark( "parameters", 100 );
+  dictionary_init();
+  _show_splash();
+  bootTraceMark( "splash", 100 );
+
+  menuBackendInit();
+  init_leds();
   buzzer_init();
   power_on_init();
+  bootTraceMark( "task backend", 20 );
 
-  /* Wait to measure voltage */
+  /* Wait to measure voltage, usually done by now */
   while ( !battery_is_measured() )
   {
     osDelay( 10 );
@@ -173,23 +338,25 @@ static void _init_client( void )
   float voltage = battery_get_voltage();
   power_on_enable_system();
   init_buttons();
-  parameters_init();
+  bootTraceMark( "battery", 500 );
 
-  if ( voltage > 3.2 )
+  if ( socOcvToPermille( &soc_config_panel, (uint32_t) ( voltage * 1000 ) ) > 0 )
   {
+    /* Bootup menu enters start menu on first parameter batch */
     menuDrvInit( MENU_DRV_NORMAL_INIT, _toggle_emergency_disable );
-    wifiDrvInit();
-    wifiDrvRegisterConnectCb( _on_connect_cb );
-    osDelay( 1000 );
+    bootTraceMark( "task menu", 50 );
     keepAliveStartTask();
-    dictionary_init();
     fastProcessStartTask();
     power_on_start_task();
-    HTTPParamClient_Init();
+    bootTraceMark( "task client", 20 );
     init_sleep();
+    lowPowerInit();
+    bootTraceMark( "client init", 50 );
   }
   else
   {
+    /* Panel powers off, stop reconnecting started above */
+    wifiDrvDisconnect();
     menuDrvInit( MENU_DRV_LOW_BATTERY_INIT, _toggle_emergency_disable );
     power_on_disable_system();
   }
@@ -227,6 +394,13 @@ void app_main()
 
   DevConfig_Printf( PRINT_DEBUG, PRINT_DEBUG, "[MENU] ------------START SYSTEM-------------" );
   DevConfig_Printf( PRINT_DEBUG, PRINT_DEBUG, "[MENU] SN %s", DevConfig_GetSerialNumber() );
+
+  if ( wifi_type == T_WIFI_TYPE_CLIENT )
+  {
+    /* Panel has no status LED, do not keep main task waking the CPU */
+    return;
+  }
+
   while ( 1 )
   {
     _blink_led();
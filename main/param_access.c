@@ -0,0 +1,15 @@
+#include "param_access.h"
+
+enum
+{
+#define PARAM( _id, _min, _max, _def, _name ) PARAM_ACCESS_DEF_##_id = _def,
+  PARAMETERS_U32_LIST
+#undef PARAM
+};
+
+param_access_slot_t param_access_mirror[PARAM_ACCESS_SLOT_COUNT - 1] =
+  {
+#define SINGLE_WRITER( _id ) [PARAM_ACCESS_SLOT_##_id - 1] = { .value = PARAM_ACCESS_DEF_##_id },
+    PARAM_ACCESS_SINGLE_WRITER_LIST
+#undef SINGLE_WRITER
+};
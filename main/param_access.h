@@ -0,0 +1,148 @@
+/**
+ *******************************************************************************
+ * @file    param_access.h
+ * @brief   Typed accessors generated from PARAMETERS_U32_LIST
+ *******************************************************************************
+ */
+
+#ifndef _PARAM_ACCESS_H
+#define _PARAM_ACCESS_H
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "param_bridge.h"
+#include "param_snapshot.h"
+#include "parameters.h"
+#include "project_parameters.h"
+
+/* Smallest type holding max value of parameter */
+#define PARAM_ACCESS_TYPE( _max )                                                    \
+  __typeof__( __builtin_choose_expr(                                                 \
+    ( _max ) <= 1, (bool) 0,                                                         \
+    __builtin_choose_expr( ( _max ) <= 0xFF, (uint8_t) 0,                            \
+                           __builtin_choose_expr( ( _max ) <= 0xFFFF, (uint16_t) 0, (uint32_t) 0 ) ) ) )
+
+typedef enum
+{
+#define PARAM( _id, _min, _max, _def, _name ) PARAM_ACCESS_IDX_##_id,
+  PARAMETERS_U32_LIST
+#undef PARAM
+    PARAM_ACCESS_COUNT,
+} param_access_idx_t;
+
+/*
+ * IDs are list positions, used by HTTP parameter API and as persisted record keys.
+ * New parameters go to the end of PARAMETERS_U32_LIST, these catch an insert in the middle.
+ */
+_Static_assert( PARAM_ACCESS_IDX_PARAM_TRY_OPEN_CALIBRATION == 30, "parameter IDs shifted" );
+_Static_assert( PARAM_ACCESS_IDX_PARAM_SESSION_TIME == 38, "parameter IDs shifted" );
+_Static_assert( PARAM_ACCESS_IDX_PARAM_SERVO_AUTO_CALIBRATION == 39, "parameter IDs shifted" );
+_Static_assert( PARAM_ACCESS_IDX_PARAM_MOTOR_CURRENT_100 == 45, "parameter IDs shifted" );
+_Static_assert( PARAM_ACCESS_IDX_PARAM_CONTROL_LOOP_MAX_MS == 48, "parameter IDs shifted" );
+
+/*
+ * Parameters written only by their owning controller module, through <id>_publish() or <id>_set().
+ * Menu fills them from HTTP client into parameters, it reads them with parameters_getValue().
+ */
+#define PARAM_ACCESS_SINGLE_WRITER_LIST  \
+  SINGLE_WRITER( PARAM_VOLTAGE_SERVO )   \
+  SINGLE_WRITER( PARAM_CURRENT_MOTOR )   \
+  SINGLE_WRITER( PARAM_VOLTAGE_ACCUM )   \
+  SINGLE_WRITER( PARAM_TEMPERATURE )     \
+  SINGLE_WRITER( PARAM_ACCUM_SOC )       \
+  SINGLE_WRITER( PARAM_ACCUM_TIME_LEFT )
+
+/* Mirror slot of parameter, 0 for parameters the HTTP API writes directly */
+typedef enum
+{
+  PARAM_ACCESS_SLOT_NONE,
+#define SINGLE_WRITER( _id ) PARAM_ACCESS_SLOT_##_id,
+  PARAM_ACCESS_SINGLE_WRITER_LIST
+#undef SINGLE_WRITER
+    PARAM_ACCESS_SLOT_COUNT,
+} param_access_slot_idx_t;
+
+static const uint8_t param_access_slot[PARAM_ACCESS_COUNT] =
+  {
+#define SINGLE_WRITER( _id ) [PARAM_ACCESS_IDX_##_id] = PARAM_ACCESS_SLOT_##_id,
+    PARAM_ACCESS_SINGLE_WRITER_LIST
+#undef SINGLE_WRITER
+};
+
+/* ESP32 cache line, writers on different cores do not share a line */
+#define PARAM_ACCESS_LINE_SIZE 32
+
+typedef struct
+{
+  /* 32 bit aligned stores are atomic on Xtensa */
+  _Alignas( PARAM_ACCESS_LINE_SIZE ) _Atomic uint32_t value;
+} param_access_slot_t;
+
+extern param_access_slot_t param_access_mirror[PARAM_ACCESS_SLOT_COUNT - 1];
+
+static inline uint32_t paramAccessClamp( uint32_t value, uint32_t min, uint32_t max )
+{
+  if ( value < min )
+  {
+    return min;
+  }
+
+  if ( value > max )
+  {
+    return max;
+  }
+
+  return value;
+}
+
+/*
+ * For each parameter:
+ *  <id>_t           smallest type for the range
+ *  <id>_get()       typed value clamped to range, lock free from the mirror for single writer parameters
+ *  <id>_set()       clamped write moving snapshot sequence, folded at compile time for constant values
+ *  <id>_publish()   write from the only writer of a single writer parameter, updates the mirror,
+ *                   from bridge producer task parameters are written later on network core
+ * Slot lookups are constant per parameter and fold away.
+ */
+#define PARAM( _id, _min, _max, _def, _name )                                                    \
+  _Static_assert( ( _def ) >= ( _min ) && ( _def ) <= ( _max ), #_id " default out of range" );  \
+  typedef PARAM_ACCESS_TYPE( _max ) _id##_t;                                                     \
+  static inline _id##_t _id##_get( void )                                                        \
+  {                                                                                              \
+    uint8_t slot = param_access_slot[PARAM_ACCESS_IDX_##_id];                                    \
+    if ( slot != PARAM_ACCESS_SLOT_NONE )                                                        \
+    {                                                                                            \
+      return (_id##_t) atomic_load_explicit( &param_access_mirror[slot - 1].value, memory_order_acquire ); \
+    }                                                                                            \
+    return (_id##_t) paramAccessClamp( parameters_getValue( _id ), _min, _max );                 \
+  }                                                                                              \
+  static inline void _id##_set( uint32_t value )                                                 \
+  {                                                                                              \
+    uint8_t slot = param_access_slot[PARAM_ACCESS_IDX_##_id];                                    \
+    value = paramAccessClamp( value, _min, _max );                                               \
+    if ( slot != PARAM_ACCESS_SLOT_NONE )                                                        \
+    {                                                                                            \
+      atomic_store_explicit( &param_access_mirror[slot - 1].value, value, memory_order_release ); \
+    }                                                                                            \
+    paramSnapshotSet( _id, value );                                                              \
+  }                                                                                              \
+  static inline void _id##_publish( uint32_t value )                                             \
+  {                                                                                              \
+    uint8_t slot = param_access_slot[PARAM_ACCESS_IDX_##_id];                                    \
+    value = paramAccessClamp( value, _min, _max );                                               \
+    if ( slot != PARAM_ACCESS_SLOT_NONE )                                                        \
+    {                                                                                            \
+      atomic_store_explicit( &param_access_mirror[slot - 1].value, value, memory_order_release ); \
+    }                                                                                            \
+    if ( !paramBridgePost( _id, value ) )                                                        \
+    {                                                                                            \
+      paramSnapshotSet( _id, value );                                                            \
+    }                                                                                            \
+  }
+
+PARAMETERS_U32_LIST
+#undef PARAM
+
+#endif
@@ -0,0 +1,148 @@
+#include "param_bridge.h"
+
+#include "app_config.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "param_snapshot.h"
+#include "spsc_queue.h"
+
+#define MODULE_NAME "[Bridge] "
+#define DEBUG_LVL   PRINT_INFO
+
+#if CONFIG_DEBUG_PARAM_BRIDGE
+#define LOG( _lvl, ... ) \
+  debug_printf( DEBUG_LVL, _lvl, MODULE_NAME __VA_ARGS__ )
+#else
+#define LOG( PRINT_INFO, ... )
+#endif
+
+typedef struct
+{
+  /* Set last with release, consumer skips slot until queue is ready */
+  _Atomic( TaskHandle_t ) owner;
+  spsc_queue_t queue;
+  spsc_queue_item_t buffer[PARAM_BRIDGE_QUEUE_LEN];
+} param_bridge_slot_t;
+
+typedef struct
+{
+  bool started;
+  uint8_t producers;
+  param_bridge_slot_t slots[PARAM_BRIDGE_PRODUCERS];
+  uint32_t applied;
+  _Atomic uint32_t overflows;
+} param_bridge_ctx_t;
+
+static param_bridge_ctx_t ctx;
+static portMUX_TYPE bridge_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static param_bridge_slot_t* _find_slot( TaskHandle_t task )
+{
+  for ( uint8_t i = 0; i < PARAM_BRIDGE_PRODUCERS; i++ )
+  {
+    if ( atomic_load_explicit( &ctx.slots[i].owner, memory_order_acquire ) == task )
+    {
+      return &ctx.slots[i];
+    }
+  }
+
+  return NULL;
+}
+
+static void _drain( void )
+{
+  spsc_queue_item_t item;
+
+  for ( uint8_t i = 0; i < PARAM_BRIDGE_PRODUCERS; i++ )
+  {
+    param_bridge_slot_t* slot = &ctx.slots[i];
+
+    if ( atomic_load_explicit( &slot->owner, memory_order_acquire ) == NULL )
+    {
+      continue;
+    }
+
+    while ( spscQueuePop( &slot->queue, &item ) )
+    {
+      paramSnapshotSet( item.key, item.value );
+      ctx.applied++;
+    }
+  }
+}
+
+static void _bridge_task( void* arg )
+{
+  TickType_t last_wake = xTaskGetTickCount();
+
+  while ( 1 )
+  {
+    vTaskDelayUntil( &last_wake, MS2ST( PARAM_BRIDGE_PERIOD_MS ) );
+    _drain();
+  }
+}
+
+void paramBridgeInit( void )
+{
+#if CONFIG_TASK_AFFINITY
+  ctx.started = true;
+  xTaskCreatePinnedToCore( _bridge_task, "param_bridge", PARAM_BRIDGE_STACK, NULL, PARAM_BRIDGE_PRIO, NULL,
+                           TASK_CORE( NETWORK_CORE ) );
+#endif
+}
+
+void paramBridgeRegisterProducer( void )
+{
+  if ( !ctx.started )
+  {
+    return;
+  }
+
+  TaskHandle_t task = xTaskGetCurrentTaskHandle();
+  param_bridge_slot_t* slot = NULL;
+
+  portENTER_CRITICAL( &bridge_lock );
+  if ( _find_slot( task ) == NULL && ctx.producers < PARAM_BRIDGE_PRODUCERS )
+  {
+    slot = &ctx.slots[ctx.producers++];
+  }
+  portEXIT_CRITICAL( &bridge_lock );
+
+  if ( slot == NULL )
+  {
+    LOG( PRINT_WARNING, "No slot for %s", pcTaskGetName( task ) );
+    return;
+  }
+
+  spscQueueInit( &slot->queue, slot->buffer, PARAM_BRIDGE_QUEUE_LEN );
+  atomic_store_explicit( &slot->owner, task, memory_order_release );
+  LOG( PRINT_INFO, "Producer %s", pcTaskGetName( task ) );
+}
+
+bool paramBridgePost( uint32_t param, uint32_t value )
+{
+  if ( !ctx.started )
+  {
+    return false;
+  }
+
+  param_bridge_slot_t* slot = _find_slot( xTaskGetCurrentTaskHandle() );
+
+  if ( slot == NULL )
+  {
+    return false;
+  }
+
+  if ( !spscQueuePush( &slot->queue, param, value ) )
+  {
+    atomic_fetch_add_explicit( &ctx.overflows, 1, memory_order_relaxed );
+  }
+
+  return true;
+}
+
+void paramBridgeGetStats( param_bridge_stats_t* stats )
+{
+  stats->applied = ctx.applied;
+  stats->overflows = atomic_load_explicit( &ctx.overflows, memory_order_relaxed );
+  stats->producers = ctx.producers;
+}
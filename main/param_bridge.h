@@ -0,0 +1,36 @@
+/**
+ *******************************************************************************
+ * @file    param_bridge.h
+ * @brief   Parameter writes from control core applied on network core
+ *******************************************************************************
+ */
+
+#ifndef _PARAM_BRIDGE_H
+#define _PARAM_BRIDGE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+typedef struct
+{
+  uint32_t applied;
+  /* Queue was full, value dropped, mirror and next publish carry it */
+  uint32_t overflows;
+  uint8_t producers;
+} param_bridge_stats_t;
+
+/* Starts consumer task on network core, call before control tasks are created */
+void paramBridgeInit( void );
+
+/* Called from producing task itself, gives that task its own queue */
+void paramBridgeRegisterProducer( void );
+
+/*
+ * False if calling task is not registered, caller writes parameter itself.
+ * Full queue drops value instead, direct write could be overtaken by older queued one.
+ */
+bool paramBridgePost( uint32_t param, uint32_t value );
+
+void paramBridgeGetStats( param_bridge_stats_t* stats );
+
+#endif
@@ -0,0 +1,293 @@
+#include "param_persist.h"
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "app_config.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+#include "nvs.h"
+#include "param_access.h"
+#include "param_snapshot.h"
+#include "parameters.h"
+
+#define MODULE_NAME "[Persist] "
+#define DEBUG_LVL   PRINT_INFO
+
+#if CONFIG_DEBUG_PARAM_PERSIST
+#define LOG( _lvl, ... ) \
+  debug_printf( DEBUG_LVL, _lvl, MODULE_NAME __VA_ARGS__ )
+#else
+#define LOG( PRINT_INFO, ... )
+#endif
+
+#define PERSIST_NVS_NAMESPACE "param_delta"
+#define PERSIST_KEY_PREFIX    'p'
+#define DIRTY_WORDS           ( ( PARAM_PERSIST_MAX_ID + 31 ) / 32 )
+
+typedef struct
+{
+  uint32_t dirty[DIRTY_WORDS];
+  uint32_t image[PARAM_PERSIST_MAX_ID];
+  uint32_t records_count;
+  TaskHandle_t task;
+  SemaphoreHandle_t flush_mutex;
+  param_persist_stats_t stats;
+} param_persist_ctx_t;
+
+static param_persist_ctx_t ctx;
+static portMUX_TYPE persist_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static void _make_key( char* key, size_t size, uint32_t param )
+{
+  snprintf( key, size, "%c%lu", PERSIST_KEY_PREFIX, param );
+}
+
+static bool _take_dirty( uint32_t* dirty )
+{
+  bool any = false;
+
+  portENTER_CRITICAL( &persist_lock );
+  for ( int i = 0; i < DIRTY_WORDS; i++ )
+  {
+    dirty[i] = ctx.dirty[i];
+    ctx.dirty[i] = 0;
+    any |= dirty[i] != 0;
+  }
+  portEXIT_CRITICAL( &persist_lock );
+
+  return any;
+}
+
+static void _restore_dirty( const uint32_t* dirty )
+{
+  portENTER_CRITICAL( &persist_lock );
+  for ( int i = 0; i < DIRTY_WORDS; i++ )
+  {
+    ctx.dirty[i] |= dirty[i];
+  }
+  portEXIT_CRITICAL( &persist_lock );
+}
+
+static void _take_image( void )
+{
+  for ( uint32_t param = 0; param < PARAM_PERSIST_MAX_ID && param < PARAM_ACCESS_COUNT; param++ )
+  {
+    ctx.image[param] = parameters_getValue( param );
+  }
+}
+
+static void _compact( nvs_handle_t handle )
+{
+  /* Full image holds every value, delta records are no longer needed */
+  parameters_save();
+  _take_image();
+  nvs_erase_all( handle );
+  ctx.records_count = 0;
+  ctx.stats.compactions++;
+  LOG( PRINT_INFO, "Compacted" );
+}
+
+static void _flush( void )
+{
+  uint32_t dirty[DIRTY_WORDS];
+
+  if ( !_take_dirty( dirty ) )
+  {
+    return;
+  }
+
+  nvs_handle_t handle;
+  esp_err_t err = nvs_open( PERSIST_NVS_NAMESPACE, NVS_READWRITE, &handle );
+
+  if ( err != ESP_OK )
+  {
+    LOG( PRINT_ERROR, "Open %s", esp_err_to_name( err ) );
+    _restore_dirty( dirty );
+    return;
+  }
+
+  uint32_t written = 0;
+
+  for ( uint32_t param = 0; param < PARAM_PERSIST_MAX_ID; param++ )
+  {
+    if ( !( dirty[param / 32] & ( 1UL << ( param % 32 ) ) ) )
+    {
+      continue;
+    }
+
+    char key[NVS_KEY_NAME_MAX_SIZE];
+    uint32_t stored = 0;
+    uint32_t value = parameters_getValue( param );
+
+    _make_key( key, sizeof( key ), param );
+
+    /* Without a record the value in flash is the one from full image */
+    bool has_record = nvs_get_u32( handle, key, &stored ) == ESP_OK;
+    if ( value == ( has_record ? stored : ctx.image[param] ) )
+    {
+      continue;
+    }
+
+    /* Back to image value, record is dropped instead of rewritten */
+    if ( has_record && value == ctx.image[param] )
+    {
+      if ( nvs_erase_key( handle, key ) == ESP_OK )
+      {
+        ctx.records_count--;
+        written++;
+      }
+
+      continue;
+    }
+
+    if ( nvs_set_u32( handle, key, value ) == ESP_OK )
+    {
+      ctx.records_count += has_record ? 0 : 1;
+      written++;
+    }
+  }
+
+  if ( ctx.records_count > PARAM_PERSIST_COMPACT_COUNT )
+  {
+    _compact( handle );
+  }
+
+  nvs_commit( handle );
+  nvs_close( handle );
+
+  ctx.stats.flushes++;
+  ctx.stats.records += written;
+  LOG( PRINT_INFO, "Flush %lu records", written );
+}
+
+static void _load( void )
+{
+  nvs_handle_t handle;
+
+  _take_image();
+
+  if ( nvs_open( PERSIST_NVS_NAMESPACE, NVS_READONLY, &handle ) != ESP_OK )
+  {
+    return;
+  }
+
+  nvs_iterator_t it = NULL;
+  esp_err_t res = nvs_entry_find( NVS_DEFAULT_PART_NAME, PERSIST_NVS_NAMESPACE, NVS_TYPE_U32, &it );
+
+  while ( res == ESP_OK )
+  {
+    nvs_entry_info_t info;
+    uint32_t value = 0;
+
+    nvs_entry_info( it, &info );
+
+    if ( info.key[0] == PERSIST_KEY_PREFIX && nvs_get_u32( handle, info.key, &value ) == ESP_OK )
+    {
+      uint32_t param = strtoul( &info.key[1], NULL, 10 );
+
+      if ( param < PARAM_PERSIST_MAX_ID )
+      {
+        paramSnapshotSet( param, value );
+        ctx.records_count++;
+      }
+    }
+
+    res = nvs_entry_next( &it );
+  }
+
+  nvs_release_iterator( it );
+  nvs_close( handle );
+  LOG( PRINT_INFO, "Loaded %lu records", ctx.records_count );
+}
+
+static void _persist_task( void* arg )
+{
+  while ( 1 )
+  {
+    ulTaskNotifyTake( pdTRUE, portMAX_DELAY );
+
+    /* Writes arriving in this window go to flash together */
+    osDelay( PARAM_PERSIST_DELAY_MS );
+    paramPersistFlush();
+  }
+}
+
+void paramPersistInit( void )
+{
+  ctx.flush_mutex = xSemaphoreCreateMutex();
+  _load();
+  xTaskCreate( _persist_task, "param_persist", 3072, NULL, 1, &ctx.task );
+}
+
+void paramPersistMarkDirty( uint32_t param )
+{
+  if ( param >= PARAM_PERSIST_MAX_ID )
+  {
+    LOG( PRINT_ERROR, "Param %lu out of range", param );
+    return;
+  }
+
+  bool was_clean = true;
+
+  portENTER_CRITICAL( &persist_lock );
+  for ( int i = 0; i < DIRTY_WORDS; i++ )
+  {
+    was_clean &= ctx.dirty[i] == 0;
+  }
+  ctx.dirty[param / 32] |= 1UL << ( param % 32 );
+  portEXIT_CRITICAL( &persist_lock );
+
+  /* Window starts at first dirty parameter, so steady edits can't postpone write */
+  if ( was_clean && ctx.task != NULL )
+  {
+    xTaskNotifyGive( ctx.task );
+  }
+}
+
+void paramPersistSetValue( uint32_t param, uint32_t value )
+{
+  if ( parameters_getValue( param ) == value )
+  {
+    return;
+  }
+
+  paramSnapshotSet( param, value );
+  paramPersistMarkDirty( param );
+}
+
+bool paramPersistIsDirty( void )
+{
+  bool dirty = false;
+
+  portENTER_CRITICAL( &persist_lock );
+  for ( int i = 0; i < DIRTY_WORDS; i++ )
+  {
+    dirty |= ctx.dirty[i] != 0;
+  }
+  portEXIT_CRITICAL( &persist_lock );
+
+  return dirty;
+}
+
+void paramPersistFlush( void )
+{
+  if ( ctx.flush_mutex == NULL )
+  {
+    return;
+  }
+
+  xSemaphoreTake( ctx.flush_mutex, portMAX_DELAY );
+  _flush();
+  xSemaphoreGive( ctx.flush_mutex );
+}
+
+void paramPersistGetStats( param_persist_stats_t* stats )
+{
+  assert( stats );
+  *stats = ctx.stats;
+  stats->deltas = ctx.records_count;
+}
@@ -0,0 +1,30 @@
+/**
+ *******************************************************************************
+ * @file    param_persist.h
+ * @brief   Coalesced parameter writes to flash as per parameter delta records
+ *******************************************************************************
+ */
+
+#ifndef _PARAM_PERSIST_H
+#define _PARAM_PERSIST_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+typedef struct
+{
+  uint32_t flushes;
+  uint32_t records;
+  uint32_t compactions;
+  uint32_t deltas;
+} param_persist_stats_t;
+
+/* Call after parameters_init, applies delta records over loaded parameters */
+void paramPersistInit( void );
+void paramPersistMarkDirty( uint32_t param );
+void paramPersistSetValue( uint32_t param, uint32_t value );
+bool paramPersistIsDirty( void );
+void paramPersistFlush( void );
+void paramPersistGetStats( param_persist_stats_t* stats );
+
+#endif
@@ -0,0 +1,71 @@
+#include "param_snapshot.h"
+
+#include <assert.h>
+#include <stdatomic.h>
+
+#include "parameters.h"
+#include "seq_lock.h"
+
+#define SNAPSHOT_MAX_RETRIES 8
+
+typedef struct
+{
+  seq_lock_t seq;
+  _Atomic uint32_t retries;
+} param_snapshot_ctx_t;
+
+static param_snapshot_ctx_t ctx;
+
+bool paramSnapshotRead( param_value_t* values, size_t count )
+{
+  assert( values );
+
+  /* Called from control loop, writer sections are a few stores, spin instead of sleeping */
+  for ( int retry = 0; retry < SNAPSHOT_MAX_RETRIES; retry++ )
+  {
+    uint32_t start;
+
+    if ( seqLockReadBegin( &ctx.seq, &start ) )
+    {
+      for ( size_t i = 0; i < count; i++ )
+      {
+        values[i].value = parameters_getValue( values[i].param );
+      }
+
+      if ( seqLockReadValid( &ctx.seq, start ) )
+      {
+        return true;
+      }
+    }
+
+    atomic_fetch_add_explicit( &ctx.retries, 1, memory_order_relaxed );
+  }
+
+  return false;
+}
+
+void paramSnapshotSet( uint32_t param, uint32_t value )
+{
+  seqLockWriteBegin( &ctx.seq );
+  parameters_setValue( param, value );
+  seqLockWriteEnd( &ctx.seq );
+}
+
+void paramSnapshotWrite( const param_value_t* values, size_t count )
+{
+  assert( values );
+
+  seqLockWriteBegin( &ctx.seq );
+
+  for ( size_t i = 0; i < count; i++ )
+  {
+    parameters_setValue( values[i].param, values[i].value );
+  }
+
+  seqLockWriteEnd( &ctx.seq );
+}
+
+uint32_t paramSnapshotGetRetries( void )
+{
+  return atomic_load_explicit( &ctx.retries, memory_order_relaxed );
+}
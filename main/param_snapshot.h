@@ -0,0 +1,36 @@
+/**
+ *******************************************************************************
+ * @file    param_snapshot.h
+ * @brief   Consistent multi parameter read and write, seqlock based
+ *******************************************************************************
+ */
+
+#ifndef _PARAM_SNAPSHOT_H
+#define _PARAM_SNAPSHOT_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+typedef struct
+{
+  uint32_t param;
+  uint32_t value;
+} param_value_t;
+
+/*
+ * Application writes go through paramSnapshotSet(), typed <id>_set() uses it.
+ * HTTP parameter API of parameters component sets one value per request, reader
+ * sees it either before or after, multi value updates use paramSnapshotWrite().
+ */
+
+/* Fills value of each entry, returns false if no consistent set was read in retry limit */
+bool paramSnapshotRead( param_value_t* values, size_t count );
+
+void paramSnapshotSet( uint32_t param, uint32_t value );
+
+/* Readers see either all or none of the values */
+void paramSnapshotWrite( const param_value_t* values, size_t count );
+uint32_t paramSnapshotGetRetries( void );
+
+#endif
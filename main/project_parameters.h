@@ -53,6 +53,24 @@
   PARAM( PARAM_OPEN_SERVO_REGULATION_FLAG, 0, 1, 0, "open_servo_regulation_flag" )   \
   PARAM( PARAM_CLOSE_SERVO_REGULATION, 0, 99, 50, "close_servo_regulation" )         \
   PARAM( PARAM_OPEN_SERVO_REGULATION, 0, 99, 50, "open_servo_regulation" )           \
-  PARAM( PARAM_TRY_OPEN_CALIBRATION, 0, 10, 8, "try_open_calibration" )
+  PARAM( PARAM_TRY_OPEN_CALIBRATION, 0, 10, 8, "try_open_calibration" )             \
+  PARAM( PARAM_ACCUM_CAPACITY, 1, 250, 60, "accum_capacity" )                        \
+  PARAM( PARAM_ACCUM_SOC, 0, 100, 0, "accum_soc" )                                   \
+  PARAM( PARAM_ACCUM_TIME_LEFT, 0, 0xFFFF, 0xFFFF, "accum_time_left" )               \
+  PARAM( PARAM_FLOW_CALIBRATION, 10, 250, 100, "flow_calibration" )                  \
+  PARAM( PARAM_MASS_TOTAL, 0, 0xFFFFFF, 0, "mass_total" )                            \
+  PARAM( PARAM_WORK_TIME, 0, 0xFFFFFF, 0, "work_time" )                              \
+  PARAM( PARAM_SESSION_MASS, 0, 0xFFFFFF, 0, "session_mass" )                        \
+  PARAM( PARAM_SESSION_TIME, 0, 0xFFFF, 0, "session_time" )                          \
+  PARAM( PARAM_SERVO_AUTO_CALIBRATION, 0, 1, 0, "servo_auto_calibration" )           \
+  PARAM( PARAM_MOTOR_AUTO_CALIBRATION, 0, 1, 0, "motor_auto_calibration" )           \
+  PARAM( PARAM_MOTOR_CURRENT_20, 0, 0xFFFF, 0, "motor_current_20" )                  \
+  PARAM( PARAM_MOTOR_CURRENT_40, 0, 0xFFFF, 0, "motor_current_40" )                  \
+  PARAM( PARAM_MOTOR_CURRENT_60, 0, 0xFFFF, 0, "motor_current_60" )                  \
+  PARAM( PARAM_MOTOR_CURRENT_80, 0, 0xFFFF, 0, "motor_current_80" )                  \
+  PARAM( PARAM_MOTOR_CURRENT_100, 0, 0xFFFF, 0, "motor_current_100" )                \
+  PARAM( PARAM_CPU_LOAD, 0, 100, 0, "cpu_load" )                                     \
+  PARAM( PARAM_STACK_MIN_FREE, 0, 0xFFFF, 0, "stack_min_free" )                      \
+  PARAM( PARAM_CONTROL_LOOP_MAX_MS, 0, 0xFFFF, 0, "control_loop_max_ms" )
 
 #endif
\ No newline at end of file
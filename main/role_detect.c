@@ -0,0 +1,65 @@
+#include "role_detect.h"
+
+#include <assert.h>
+
+#include "app_config.h"
+#include "wifidrv.h"
+
+role_source_t roleDetectSource( bool strap_wired, bool hint_valid, uint8_t hint )
+{
+  if ( strap_wired )
+  {
+    return ROLE_SOURCE_STRAP;
+  }
+
+  /* Panel needs the bus init anyway, so only controller boots from hint and is verified later */
+  if ( hint_valid && hint == T_WIFI_TYPE_SERVER )
+  {
+    return ROLE_SOURCE_HINT;
+  }
+
+  return ROLE_SOURCE_PROBE;
+}
+
+/* Client when display answers, controller is confirmed only when every attempt got NACK */
+uint8_t roleDetectProbe( role_probe_fn_t probe, bool* confirmed )
+{
+  assert( probe );
+  assert( confirmed );
+  *confirmed = true;
+
+  for ( int i = 0; i < ROLE_PROBE_ATTEMPTS; i++ )
+  {
+    esp_err_t ret = probe();
+
+    /* ACK is definite even after a timed out attempt */
+    if ( ret == ESP_OK )
+    {
+      *confirmed = true;
+      return T_WIFI_TYPE_CLIENT;
+    }
+
+    if ( ret != ESP_FAIL )
+    {
+      *confirmed = false;
+    }
+
+    if ( i < ROLE_PROBE_ATTEMPTS - 1 )
+    {
+      osDelay( ROLE_PROBE_RETRY_MS );
+    }
+  }
+
+  return T_WIFI_TYPE_SERVER;
+}
+
+/* Timeouts may be a slow display, do not store controller hint, probe again next boot */
+bool roleDetectStoreHint( bool hint_valid, uint8_t hint, uint8_t role, bool confirmed )
+{
+  return confirmed && ( !hint_valid || hint != role );
+}
+
+bool roleDetectRestart( uint8_t booted_role, uint8_t probed_role, bool confirmed )
+{
+  return confirmed && booted_role != probed_role;
+}
@@ -0,0 +1,31 @@
+/**
+ *******************************************************************************
+ * @file    role_detect.h
+ * @brief   Panel or controller role decision, bus access is passed in
+ *******************************************************************************
+ */
+
+#ifndef _ROLE_DETECT_H
+#define _ROLE_DETECT_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+
+typedef enum
+{
+  ROLE_SOURCE_STRAP,
+  ROLE_SOURCE_HINT,
+  ROLE_SOURCE_PROBE,
+} role_source_t;
+
+/* Single display probe, ESP_OK on ACK, ESP_FAIL on NACK, other codes on bus error or timeout */
+typedef esp_err_t ( *role_probe_fn_t )( void );
+
+role_source_t roleDetectSource( bool strap_wired, bool hint_valid, uint8_t hint );
+uint8_t roleDetectProbe( role_probe_fn_t probe, bool* confirmed );
+bool roleDetectStoreHint( bool hint_valid, uint8_t hint, uint8_t role, bool confirmed );
+bool roleDetectRestart( uint8_t booted_role, uint8_t probed_role, bool confirmed );
+
+#endif
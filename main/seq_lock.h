@@ -0,0 +1,52 @@
+/**
+ *******************************************************************************
+ * @file    seq_lock.h
+ * @brief   Sequence counter for consistent reads, writers never block
+ *******************************************************************************
+ */
+
+#ifndef _SEQ_LOCK_H
+#define _SEQ_LOCK_H
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * Writers bump begin before and end after their stores, several may overlap.
+ * Reader sees begin == end only when no writer is active, and retries if begin
+ * moved while it was reading.
+ */
+typedef struct
+{
+  _Atomic uint32_t begin;
+  _Atomic uint32_t end;
+} seq_lock_t;
+
+static inline void seqLockWriteBegin( seq_lock_t* lock )
+{
+  atomic_fetch_add_explicit( &lock->begin, 1, memory_order_relaxed );
+  atomic_thread_fence( memory_order_release );
+}
+
+static inline void seqLockWriteEnd( seq_lock_t* lock )
+{
+  atomic_fetch_add_explicit( &lock->end, 1, memory_order_release );
+}
+
+/* False while a writer is active, start is passed to seqLockReadValid() */
+static inline bool seqLockReadBegin( seq_lock_t* lock, uint32_t* start )
+{
+  /* End first, writer finishing between the loads only causes a retry */
+  uint32_t end = atomic_load_explicit( &lock->end, memory_order_acquire );
+  *start = atomic_load_explicit( &lock->begin, memory_order_acquire );
+  return *start == end;
+}
+
+static inline bool seqLockReadValid( seq_lock_t* lock, uint32_t start )
+{
+  atomic_thread_fence( memory_order_acquire );
+  return atomic_load_explicit( &lock->begin, memory_order_relaxed ) == start;
+}
+
+#endif
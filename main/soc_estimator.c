@@ -0,0 +1,168 @@
+#include "soc_estimator.h"
+
+#include <assert.h>
+
+#define MS_PER_HOUR            3600000LL
+#define OCV_WEIGHT_REST        64
+#define OCV_WEIGHT_LOAD        1024
+#define CURRENT_AVG_FACTOR     16
+#define TIME_LEFT_MAX_MIN      ( SOC_TIME_LEFT_UNKNOWN - 1 )
+#define ARRAY_SIZE( _a )       ( sizeof( _a ) / sizeof( _a[0] ) )
+
+/* 12 V lead acid, rested */
+static const soc_ocv_point_t accum_ocv[] =
+  {
+    { .voltage_mv = 12730, .soc_permille = 1000 },
+    { .voltage_mv = 12620, .soc_permille = 900  },
+    { .voltage_mv = 12500, .soc_permille = 800  },
+    { .voltage_mv = 12370, .soc_permille = 700  },
+    { .voltage_mv = 12240, .soc_permille = 600  },
+    { .voltage_mv = 12100, .soc_permille = 500  },
+    { .voltage_mv = 11960, .soc_permille = 400  },
+    { .voltage_mv = 11810, .soc_permille = 300  },
+    { .voltage_mv = 11660, .soc_permille = 200  },
+    { .voltage_mv = 11510, .soc_permille = 100  },
+    { .voltage_mv = 10500, .soc_permille = 0    },
+};
+
+/* Single Li-ion cell of the panel, light load */
+static const soc_ocv_point_t panel_ocv[] =
+  {
+    { .voltage_mv = 4200, .soc_permille = 1000 },
+    { .voltage_mv = 4100, .soc_permille = 900  },
+    { .voltage_mv = 4000, .soc_permille = 800  },
+    { .voltage_mv = 3920, .soc_permille = 700  },
+    { .voltage_mv = 3870, .soc_permille = 600  },
+    { .voltage_mv = 3820, .soc_permille = 500  },
+    { .voltage_mv = 3790, .soc_permille = 400  },
+    { .voltage_mv = 3750, .soc_permille = 300  },
+    { .voltage_mv = 3700, .soc_permille = 200  },
+    { .voltage_mv = 3600, .soc_permille = 100  },
+    { .voltage_mv = 3200, .soc_permille = 0    },
+};
+
+const soc_config_t soc_config_accum =
+  {
+    .ocv = accum_ocv,
+    .ocv_size = ARRAY_SIZE( accum_ocv ),
+    .resistance_mohm = 100,
+    .rest_current_ma = 500,
+    .hysteresis_permille = 20,
+};
+
+/* Panel has no current sensor, estimate is voltage only */
+const soc_config_t soc_config_panel =
+  {
+    .ocv = panel_ocv,
+    .ocv_size = ARRAY_SIZE( panel_ocv ),
+    .resistance_mohm = 0,
+    .rest_current_ma = 0,
+    .hysteresis_permille = 20,
+};
+
+uint16_t socOcvToPermille( const soc_config_t* config, uint32_t voltage_mv )
+{
+  assert( config );
+  const soc_ocv_point_t* ocv = config->ocv;
+
+  if ( voltage_mv >= ocv[0].voltage_mv )
+  {
+    return ocv[0].soc_permille;
+  }
+
+  for ( uint8_t i = 1; i < config->ocv_size; i++ )
+  {
+    if ( voltage_mv >= ocv[i].voltage_mv )
+    {
+      uint32_t span_mv = ocv[i - 1].voltage_mv - ocv[i].voltage_mv;
+      uint32_t span_soc = ocv[i - 1].soc_permille - ocv[i].soc_permille;
+      return ocv[i].soc_permille + ( voltage_mv - ocv[i].voltage_mv ) * span_soc / span_mv;
+    }
+  }
+
+  return ocv[config->ocv_size - 1].soc_permille;
+}
+
+void socEstimatorInit( soc_estimator_t* est, const soc_config_t* config, uint32_t capacity_mah )
+{
+  assert( est );
+  assert( config );
+  assert( capacity_mah > 0 );
+
+  est->config = config;
+  est->capacity_mams = (int64_t) capacity_mah * MS_PER_HOUR;
+  est->charge_mams = 0;
+  est->avg_current_ma = 0;
+  est->soc_permille = 0;
+  est->initialized = false;
+}
+
+void socEstimatorUpdate( soc_estimator_t* est, uint32_t voltage_mv, uint32_t current_ma, uint32_t dt_ms )
+{
+  assert( est );
+  const soc_config_t* config = est->config;
+
+  /* Voltage under load is lower by I * R, compensate to get open circuit voltage */
+  uint32_t ocv_mv = voltage_mv + current_ma * config->resistance_mohm / 1000;
+  int64_t ocv_charge = est->capacity_mams * socOcvToPermille( config, ocv_mv ) / 1000;
+
+  if ( !est->initialized )
+  {
+    est->charge_mams = ocv_charge;
+    est->avg_current_ma = current_ma;
+  }
+  else
+  {
+    /* Coulomb counting drifts, pull it to OCV. Rested voltage is trusted more. */
+    int32_t weight = current_ma <= config->rest_current_ma ? OCV_WEIGHT_REST : OCV_WEIGHT_LOAD;
+    est->charge_mams -= (int64_t) current_ma * dt_ms;
+    est->charge_mams += ( ocv_charge - est->charge_mams ) / weight;
+    est->avg_current_ma += ( (int32_t) current_ma - est->avg_current_ma ) / CURRENT_AVG_FACTOR;
+  }
+
+  if ( est->charge_mams < 0 )
+  {
+    est->charge_mams = 0;
+  }
+
+  if ( est->charge_mams > est->capacity_mams )
+  {
+    est->charge_mams = est->capacity_mams;
+  }
+
+  uint16_t soc_permille = (uint16_t) ( est->charge_mams * 1000 / est->capacity_mams );
+
+  if ( !est->initialized || soc_permille + config->hysteresis_permille < est->soc_permille
+       || soc_permille > est->soc_permille + config->hysteresis_permille )
+  {
+    est->soc_permille = soc_permille;
+  }
+
+  est->initialized = true;
+}
+
+bool socEstimatorIsValid( const soc_estimator_t* est )
+{
+  assert( est );
+  return est->initialized;
+}
+
+uint8_t socEstimatorGetSoc( const soc_estimator_t* est )
+{
+  assert( est );
+  return ( est->soc_permille + 5 ) / 10;
+}
+
+uint32_t socEstimatorGetTimeLeftMin( const soc_estimator_t* est )
+{
+  assert( est );
+
+  if ( !est->initialized || est->avg_current_ma <= est->config->rest_current_ma )
+  {
+    return SOC_TIME_LEFT_UNKNOWN;
+  }
+
+  int64_t minutes = est->charge_mams / est->avg_current_ma / 60000;
+
+  return minutes > TIME_LEFT_MAX_MIN ? TIME_LEFT_MAX_MIN : (uint32_t) minutes;
+}
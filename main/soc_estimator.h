@@ -0,0 +1,52 @@
+/**
+ *******************************************************************************
+ * @file    soc_estimator.h
+ * @brief   Battery state of charge estimator, fixed point, no RTOS dependency
+ *******************************************************************************
+ */
+
+#ifndef _SOC_ESTIMATOR_H
+#define _SOC_ESTIMATOR_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define SOC_TIME_LEFT_UNKNOWN 0xFFFF
+
+/* Open circuit voltage point, table sorted from highest voltage */
+typedef struct
+{
+  uint16_t voltage_mv;
+  uint16_t soc_permille;
+} soc_ocv_point_t;
+
+typedef struct
+{
+  const soc_ocv_point_t* ocv;
+  uint8_t ocv_size;
+  uint16_t resistance_mohm;
+  uint16_t rest_current_ma;
+  uint16_t hysteresis_permille;
+} soc_config_t;
+
+typedef struct
+{
+  const soc_config_t* config;
+  int64_t capacity_mams;
+  int64_t charge_mams;
+  int32_t avg_current_ma;
+  uint16_t soc_permille;
+  bool initialized;
+} soc_estimator_t;
+
+extern const soc_config_t soc_config_accum;
+extern const soc_config_t soc_config_panel;
+
+uint16_t socOcvToPermille( const soc_config_t* config, uint32_t voltage_mv );
+void socEstimatorInit( soc_estimator_t* est, const soc_config_t* config, uint32_t capacity_mah );
+void socEstimatorUpdate( soc_estimator_t* est, uint32_t voltage_mv, uint32_t current_ma, uint32_t dt_ms );
+bool socEstimatorIsValid( const soc_estimator_t* est );
+uint8_t socEstimatorGetSoc( const soc_estimator_t* est );
+uint32_t socEstimatorGetTimeLeftMin( const soc_estimator_t* est );
+
+#endif
@@ -0,0 +1,89 @@
+/**
+ *******************************************************************************
+ * @file    spsc_queue.h
+ * @brief   Lock free single producer single consumer ring of key/value items
+ *******************************************************************************
+ */
+
+#ifndef _SPSC_QUEUE_H
+#define _SPSC_QUEUE_H
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Exactly one task pushes and one task pops, each may run on its own core.
+ * Head and tail are free running, slot is index masked by power of two size.
+ */
+typedef struct
+{
+  uint32_t key;
+  uint32_t value;
+} spsc_queue_item_t;
+
+typedef struct
+{
+  spsc_queue_item_t* buffer;
+  uint32_t mask;
+  /* Written only by producer */
+  _Atomic uint32_t head;
+  /* Written only by consumer */
+  _Atomic uint32_t tail;
+} spsc_queue_t;
+
+/* Size must be power of two */
+static inline bool spscQueueInit( spsc_queue_t* queue, spsc_queue_item_t* buffer, uint32_t size )
+{
+  if ( buffer == NULL || size == 0 || ( size & ( size - 1 ) ) != 0 )
+  {
+    return false;
+  }
+
+  queue->buffer = buffer;
+  queue->mask = size - 1;
+  atomic_init( &queue->head, 0 );
+  atomic_init( &queue->tail, 0 );
+  return true;
+}
+
+/* Producer side, false when full */
+static inline bool spscQueuePush( spsc_queue_t* queue, uint32_t key, uint32_t value )
+{
+  uint32_t head = atomic_load_explicit( &queue->head, memory_order_relaxed );
+  uint32_t tail = atomic_load_explicit( &queue->tail, memory_order_acquire );
+
+  if ( head - tail > queue->mask )
+  {
+    return false;
+  }
+
+  queue->buffer[head & queue->mask] = ( spsc_queue_item_t ) { .key = key, .value = value };
+  atomic_store_explicit( &queue->head, head + 1, memory_order_release );
+  return true;
+}
+
+/* Consumer side, false when empty */
+static inline bool spscQueuePop( spsc_queue_t* queue, spsc_queue_item_t* item )
+{
+  uint32_t tail = atomic_load_explicit( &queue->tail, memory_order_relaxed );
+  uint32_t head = atomic_load_explicit( &queue->head, memory_order_acquire );
+
+  if ( head == tail )
+  {
+    return false;
+  }
+
+  *item = queue->buffer[tail & queue->mask];
+  atomic_store_explicit( &queue->tail, tail + 1, memory_order_release );
+  return true;
+}
+
+/* Exact only when called from producer or consumer */
+static inline uint32_t spscQueueCount( spsc_queue_t* queue )
+{
+  return atomic_load_explicit( &queue->head, memory_order_acquire ) - atomic_load_explicit( &queue->tail, memory_order_acquire );
+}
+
+#endif
@@ -0,0 +1,269 @@
+#include "task_profiler.h"
+
+#include <string.h>
+
+#include "app_config.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "param_access.h"
+#include "param_bridge.h"
+
+#define MODULE_NAME "[Prof] "
+#define DEBUG_LVL   PRINT_INFO
+
+#if CONFIG_DEBUG_TASK_PROFILER
+#define LOG( _lvl, ... ) \
+  debug_printf( DEBUG_LVL, _lvl, MODULE_NAME __VA_ARGS__ )
+#else
+#define LOG( PRINT_INFO, ... )
+#endif
+
+typedef struct
+{
+  const char* name;
+  uint32_t stack_size;
+} task_budget_t;
+
+typedef struct
+{
+  TaskHandle_t handle;
+  uint32_t run_time;
+} task_run_time_t;
+
+typedef struct
+{
+  int64_t last_us;
+  uint32_t max_gap_us;
+  uint32_t min_gap_us;
+} loop_stat_t;
+
+typedef struct
+{
+  TaskStatus_t status[TASK_PROFILER_MAX_TASKS];
+  task_run_time_t prev[TASK_PROFILER_MAX_TASKS];
+  task_run_time_t next[TASK_PROFILER_MAX_TASKS];
+  uint8_t prev_count;
+  uint32_t prev_total;
+
+  task_profiler_entry_t entries[TASK_PROFILER_MAX_TASKS];
+  uint8_t count;
+
+  loop_stat_t loops[TASK_PROFILER_LOOP_TOP];
+  uint32_t loop_max_ms[TASK_PROFILER_LOOP_TOP];
+  uint32_t loop_jitter_us[TASK_PROFILER_LOOP_TOP];
+} task_profiler_ctx_t;
+
+static const task_budget_t budgets[] =
+  {
+    { "measure_process", MEASURE_TASK_STACK      },
+    { "srvrController",  CONTROLLER_TASK_STACK   },
+    { "_error_task",     ERROR_TASK_STACK        },
+    { "vibro_process",   VIBRO_TASK_STACK        },
+    { "menu_back",       MENU_BACKEND_TASK_STACK },
+    { "ctrl_exec",       CONTROLLER_EXEC_STACK   },
+    { "param_bridge",    PARAM_BRIDGE_STACK      },
+    { "task_profiler",   TASK_PROFILER_STACK     },
+};
+
+static task_profiler_ctx_t ctx;
+static portMUX_TYPE task_profiler_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static uint32_t _budget( const char* name )
+{
+  for ( uint8_t i = 0; i < sizeof( budgets ) / sizeof( budgets[0] ); i++ )
+  {
+    if ( strcmp( budgets[i].name, name ) == 0 )
+    {
+      return budgets[i].stack_size;
+    }
+  }
+
+  return 0;
+}
+
+static uint32_t _prev_run_time( TaskHandle_t handle )
+{
+  for ( uint8_t i = 0; i < ctx.prev_count; i++ )
+  {
+    if ( ctx.prev[i].handle == handle )
+    {
+      return ctx.prev[i].run_time;
+    }
+  }
+
+  /* Task created since last sample, whole run time is in this period */
+  return 0;
+}
+
+static uint8_t _sample_tasks( void )
+{
+  uint32_t total = 0;
+  UBaseType_t count = uxTaskGetSystemState( ctx.status, TASK_PROFILER_MAX_TASKS, &total );
+
+  /* Run time counter is wall time, each core adds its own share */
+  uint32_t period = ( total - ctx.prev_total ) * portNUM_PROCESSORS;
+  uint32_t idle = 0;
+
+  for ( UBaseType_t i = 0; i < count; i++ )
+  {
+    TaskStatus_t* status = &ctx.status[i];
+    task_profiler_entry_t* entry = &ctx.entries[i];
+    uint32_t delta = status->ulRunTimeCounter - _prev_run_time( status->xHandle );
+
+    strlcpy( entry->name, status->pcTaskName, sizeof( entry->name ) );
+    entry->priority = status->uxCurrentPriority;
+    entry->cpu_percent = period ? (uint8_t) ( (uint64_t) delta * 100 / period ) : 0;
+    /* Stack type is byte on this port, high water mark is in bytes */
+    entry->stack_free = status->usStackHighWaterMark;
+    entry->stack_size = _budget( entry->name );
+
+    if ( strncmp( entry->name, "IDLE", 4 ) == 0 )
+    {
+      idle += delta;
+    }
+
+    /* System state order changes with task state, keep previous samples until loop ends */
+    ctx.next[i].handle = status->xHandle;
+    ctx.next[i].run_time = status->ulRunTimeCounter;
+  }
+
+  memcpy( ctx.prev, ctx.next, count * sizeof( ctx.prev[0] ) );
+  ctx.prev_count = count;
+  ctx.prev_total = total;
+  ctx.count = count;
+
+  return period && idle < period ? (uint8_t) ( 100 - (uint64_t) idle * 100 / period ) : 0;
+}
+
+static void _sample_loops( void )
+{
+  portENTER_CRITICAL( &task_profiler_lock );
+  for ( uint8_t i = 0; i < TASK_PROFILER_LOOP_TOP; i++ )
+  {
+    loop_stat_t* stat = &ctx.loops[i];
+
+    ctx.loop_max_ms[i] = stat->max_gap_us / 1000;
+    ctx.loop_jitter_us[i] = stat->max_gap_us > stat->min_gap_us ? stat->max_gap_us - stat->min_gap_us : 0;
+    stat->max_gap_us = 0;
+    stat->min_gap_us = UINT32_MAX;
+  }
+  portEXIT_CRITICAL( &task_profiler_lock );
+}
+
+static void _report( uint8_t cpu_load )
+{
+  uint32_t stack_min_free = UINT32_MAX;
+
+  LOG( PRINT_INFO, "cpu %d%% tasks %d", cpu_load, ctx.count );
+
+  for ( uint8_t i = 0; i < ctx.count; i++ )
+  {
+    task_profiler_entry_t* entry = &ctx.entries[i];
+
+    LOG( PRINT_INFO, "%-15s p%2d %3d%% free %5ld", entry->name, entry->priority, entry->cpu_percent, entry->stack_free );
+
+    if ( taskProfilerStackIsOversized( entry ) )
+    {
+      LOG( PRINT_WARNING, "%s stack %ld used %ld", entry->name, entry->stack_size, entry->stack_size - entry->stack_free );
+    }
+
+    if ( entry->stack_free < stack_min_free )
+    {
+      stack_min_free = entry->stack_free;
+    }
+  }
+
+  LOG( PRINT_INFO, "loop max ms meas %ld ctrl %ld err %ld", ctx.loop_max_ms[TASK_PROFILER_LOOP_MEASURE],
+       ctx.loop_max_ms[TASK_PROFILER_LOOP_CONTROLLER], ctx.loop_max_ms[TASK_PROFILER_LOOP_ERROR] );
+  LOG( PRINT_INFO, "jitter us meas %ld ctrl %ld err %ld", ctx.loop_jitter_us[TASK_PROFILER_LOOP_MEASURE],
+       ctx.loop_jitter_us[TASK_PROFILER_LOOP_CONTROLLER], ctx.loop_jitter_us[TASK_PROFILER_LOOP_ERROR] );
+
+  param_bridge_stats_t bridge;
+  paramBridgeGetStats( &bridge );
+  LOG( PRINT_INFO, "bridge prod %d applied %ld drop %ld", bridge.producers, bridge.applied, bridge.overflows );
+
+  PARAM_CPU_LOAD_set( cpu_load );
+  PARAM_STACK_MIN_FREE_set( stack_min_free );
+  PARAM_CONTROL_LOOP_MAX_MS_set( ctx.loop_max_ms[TASK_PROFILER_LOOP_CONTROLLER] );
+}
+
+static void _task( void* arg )
+{
+  /* First sample only sets reference run times */
+  _sample_tasks();
+
+  while ( 1 )
+  {
+    osDelay( TASK_PROFILER_PERIOD_MS );
+
+    uint8_t cpu_load = _sample_tasks();
+    _sample_loops();
+    _report( cpu_load );
+  }
+}
+
+void taskProfilerInit( void )
+{
+  for ( uint8_t i = 0; i < TASK_PROFILER_LOOP_TOP; i++ )
+  {
+    ctx.loops[i].min_gap_us = UINT32_MAX;
+  }
+
+  xTaskCreate( _task, "task_profiler", TASK_PROFILER_STACK, NULL, TASK_PROFILER_PRIO, NULL );
+}
+
+void taskProfilerLoop( task_profiler_loop_t loop )
+{
+  if ( loop >= TASK_PROFILER_LOOP_TOP )
+  {
+    return;
+  }
+
+  int64_t now_us = esp_timer_get_time();
+  loop_stat_t* stat = &ctx.loops[loop];
+
+  portENTER_CRITICAL( &task_profiler_lock );
+  if ( stat->last_us != 0 )
+  {
+    uint32_t gap_us = (uint32_t) ( now_us - stat->last_us );
+    if ( gap_us > stat->max_gap_us )
+    {
+      stat->max_gap_us = gap_us;
+    }
+
+    if ( gap_us < stat->min_gap_us )
+    {
+      stat->min_gap_us = gap_us;
+    }
+  }
+
+  stat->last_us = now_us;
+  portEXIT_CRITICAL( &task_profiler_lock );
+}
+
+uint8_t taskProfilerGetCount( void )
+{
+  return ctx.count;
+}
+
+bool taskProfilerGetEntry( uint8_t idx, task_profiler_entry_t* entry )
+{
+  if ( idx >= ctx.count || entry == NULL )
+  {
+    return false;
+  }
+
+  *entry = ctx.entries[idx];
+  return true;
+}
+
+uint32_t taskProfilerGetLoopMaxMs( task_profiler_loop_t loop )
+{
+  return loop < TASK_PROFILER_LOOP_TOP ? ctx.loop_max_ms[loop] : 0;
+}
+
+uint32_t taskProfilerGetLoopJitterUs( task_profiler_loop_t loop )
+{
+  return loop < TASK_PROFILER_LOOP_TOP ? ctx.loop_jitter_us[loop] : 0;
+}
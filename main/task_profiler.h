@@ -0,0 +1,52 @@
+/**
+ *******************************************************************************
+ * @file    task_profiler.h
+ * @brief   Periodic per task CPU time, stack headroom and loop latency report
+ *******************************************************************************
+ */
+
+#ifndef _TASK_PROFILER_H
+#define _TASK_PROFILER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define TASK_PROFILER_MAX_TASKS 32
+#define TASK_PROFILER_NAME_LEN  16
+
+/* Control loops reporting each iteration, worst gap shows blocking and preemption */
+typedef enum
+{
+  TASK_PROFILER_LOOP_MEASURE,
+  TASK_PROFILER_LOOP_CONTROLLER,
+  TASK_PROFILER_LOOP_ERROR,
+  TASK_PROFILER_LOOP_TOP,
+} task_profiler_loop_t;
+
+typedef struct
+{
+  char name[TASK_PROFILER_NAME_LEN];
+  uint8_t priority;
+  uint8_t cpu_percent;
+  uint32_t stack_free;
+  /* 0 if task is not in budget table of app_config.h */
+  uint32_t stack_size;
+} task_profiler_entry_t;
+
+void taskProfilerInit( void );
+void taskProfilerLoop( task_profiler_loop_t loop );
+
+/* Values from last report */
+uint8_t taskProfilerGetCount( void );
+bool taskProfilerGetEntry( uint8_t idx, task_profiler_entry_t* entry );
+uint32_t taskProfilerGetLoopMaxMs( task_profiler_loop_t loop );
+/* Worst minus best gap, compare with and without network load */
+uint32_t taskProfilerGetLoopJitterUs( task_profiler_loop_t loop );
+
+/* Uses less than half of its budget, budget is more than 2x what task needs */
+static inline bool taskProfilerStackIsOversized( const task_profiler_entry_t* entry )
+{
+  return entry->stack_size != 0 && entry->stack_free > entry->stack_size / 2;
+}
+
+#endif
@@ -0,0 +1,148 @@
+#include <string.h>
+
+#include "app_config.h"
+#include "black_box.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "nvs_flash.h"
+#include "unity.h"
+
+#define SAVE_WAIT_MS 2000
+
+static black_box_record_t ring[BLACK_BOX_RECORDS];
+static black_box_capture_t capture;
+
+/* Ring as recorder leaves it after given number of samples, first ADC channel holds sample number */
+static void _fill_ring( uint32_t samples, uint16_t* head, uint16_t* count )
+{
+  memset( ring, 0, sizeof( ring ) );
+  for ( uint32_t i = 0; i < samples; i++ )
+  {
+    ring[i % BLACK_BOX_RECORDS].adc[0] = i;
+  }
+
+  *head = samples % BLACK_BOX_RECORDS;
+  *count = samples < BLACK_BOX_RECORDS ? samples : BLACK_BOX_RECORDS;
+}
+
+static void _assert_window( uint32_t samples )
+{
+  uint16_t head;
+  uint16_t count;
+
+  _fill_ring( samples, &head, &count );
+  memset( &capture, 0xA5, sizeof( capture ) );
+  blackBoxFreeze( ring, head, count, &capture );
+
+  TEST_ASSERT_EQUAL( count, capture.count );
+  TEST_ASSERT_EQUAL( count - BLACK_BOX_POST_RECORDS, capture.trigger_idx );
+
+  /* Oldest first, last pre trigger record just before trigger_idx */
+  for ( uint16_t i = 0; i < count; i++ )
+  {
+    TEST_ASSERT_EQUAL( samples - count + i, capture.records[i].adc[0] );
+  }
+
+  TEST_ASSERT_EQUAL( samples - BLACK_BOX_POST_RECORDS - 1, capture.records[capture.trigger_idx - 1].adc[0] );
+}
+
+TEST_CASE( "Black box freezes ring oldest first", "[black_box]" )
+{
+  /* Partly filled, exactly full, wrapped, head just wrapped to 0 */
+  _assert_window( BLACK_BOX_POST_RECORDS + 20 );
+  _assert_window( BLACK_BOX_RECORDS );
+  _assert_window( BLACK_BOX_RECORDS + 57 );
+  _assert_window( 3 * BLACK_BOX_RECORDS );
+  _assert_window( 3 * BLACK_BOX_RECORDS - 1 );
+}
+
+TEST_CASE( "Black box rejects corrupt header and capture", "[black_box]" )
+{
+  black_box_header_t header;
+  black_box_header_t bad;
+  uint16_t head;
+  uint16_t count;
+
+  _fill_ring( BLACK_BOX_RECORDS + 10, &head, &count );
+  blackBoxFreeze( ring, head, count, &capture );
+  capture.reason = 3;
+  blackBoxSealHeader( &capture, &header );
+  TEST_ASSERT_TRUE( blackBoxHeaderValid( &header, &capture ) );
+
+  /* Erased flash reads as all ones */
+  memset( &bad, 0xFF, sizeof( bad ) );
+  TEST_ASSERT_FALSE( blackBoxHeaderValid( &bad, &capture ) );
+
+  bad = header;
+  bad.magic ^= 1;
+  TEST_ASSERT_FALSE( blackBoxHeaderValid( &bad, &capture ) );
+
+  bad = header;
+  bad.crc ^= 0x80000000;
+  TEST_ASSERT_FALSE( blackBoxHeaderValid( &bad, &capture ) );
+
+  /* Single bit flip in capture body */
+  capture.records[BLACK_BOX_RECORDS / 2].motor_duty ^= 1;
+  TEST_ASSERT_FALSE( blackBoxHeaderValid( &header, &capture ) );
+  capture.records[BLACK_BOX_RECORDS / 2].motor_duty ^= 1;
+  TEST_ASSERT_TRUE( blackBoxHeaderValid( &header, &capture ) );
+}
+
+TEST_CASE( "Black box records post trigger window of first fault", "[black_box]" )
+{
+  static bool initialized;
+  uint16_t adc[MEAS_CH_LAST] = { 0 };
+  uint32_t sample = 0;
+
+  if ( !initialized )
+  {
+    nvs_flash_init();
+    blackBoxInit();
+    initialized = true;
+  }
+
+  blackBoxEraseCapture();
+
+  for ( ; sample < 2 * BLACK_BOX_RECORDS; sample++ )
+  {
+    adc[0] = sample;
+    blackBoxSample( adc );
+  }
+
+  blackBoxTrigger( 7 );
+  blackBoxTrigger( 9 );
+  blackBoxSetState( BLACK_BOX_SRC_ERROR, 1 );
+
+  for ( int i = 0; i < BLACK_BOX_POST_RECORDS; i++, sample++ )
+  {
+    adc[0] = sample;
+    blackBoxSample( adc );
+  }
+
+  /* Recorder is paused while capture is saved */
+  adc[0] = 0xFFFF;
+  blackBoxSample( adc );
+
+  bool saved = false;
+  for ( int waited = 0; waited < SAVE_WAIT_MS && !saved; waited += 50 )
+  {
+    vTaskDelay( MS2ST( 50 ) );
+    saved = blackBoxReadCapture( &capture );
+  }
+
+  TEST_ASSERT_TRUE( saved );
+  TEST_ASSERT_EQUAL( 7, capture.reason );
+  TEST_ASSERT_EQUAL( BLACK_BOX_RECORDS, capture.count );
+  TEST_ASSERT_EQUAL( BLACK_BOX_PRE_RECORDS, capture.trigger_idx );
+  TEST_ASSERT_EQUAL( sample - BLACK_BOX_RECORDS, capture.records[0].adc[0] );
+  TEST_ASSERT_EQUAL( 2 * BLACK_BOX_RECORDS - 1, capture.records[capture.trigger_idx - 1].adc[0] );
+  TEST_ASSERT_EQUAL( 2 * BLACK_BOX_RECORDS, capture.records[capture.trigger_idx].adc[0] );
+  TEST_ASSERT_EQUAL( sample - 1, capture.records[BLACK_BOX_RECORDS - 1].adc[0] );
+
+  /* State change is counted in the first post trigger record */
+  TEST_ASSERT_EQUAL( 1, capture.records[capture.trigger_idx].state[BLACK_BOX_SRC_ERROR] );
+  TEST_ASSERT_EQUAL( 1, capture.records[capture.trigger_idx].transitions );
+  TEST_ASSERT_EQUAL( 0, capture.records[capture.trigger_idx + 1].transitions );
+
+  blackBoxEraseCapture();
+}
@@ -0,0 +1,77 @@
+#include "app_config.h"
+#include "boot_trace.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "unity.h"
+
+#define PHASE_MS 50
+
+static const char* const phases[] = { "nvs", "dev config", "ota", "role detect", "wifi init" };
+
+static void _last_entry( boot_trace_entry_t* entry )
+{
+  TEST_ASSERT_TRUE( bootTraceGetEntry( bootTraceGetCount() - 1, entry ) );
+}
+
+TEST_CASE( "Boot trace times phase from previous mark", "[boot_trace]" )
+{
+  boot_trace_entry_t first;
+  boot_trace_entry_t entry;
+
+  bootTraceMark( "start", BOOT_TRACE_NO_BUDGET );
+  _last_entry( &first );
+
+  vTaskDelay( MS2ST( PHASE_MS ) );
+  bootTraceMark( "phase", BOOT_TRACE_NO_BUDGET );
+  _last_entry( &entry );
+
+  TEST_ASSERT_EQUAL_STRING( "phase", entry.name );
+  TEST_ASSERT_EQUAL( entry.time_ms - first.time_ms, entry.duration_ms );
+  TEST_ASSERT_GREATER_OR_EQUAL( PHASE_MS - 10, entry.duration_ms );
+  TEST_ASSERT_LESS_THAN( PHASE_MS + 20, entry.duration_ms );
+}
+
+TEST_CASE( "Boot trace counts phases over budget", "[boot_trace]" )
+{
+  uint32_t over = bootTraceGetOverBudgetCount();
+
+  bootTraceMark( "start", BOOT_TRACE_NO_BUDGET );
+  vTaskDelay( MS2ST( PHASE_MS ) );
+  bootTraceMark( "slow", PHASE_MS / 5 );
+  TEST_ASSERT_EQUAL( over + 1, bootTraceGetOverBudgetCount() );
+
+  vTaskDelay( MS2ST( PHASE_MS ) );
+  bootTraceMark( "within", PHASE_MS * 5 );
+  vTaskDelay( MS2ST( PHASE_MS ) );
+  bootTraceMark( "unlimited", BOOT_TRACE_NO_BUDGET );
+  TEST_ASSERT_EQUAL( over + 1, bootTraceGetOverBudgetCount() );
+}
+
+TEST_CASE( "Boot trace ring keeps newest marks oldest first", "[boot_trace]" )
+{
+  const int marks = BOOT_TRACE_SIZE + 7;
+  boot_trace_entry_t entry;
+  boot_trace_entry_t prev;
+
+  for ( int i = 0; i < marks; i++ )
+  {
+    bootTraceMark( phases[i % 5], BOOT_TRACE_NO_BUDGET );
+  }
+
+  TEST_ASSERT_EQUAL( BOOT_TRACE_SIZE, bootTraceGetCount() );
+  TEST_ASSERT_FALSE( bootTraceGetEntry( BOOT_TRACE_SIZE, &entry ) );
+
+  for ( uint8_t i = 0; i < BOOT_TRACE_SIZE; i++ )
+  {
+    TEST_ASSERT_TRUE( bootTraceGetEntry( i, &entry ) );
+    TEST_ASSERT_EQUAL_STRING( phases[( marks - BOOT_TRACE_SIZE + i ) % 5], entry.name );
+
+    if ( i > 0 )
+    {
+      TEST_ASSERT_GREATER_OR_EQUAL( prev.time_ms, entry.time_ms );
+      TEST_ASSERT_EQUAL( entry.time_ms - prev.time_ms, entry.duration_ms );
+    }
+
+    prev = entry;
+  }
+}
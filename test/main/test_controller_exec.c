@@ -0,0 +1,103 @@
+#include <string.h>
+
+#include "controller_exec.h"
+#include "unity.h"
+
+#define TEST_TICKS ( CONTROLLER_EXEC_MEASURE_DIV * 50 )
+#define LOG_SIZE   ( TEST_TICKS * CONTROLLER_EXEC_STAGES )
+
+typedef struct
+{
+  controller_exec_stage_t log[LOG_SIZE];
+  uint32_t count;
+  uint32_t runs[CONTROLLER_EXEC_STAGES];
+} exec_test_ctx_t;
+
+static exec_test_ctx_t ctx;
+
+static void _record( controller_exec_stage_t stage )
+{
+  TEST_ASSERT_LESS_THAN( LOG_SIZE, ctx.count );
+  ctx.log[ctx.count++] = stage;
+  ctx.runs[stage]++;
+}
+
+static void _acquire( void )
+{
+  _record( CONTROLLER_EXEC_ACQUIRE );
+}
+
+static void _fault( void )
+{
+  _record( CONTROLLER_EXEC_FAULT );
+}
+
+static void _control( void )
+{
+  _record( CONTROLLER_EXEC_CONTROL );
+}
+
+static void _actuate( void )
+{
+  _record( CONTROLLER_EXEC_ACTUATE );
+}
+
+static const controller_exec_stage_fn_t stages[CONTROLLER_EXEC_STAGES] =
+  {
+    [CONTROLLER_EXEC_ACQUIRE] = _acquire,
+    [CONTROLLER_EXEC_FAULT] = _fault,
+    [CONTROLLER_EXEC_CONTROL] = _control,
+    [CONTROLLER_EXEC_ACTUATE] = _actuate,
+};
+
+TEST_CASE( "Executive runs stages in pipeline order", "[controller_exec]" )
+{
+  memset( &ctx, 0, sizeof( ctx ) );
+
+  for ( uint32_t tick = 0; tick < TEST_TICKS; tick++ )
+  {
+    uint32_t first = ctx.count;
+    bool acquired = controllerExecRunTick( stages, tick );
+
+    TEST_ASSERT_EQUAL( tick % CONTROLLER_EXEC_MEASURE_DIV == 0, acquired );
+    TEST_ASSERT_EQUAL( acquired ? CONTROLLER_EXEC_STAGES : CONTROLLER_EXEC_STAGES - 2, ctx.count - first );
+
+    for ( uint32_t i = first + 1; i < ctx.count; i++ )
+    {
+      TEST_ASSERT_LESS_THAN( ctx.log[i], ctx.log[i - 1] );
+    }
+
+    /* Fault check sees measurement of same tick */
+    if ( acquired )
+    {
+      TEST_ASSERT_EQUAL( CONTROLLER_EXEC_ACQUIRE, ctx.log[first] );
+      TEST_ASSERT_EQUAL( CONTROLLER_EXEC_FAULT, ctx.log[first + 1] );
+    }
+  }
+}
+
+TEST_CASE( "Executive runs fault check at acquisition rate", "[controller_exec]" )
+{
+  memset( &ctx, 0, sizeof( ctx ) );
+
+  for ( uint32_t tick = 0; tick < TEST_TICKS; tick++ )
+  {
+    controllerExecRunTick( stages, tick );
+  }
+
+  TEST_ASSERT_EQUAL( TEST_TICKS / CONTROLLER_EXEC_MEASURE_DIV, ctx.runs[CONTROLLER_EXEC_ACQUIRE] );
+  TEST_ASSERT_EQUAL( ctx.runs[CONTROLLER_EXEC_ACQUIRE], ctx.runs[CONTROLLER_EXEC_FAULT] );
+  TEST_ASSERT_EQUAL( TEST_TICKS, ctx.runs[CONTROLLER_EXEC_CONTROL] );
+  TEST_ASSERT_EQUAL( TEST_TICKS, ctx.runs[CONTROLLER_EXEC_ACTUATE] );
+}
+
+TEST_CASE( "Executive skips missing stage", "[controller_exec]" )
+{
+  /* Siewnik has no vibro actuator */
+  controller_exec_stage_fn_t no_actuate[CONTROLLER_EXEC_STAGES] = { _acquire, _fault, _control, NULL };
+
+  memset( &ctx, 0, sizeof( ctx ) );
+  TEST_ASSERT_TRUE( controllerExecRunTick( no_actuate, 0 ) );
+  TEST_ASSERT_EQUAL( CONTROLLER_EXEC_STAGES - 1, ctx.count );
+  TEST_ASSERT_EQUAL( 0, ctx.runs[CONTROLLER_EXEC_ACTUATE] );
+}
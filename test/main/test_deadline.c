@@ -0,0 +1,73 @@
+#include "deadline.h"
+#include "unity.h"
+
+#define SPAN_MS 1000
+
+TEST_CASE( "Zero initialized deadline is expired", "[deadline]" )
+{
+  deadline_t deadline = { 0 };
+
+  TEST_ASSERT_FALSE( deadlineIsArmed( &deadline ) );
+  TEST_ASSERT_TRUE( deadlineExpiredAt( &deadline, 0 ) );
+  TEST_ASSERT_TRUE( deadlineExpired( &deadline ) );
+  TEST_ASSERT_EQUAL_UINT32( 0, deadlineRemaining( &deadline ) );
+}
+
+TEST_CASE( "Deadline expires at its tick", "[deadline]" )
+{
+  deadline_t deadline;
+  TickType_t start = 1000;
+
+  deadlineArmAt( &deadline, start, SPAN_MS );
+  TEST_ASSERT_TRUE( deadlineIsArmed( &deadline ) );
+  TEST_ASSERT_FALSE( deadlineExpiredAt( &deadline, start ) );
+  TEST_ASSERT_FALSE( deadlineExpiredAt( &deadline, start + MS2ST( SPAN_MS ) - 1 ) );
+  TEST_ASSERT_TRUE( deadlineExpiredAt( &deadline, start + MS2ST( SPAN_MS ) ) );
+
+  deadlineDisarm( &deadline );
+  TEST_ASSERT_TRUE( deadlineExpiredAt( &deadline, start ) );
+}
+
+TEST_CASE( "Deadline survives tick counter wrap", "[deadline]" )
+{
+  deadline_t deadline;
+  TickType_t start = (TickType_t) -MS2ST( SPAN_MS / 2 );
+
+  /* Expiry wraps past zero and is numerically below start */
+  deadlineArmAt( &deadline, start, SPAN_MS );
+  TEST_ASSERT_LESS_THAN( start, deadline.expiry );
+
+  TEST_ASSERT_FALSE( deadlineExpiredAt( &deadline, start ) );
+  TEST_ASSERT_FALSE( deadlineExpiredAt( &deadline, (TickType_t) -1 ) );
+  TEST_ASSERT_FALSE( deadlineExpiredAt( &deadline, 0 ) );
+  TEST_ASSERT_FALSE( deadlineExpiredAt( &deadline, start + MS2ST( SPAN_MS ) - 1 ) );
+  TEST_ASSERT_TRUE( deadlineExpiredAt( &deadline, start + MS2ST( SPAN_MS ) ) );
+  TEST_ASSERT_TRUE( deadlineExpiredAt( &deadline, start + MS2ST( SPAN_MS ) + 1 ) );
+}
+
+TEST_CASE( "Deadline ending on tick zero", "[deadline]" )
+{
+  deadline_t deadline;
+  TickType_t start = (TickType_t) -MS2ST( SPAN_MS );
+
+  /* Expiry lands exactly on zero, later ticks after wrap are past it */
+  deadlineArmAt( &deadline, start, SPAN_MS );
+  TEST_ASSERT_EQUAL_UINT32( 0, deadline.expiry );
+  TEST_ASSERT_FALSE( deadlineExpiredAt( &deadline, (TickType_t) -1 ) );
+  TEST_ASSERT_TRUE( deadlineExpiredAt( &deadline, 0 ) );
+  TEST_ASSERT_TRUE( deadlineExpiredAt( &deadline, 10 ) );
+}
+
+TEST_CASE( "Deadline wait time is capped", "[deadline]" )
+{
+  deadline_t deadline;
+
+  deadlineArm( &deadline, SPAN_MS );
+  TEST_ASSERT_LESS_OR_EQUAL( MS2ST( SPAN_MS ), deadlineRemaining( &deadline ) );
+  TEST_ASSERT_GREATER_THAN( 0, deadlineRemaining( &deadline ) );
+  TEST_ASSERT_EQUAL_UINT32( 1, deadlineWaitTicks( &deadline, 1 ) );
+  TEST_ASSERT_LESS_OR_EQUAL( MS2ST( SPAN_MS ), deadlineWaitTicks( &deadline, portMAX_DELAY ) );
+
+  deadlineDisarm( &deadline );
+  TEST_ASSERT_EQUAL_UINT32( 0, deadlineWaitTicks( &deadline, portMAX_DELAY ) );
+}
@@ -0,0 +1,205 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "app_config.h"
+#include "device_list.h"
+#include "freertos/task.h"
+#include "unity.h"
+
+/* 3 of 4 synthetic APs are our devices, rest are foreign networks */
+#define SYNTHETIC_AP  120
+#define DEVICE_COUNT  ( SYNTHETIC_AP / 4 * 3 )
+#define RSSI_STRONG   -20
+#define RSSI_SPREAD   90
+#define RSSI_STRIDE   7
+
+static const char* const prefixes[] = { WIFI_SIEWNIK_NAME, WIFI_SOLARKA_NAME, WIFI_VALVE_NAME };
+static const uint8_t dev_types[] = { T_DEV_TYPE_SIEWNIK, T_DEV_TYPE_SOLARKA, T_DEV_TYPE_VALVE };
+
+/* Last char of configured name is serial number placeholder */
+static void _device_name( char name[DEVICE_LIST_NAME_SIZE], uint16_t device )
+{
+  const char* prefix = prefixes[device % 3];
+
+  snprintf( name, DEVICE_LIST_NAME_SIZE, "%.*s%u", (int) strlen( prefix ) - 1, prefix, device );
+}
+
+/* Distinct RSSI per device, scattered over scan order */
+static int8_t _device_rssi( uint16_t device )
+{
+  return RSSI_STRONG - ( device * RSSI_STRIDE ) % RSSI_SPREAD;
+}
+
+static void _feed_scan( void )
+{
+  char name[DEVICE_LIST_NAME_SIZE];
+  uint16_t device = 0;
+
+  for ( uint16_t ap = 0; ap < SYNTHETIC_AP; ap++ )
+  {
+    if ( ap % 4 == 3 )
+    {
+      snprintf( name, sizeof( name ), "Farm network %u", ap );
+      deviceListUpdate( name, RSSI_STRONG + 10 );
+    }
+    else
+    {
+      _device_name( name, device );
+      deviceListUpdate( name, _device_rssi( device ) );
+      device++;
+    }
+  }
+}
+
+static void _reset( void )
+{
+  deviceListInit();
+  deviceListClear();
+}
+
+TEST_CASE( "Device list keeps strongest devices from large scan", "[device_list]" )
+{
+  device_list_entry_t entry;
+  device_list_entry_t prev;
+  char name[DEVICE_LIST_NAME_SIZE];
+
+  _reset();
+  _feed_scan();
+  TEST_ASSERT_EQUAL( DEVICE_LIST_SIZE, deviceListGetCount() );
+
+  /* Same scan again updates entries in place */
+  _feed_scan();
+  TEST_ASSERT_EQUAL( DEVICE_LIST_SIZE, deviceListGetCount() );
+  TEST_ASSERT_FALSE( deviceListGetEntry( DEVICE_LIST_SIZE, &entry ) );
+
+  for ( uint16_t i = 0; i < DEVICE_LIST_SIZE; i++ )
+  {
+    TEST_ASSERT_TRUE( deviceListGetEntry( i, &entry ) );
+    TEST_ASSERT_EQUAL( i, deviceListFind( entry.name ) );
+    TEST_ASSERT_NOT_EQUAL( DEVICE_LIST_UNKNOWN_DEV, entry.dev_type );
+
+    if ( i > 0 )
+    {
+      TEST_ASSERT_GREATER_THAN( entry.rssi, prev.rssi );
+    }
+
+    prev = entry;
+  }
+
+  /* Distinct RSSI steps of 1 dB from RSSI_STRONG, list holds the strongest ones */
+  for ( uint16_t device = 0; device < DEVICE_COUNT; device++ )
+  {
+    _device_name( name, device );
+    int idx = deviceListFind( name );
+
+    if ( RSSI_STRONG - _device_rssi( device ) < DEVICE_LIST_SIZE )
+    {
+      TEST_ASSERT_EQUAL( RSSI_STRONG - _device_rssi( device ), idx );
+      TEST_ASSERT_TRUE( deviceListGetEntry( idx, &entry ) );
+      TEST_ASSERT_EQUAL( dev_types[device % 3], entry.dev_type );
+    }
+    else
+    {
+      TEST_ASSERT_EQUAL( -1, idx );
+    }
+  }
+}
+
+TEST_CASE( "Device list filters foreign networks by prefix", "[device_list]" )
+{
+  char name[DEVICE_LIST_NAME_SIZE];
+
+  _reset();
+
+  for ( uint16_t ap = 0; ap < SYNTHETIC_AP; ap++ )
+  {
+    snprintf( name, sizeof( name ), "Farm network %u", ap );
+    deviceListUpdate( name, RSSI_STRONG );
+  }
+
+  TEST_ASSERT_EQUAL( 0, deviceListGetCount() );
+  TEST_ASSERT_EQUAL( DEVICE_LIST_UNKNOWN_DEV, deviceListGetDevType( name ) );
+
+  for ( uint16_t device = 0; device < 3; device++ )
+  {
+    _device_name( name, device );
+    TEST_ASSERT_EQUAL( dev_types[device], deviceListGetDevType( name ) );
+  }
+}
+
+TEST_CASE( "Device list evicts weakest only for stronger device", "[device_list]" )
+{
+  device_list_entry_t entry;
+  char name[DEVICE_LIST_NAME_SIZE];
+
+  _reset();
+
+  for ( uint16_t device = 0; device < DEVICE_LIST_SIZE; device++ )
+  {
+    _device_name( name, device );
+    deviceListUpdate( name, -30 - 2 * device );
+  }
+
+  /* Weaker than whole full list is dropped */
+  _device_name( name, DEVICE_LIST_SIZE );
+  deviceListUpdate( name, -30 - 2 * DEVICE_LIST_SIZE );
+  TEST_ASSERT_EQUAL( -1, deviceListFind( name ) );
+  TEST_ASSERT_EQUAL( DEVICE_LIST_SIZE, deviceListGetCount() );
+
+  /* Stronger one takes place of weakest and is sorted in */
+  deviceListUpdate( name, -45 );
+  TEST_ASSERT_EQUAL( DEVICE_LIST_SIZE, deviceListGetCount() );
+  TEST_ASSERT_EQUAL( 8, deviceListFind( name ) );
+  _device_name( name, DEVICE_LIST_SIZE - 1 );
+  TEST_ASSERT_EQUAL( -1, deviceListFind( name ) );
+
+  /* RSSI change moves existing entry both ways */
+  _device_name( name, 20 );
+  deviceListUpdate( name, -10 );
+  TEST_ASSERT_EQUAL( 0, deviceListFind( name ) );
+  deviceListUpdate( name, -100 );
+  TEST_ASSERT_EQUAL( DEVICE_LIST_SIZE - 1, deviceListFind( name ) );
+  TEST_ASSERT_TRUE( deviceListGetEntry( DEVICE_LIST_SIZE - 1, &entry ) );
+  TEST_ASSERT_EQUAL( -100, entry.rssi );
+  TEST_ASSERT_EQUAL( DEVICE_LIST_SIZE, deviceListGetCount() );
+}
+
+TEST_CASE( "Device list ages out devices missing from scans", "[device_list]" )
+{
+  char name[DEVICE_LIST_NAME_SIZE];
+
+  _reset();
+
+  TickType_t first_scan = xTaskGetTickCount();
+
+  for ( uint16_t device = 0; device < 10; device++ )
+  {
+    _device_name( name, device );
+    deviceListUpdate( name, _device_rssi( device ) );
+  }
+
+  /* Second scan on later tick sees only even devices */
+  vTaskDelay( 2 );
+  TickType_t second_scan = xTaskGetTickCount();
+
+  for ( uint16_t device = 0; device < 10; device += 2 )
+  {
+    _device_name( name, device );
+    deviceListUpdate( name, _device_rssi( device ) );
+  }
+
+  deviceListAgeOut( first_scan + MS2ST( DEVICE_LIST_AGE_OUT_MS ) - 1 );
+  TEST_ASSERT_EQUAL( 10, deviceListGetCount() );
+
+  deviceListAgeOut( second_scan + MS2ST( DEVICE_LIST_AGE_OUT_MS ) - 1 );
+  TEST_ASSERT_EQUAL( 5, deviceListGetCount() );
+
+  for ( uint16_t device = 0; device < 10; device++ )
+  {
+    _device_name( name, device );
+    TEST_ASSERT_EQUAL( device % 2 == 0, deviceListFind( name ) >= 0 );
+  }
+
+  deviceListAgeOut( xTaskGetTickCount() + MS2ST( DEVICE_LIST_AGE_OUT_MS ) );
+  TEST_ASSERT_EQUAL( 0, deviceListGetCount() );
+}
@@ -0,0 +1,42 @@
+#include <string.h>
+
+#include "dictionary.h"
+#include "unity.h"
+
+TEST_CASE( "Dictionary has every phrase in every language", "[dictionary]" )
+{
+  TEST_ASSERT_TRUE( dictionary_validate() );
+
+  for ( int lang = 0; lang < LANGUAGE_CNT_SUPPORT; lang++ )
+  {
+    TEST_ASSERT_TRUE( dictionary_set_language( lang ) );
+
+    for ( int phrase = 0; phrase < DICT_TOP; phrase++ )
+    {
+      const char* str = dictionary_get_string( phrase );
+      TEST_ASSERT_NOT_NULL( str );
+      TEST_ASSERT_GREATER_THAN( 0, strlen( str ) );
+    }
+  }
+
+  TEST_ASSERT_TRUE( dictionary_set_language( MENU_LANGUAGE_ENGLISH ) );
+}
+
+TEST_CASE( "Dictionary looks up phrase in selected language", "[dictionary]" )
+{
+  TEST_ASSERT_TRUE( dictionary_set_language( MENU_LANGUAGE_POLISH ) );
+  TEST_ASSERT_EQUAL( MENU_LANGUAGE_POLISH, dictionary_get_language() );
+  TEST_ASSERT_EQUAL_STRING( "Inicjalizacja", dictionary_get_string( DICT_INIT ) );
+
+  TEST_ASSERT_TRUE( dictionary_set_language( MENU_LANGUAGE_GERMANY ) );
+  TEST_ASSERT_EQUAL_STRING( "Initialisierung", dictionary_get_string( DICT_INIT ) );
+
+  /* Unknown language is rejected, selected one stays */
+  TEST_ASSERT_FALSE( dictionary_set_language( MENU_LANGUAGE_TOP ) );
+  TEST_ASSERT_EQUAL( MENU_LANGUAGE_GERMANY, dictionary_get_language() );
+
+  TEST_ASSERT_EQUAL_STRING( "Bad phrase number", dictionary_get_string( DICT_TOP ) );
+
+  TEST_ASSERT_TRUE( dictionary_set_language( MENU_LANGUAGE_ENGLISH ) );
+  TEST_ASSERT_EQUAL_STRING( "Init", dictionary_get_string( DICT_INIT ) );
+}
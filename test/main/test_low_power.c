@@ -0,0 +1,38 @@
+#include "freertos/FreeRTOS.h"
+#include "low_power.h"
+#include "unity.h"
+
+#define PERIOD_US ( 2 * 1000 * 1000 )
+
+TEST_CASE( "Low power stats from counter deltas", "[low_power]" )
+{
+  low_power_stats_t stats;
+
+  /* Idle time is summed over idle tasks of all cores */
+  lowPowerCalcStats( &stats, PERIOD_US, PERIOD_US * portNUM_PROCESSORS * 3 / 4, 50 );
+  TEST_ASSERT_EQUAL( 2000, stats.period_ms );
+  TEST_ASSERT_EQUAL( 75, stats.idle_percent );
+  TEST_ASSERT_EQUAL( 25, stats.wakeups_per_s );
+
+  lowPowerCalcStats( &stats, PERIOD_US, PERIOD_US * portNUM_PROCESSORS, 0 );
+  TEST_ASSERT_EQUAL( 100, stats.idle_percent );
+  TEST_ASSERT_EQUAL( 0, stats.wakeups_per_s );
+}
+
+TEST_CASE( "Low power stats across idle counter wrap", "[low_power]" )
+{
+  low_power_stats_t stats;
+  uint32_t last_idle = UINT32_MAX - PERIOD_US / 4;
+  uint32_t idle = last_idle + PERIOD_US * portNUM_PROCESSORS / 2;
+
+  TEST_ASSERT_LESS_THAN( last_idle, idle );
+  lowPowerCalcStats( &stats, PERIOD_US, idle - last_idle, 2 );
+  TEST_ASSERT_EQUAL( 50, stats.idle_percent );
+  TEST_ASSERT_EQUAL( 1, stats.wakeups_per_s );
+
+  /* No time passed, no rates */
+  lowPowerCalcStats( &stats, 0, 1000, 10 );
+  TEST_ASSERT_EQUAL( 0, stats.period_ms );
+  TEST_ASSERT_EQUAL( 0, stats.idle_percent );
+  TEST_ASSERT_EQUAL( 0, stats.wakeups_per_s );
+}
@@ -0,0 +1,199 @@
+#include <stdio.h>
+
+#include "esp_timer.h"
+#include "measure_history.h"
+#include "unity.h"
+
+#define SAMPLE_PERIOD_MS 100
+#define MAX_BLOCK_SAMPLES 64
+#define BENCH_SAMPLES     3000
+
+static uint8_t block[MEASURE_HISTORY_BLOCK_SIZE];
+static history_sample_t decoded[MAX_BLOCK_SAMPLES];
+
+/* Slow ramps with noise, wraps and full scale jumps to hit multi byte varints */
+static void _sample( uint32_t i, history_sample_t* sample )
+{
+  sample->time_ms = 1000 + i * SAMPLE_PERIOD_MS + i % 3;
+  sample->values[HISTORY_CH_CURRENT_MOTOR] = i % 50 == 0 ? 0xFFFF : 2000 + ( i * 37 ) % 300;
+  sample->values[HISTORY_CH_VOLTAGE_ACCUM] = 12000 - i % 500;
+  sample->values[HISTORY_CH_TEMPERATURE] = 25;
+  sample->values[HISTORY_CH_VOLTAGE_SERVO] = i % 7 == 0 ? 0 : 4000;
+  sample->values[HISTORY_CH_SILOS_LEVEL] = (uint16_t) ( i * 1000 );
+}
+
+static void _append( uint32_t from, uint32_t count )
+{
+  history_sample_t sample;
+
+  for ( uint32_t i = from; i < from + count; i++ )
+  {
+    _sample( i, &sample );
+    measureHistoryAppend( &sample );
+  }
+}
+
+static void _assert_sample( uint32_t i, const history_sample_t* sample )
+{
+  history_sample_t expected;
+
+  _sample( i, &expected );
+  TEST_ASSERT_EQUAL_UINT32( expected.time_ms, sample->time_ms );
+  TEST_ASSERT_EQUAL_MEMORY( expected.values, sample->values, sizeof( expected.values ) );
+}
+
+TEST_CASE( "History blocks decode to appended samples", "[measure_history]" )
+{
+  const uint32_t total = 200;
+  uint32_t cursor = 0;
+  uint32_t next = 0;
+  size_t len;
+
+  measureHistoryInit();
+  _append( 0, total );
+
+  while ( ( len = measureHistoryExport( &cursor, block, sizeof( block ) ) ) > 0 )
+  {
+    size_t count = measureHistoryDecodeBlock( block, len, decoded, MAX_BLOCK_SAMPLES );
+
+    TEST_ASSERT_GREATER_THAN( 0, count );
+
+    for ( size_t i = 0; i < count; i++ )
+    {
+      _assert_sample( next++, &decoded[i] );
+    }
+  }
+
+  /* Several blocks completed, samples of block being filled are not exported yet */
+  TEST_ASSERT_GREATER_THAN( 1, cursor );
+  TEST_ASSERT_LESS_THAN( total, next );
+
+  uint32_t oldest;
+  uint32_t newest;
+
+  measureHistoryGetSeqRange( &oldest, &newest );
+  TEST_ASSERT_EQUAL_UINT32( newest, cursor );
+
+  len = measureHistoryCopyBlock( newest, block, sizeof( block ) );
+  size_t count = measureHistoryDecodeBlock( block, len, decoded, MAX_BLOCK_SAMPLES );
+
+  TEST_ASSERT_EQUAL( total, next + count );
+  _assert_sample( total - 1, &decoded[count - 1] );
+}
+
+TEST_CASE( "Each history block is a keyframe", "[measure_history]" )
+{
+  uint32_t oldest;
+  uint32_t newest;
+
+  measureHistoryInit();
+  _append( 0, 200 );
+  measureHistoryGetSeqRange( &oldest, &newest );
+  TEST_ASSERT_GREATER_THAN( 1, newest );
+
+  size_t len = measureHistoryCopyBlock( 0, block, sizeof( block ) );
+  size_t first = measureHistoryDecodeBlock( block, len, decoded, MAX_BLOCK_SAMPLES );
+
+  TEST_ASSERT_GREATER_THAN( 0, first );
+
+  /* Second block decoded alone starts with absolute values */
+  len = measureHistoryCopyBlock( 1, block, sizeof( block ) );
+  TEST_ASSERT_GREATER_THAN( 0, measureHistoryDecodeBlock( block, len, decoded, MAX_BLOCK_SAMPLES ) );
+  _assert_sample( first, &decoded[0] );
+}
+
+TEST_CASE( "Truncated history block decodes complete samples only", "[measure_history]" )
+{
+  measureHistoryInit();
+  _append( 0, 10 );
+
+  size_t len = measureHistoryCopyBlock( 0, block, sizeof( block ) );
+
+  TEST_ASSERT_EQUAL( 10, measureHistoryDecodeBlock( block, len, decoded, MAX_BLOCK_SAMPLES ) );
+  TEST_ASSERT_EQUAL( 4, measureHistoryDecodeBlock( block, len, decoded, 4 ) );
+  TEST_ASSERT_EQUAL( 0, measureHistoryDecodeBlock( block, len - 1, decoded, MAX_BLOCK_SAMPLES ) );
+  TEST_ASSERT_EQUAL( 0, measureHistoryDecodeBlock( block, MEASURE_HISTORY_HEADER_SIZE - 1, decoded, MAX_BLOCK_SAMPLES ) );
+}
+
+TEST_CASE( "History export skips overwritten blocks", "[measure_history]" )
+{
+  uint32_t oldest;
+  uint32_t newest;
+  uint32_t cursor = 0;
+  uint32_t i = 0;
+
+  measureHistoryInit();
+
+  do
+  {
+    _append( i++, 1 );
+    measureHistoryGetSeqRange( &oldest, &newest );
+  } while ( oldest < 2 );
+
+  TEST_ASSERT_EQUAL( 0, measureHistoryCopyBlock( 0, block, sizeof( block ) ) );
+  TEST_ASSERT_EQUAL_UINT32( MEASURE_HISTORY_BLOCK_COUNT + 1, newest );
+
+  size_t len = measureHistoryExport( &cursor, block, sizeof( block ) );
+
+  TEST_ASSERT_GREATER_THAN( 0, len );
+  TEST_ASSERT_EQUAL_UINT32( oldest + 1, cursor );
+  TEST_ASSERT_GREATER_THAN( 0, measureHistoryDecodeBlock( block, len, decoded, MAX_BLOCK_SAMPLES ) );
+}
+
+/* Working machine, small noise on current and accumulator, slow silos drain */
+static void _typical_sample( uint32_t i, history_sample_t* sample )
+{
+  sample->time_ms = i * SAMPLE_PERIOD_MS + i % 2;
+  sample->values[HISTORY_CH_CURRENT_MOTOR] = 1800 + ( i * 13 ) % 40;
+  sample->values[HISTORY_CH_VOLTAGE_ACCUM] = 12600 - i / 20 + ( i * 7 ) % 5;
+  sample->values[HISTORY_CH_TEMPERATURE] = 30 + i / 600;
+  sample->values[HISTORY_CH_VOLTAGE_SERVO] = 2400;
+  sample->values[HISTORY_CH_SILOS_LEVEL] = 80 - i / 100;
+}
+
+TEST_CASE( "History encode and decode throughput and compression", "[measure_history]" )
+{
+  history_sample_t sample;
+  uint32_t cursor = 0;
+  uint32_t encoded = 0;
+  uint32_t samples = 0;
+  size_t count = 0;
+  size_t len;
+
+  measureHistoryInit();
+
+  int64_t start = esp_timer_get_time();
+  for ( uint32_t i = 0; i < BENCH_SAMPLES; i++ )
+  {
+    _typical_sample( i, &sample );
+    measureHistoryAppend( &sample );
+  }
+  uint32_t encode_us = (uint32_t) ( esp_timer_get_time() - start );
+
+  /* Export copies are timed with decode, it is what the history reader does */
+  start = esp_timer_get_time();
+  while ( ( len = measureHistoryExport( &cursor, block, sizeof( block ) ) ) > 0 )
+  {
+    count = measureHistoryDecodeBlock( block, len, decoded, MAX_BLOCK_SAMPLES );
+    samples += count;
+    encoded += len;
+  }
+  uint32_t decode_us = (uint32_t) ( esp_timer_get_time() - start );
+
+  /* Raw sample is time and channels in fixed width fields, encoded size includes block headers */
+  uint32_t raw = samples * ( sizeof( sample.time_ms ) + sizeof( sample.values ) );
+
+  printf( "History %lu samples: encode %lu ns/sample, decode %lu ns/sample, %lu.%02lu bytes/sample, ratio %lu.%02lu\n",
+          (unsigned long) samples, (unsigned long) ( encode_us * 1000ULL / BENCH_SAMPLES ),
+          (unsigned long) ( decode_us * 1000ULL / samples ), (unsigned long) ( encoded / samples ),
+          (unsigned long) ( encoded * 100 / samples % 100 ), (unsigned long) ( raw / encoded ),
+          (unsigned long) ( raw * 100 / encoded % 100 ) );
+
+  TEST_ASSERT_GREATER_THAN( BENCH_SAMPLES / 2, samples );
+  _typical_sample( samples - 1, &sample );
+  TEST_ASSERT_EQUAL_UINT32( sample.time_ms, decoded[count - 1].time_ms );
+  TEST_ASSERT_EQUAL_MEMORY( sample.values, decoded[count - 1].values, sizeof( sample.values ) );
+
+  /* Header documents about 6.5 bytes per sample for this kind of signal */
+  TEST_ASSERT_LESS_OR_EQUAL( 7 * samples, encoded );
+}
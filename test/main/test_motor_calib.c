@@ -0,0 +1,143 @@
+#include "motor_calib.h"
+#include "unity.h"
+
+#define MIN_CURRENT 100
+#define MAX_CURRENT 1500
+#define MAX_STEPS   2000
+
+/* Motor stands below 25 % PWM, current rises until 80 % and is flat above */
+static uint16_t _range_current( uint8_t duty )
+{
+  if ( duty < 25 )
+  {
+    return 0;
+  }
+
+  if ( duty >= 80 )
+  {
+    return 1000;
+  }
+
+  return 200 + ( duty - 25 ) * 800 / 55;
+}
+
+static motor_calib_phase_t _run( motor_calib_t* calib, const uint16_t curve[MOTOR_CALIB_POINTS], bool dead )
+{
+  motorCalibStart( calib, MIN_CURRENT, MAX_CURRENT );
+
+  for ( int i = 0; i < MAX_STEPS; i++ )
+  {
+    uint16_t current;
+
+    if ( dead )
+    {
+      current = 0;
+    }
+    else if ( calib->phase == MOTOR_CALIB_RANGE )
+    {
+      current = _range_current( motorCalibDuty( calib ) );
+    }
+    else
+    {
+      current = curve[motorCalibDuty( calib ) / MOTOR_CALIB_DUTY_STEP - 1];
+    }
+
+    motor_calib_phase_t phase = motorCalibStep( calib, current );
+
+    if ( phase == MOTOR_CALIB_DONE || phase == MOTOR_CALIB_FAILED || phase == MOTOR_CALIB_OVERCURRENT )
+    {
+      return phase;
+    }
+  }
+
+  return calib->phase;
+}
+
+TEST_CASE( "Range sweep finds min and max PWM", "[motor_calib]" )
+{
+  static const uint16_t curve[MOTOR_CALIB_POINTS] = { 300, 500, 600, 700, 900 };
+  motor_calib_t calib;
+
+  TEST_ASSERT_EQUAL( MOTOR_CALIB_DONE, _run( &calib, curve, false ) );
+  TEST_ASSERT_EQUAL( 25, calib.min_duty );
+  TEST_ASSERT_EQUAL( 80, calib.max_duty );
+  TEST_ASSERT_EQUAL_MEMORY( curve, calib.table, sizeof( curve ) );
+  TEST_ASSERT_TRUE( motorCalibTableIsValid( calib.table ) );
+}
+
+TEST_CASE( "Dips in measured curve are flattened", "[motor_calib]" )
+{
+  static const uint16_t curve[MOTOR_CALIB_POINTS] = { 300, 500, 450, 700, 650 };
+  static const uint16_t expected[MOTOR_CALIB_POINTS] = { 300, 500, 500, 700, 700 };
+  motor_calib_t calib;
+
+  TEST_ASSERT_EQUAL( MOTOR_CALIB_DONE, _run( &calib, curve, false ) );
+  TEST_ASSERT_EQUAL_MEMORY( expected, calib.table, sizeof( expected ) );
+}
+
+TEST_CASE( "Motor without current fails calibration", "[motor_calib]" )
+{
+  static const uint16_t curve[MOTOR_CALIB_POINTS] = { 0 };
+  motor_calib_t calib;
+
+  TEST_ASSERT_EQUAL( MOTOR_CALIB_FAILED, _run( &calib, curve, true ) );
+  TEST_ASSERT_EQUAL( MOTOR_CALIB_FAILED, motorCalibStep( &calib, 1000 ) );
+}
+
+TEST_CASE( "Overcurrent sample aborts range sweep", "[motor_calib]" )
+{
+  motor_calib_t calib;
+
+  motorCalibStart( &calib, MIN_CURRENT, MAX_CURRENT );
+
+  /* Through start settle and into second range point */
+  for ( int i = 0; i < MOTOR_CALIB_START_SETTLE + MOTOR_CALIB_SAMPLES + 1; i++ )
+  {
+    TEST_ASSERT_EQUAL( MOTOR_CALIB_RANGE, motorCalibStep( &calib, MAX_CURRENT ) );
+  }
+
+  uint8_t duty = motorCalibDuty( &calib );
+
+  /* Single sample over limit, even while settling, ends sweep */
+  TEST_ASSERT_EQUAL( MOTOR_CALIB_OVERCURRENT, motorCalibStep( &calib, MAX_CURRENT + 1 ) );
+  TEST_ASSERT_EQUAL( MOTOR_CALIB_RANGE_STEP * 2, duty );
+  TEST_ASSERT_EQUAL( MOTOR_CALIB_OVERCURRENT, motorCalibStep( &calib, 0 ) );
+  TEST_ASSERT_FALSE( motorCalibTableIsValid( calib.table ) );
+}
+
+TEST_CASE( "Overcurrent sample aborts curve measurement", "[motor_calib]" )
+{
+  static const uint16_t curve[MOTOR_CALIB_POINTS] = { 300, 500, 600, 700, MAX_CURRENT + 100 };
+  motor_calib_t calib;
+
+  TEST_ASSERT_EQUAL( MOTOR_CALIB_OVERCURRENT, _run( &calib, curve, false ) );
+  TEST_ASSERT_EQUAL( MOTOR_CALIB_DUTY_STEP * MOTOR_CALIB_POINTS, motorCalibDuty( &calib ) );
+  TEST_ASSERT_EQUAL( 0, calib.table[MOTOR_CALIB_POINTS - 1] );
+}
+
+TEST_CASE( "Table with missing point is not valid", "[motor_calib]" )
+{
+  uint16_t table[MOTOR_CALIB_POINTS] = { 100, 200, 300, 400, 500 };
+
+  TEST_ASSERT_TRUE( motorCalibTableIsValid( table ) );
+  table[2] = 0;
+  TEST_ASSERT_FALSE( motorCalibTableIsValid( table ) );
+}
+
+TEST_CASE( "Threshold interpolates curve with headroom and offset", "[motor_calib]" )
+{
+  static const uint16_t table[MOTOR_CALIB_POINTS] = { 100, 200, 300, 400, 500 };
+
+  TEST_ASSERT_EQUAL( 100, motorCalibThreshold( table, 0, 100, 0 ) );
+  TEST_ASSERT_EQUAL( 100, motorCalibThreshold( table, 20, 100, 0 ) );
+  TEST_ASSERT_EQUAL( 150, motorCalibThreshold( table, 30, 100, 0 ) );
+  TEST_ASSERT_EQUAL( 500, motorCalibThreshold( table, 100, 100, 0 ) );
+  TEST_ASSERT_EQUAL( 235, motorCalibThreshold( table, 30, 150, 10 ) );
+}
+
+TEST_CASE( "Threshold follows falling segment", "[motor_calib]" )
+{
+  static const uint16_t table[MOTOR_CALIB_POINTS] = { 100, 200, 300, 400, 300 };
+
+  TEST_ASSERT_EQUAL( 350, motorCalibThreshold( table, 90, 100, 0 ) );
+}
@@ -0,0 +1,49 @@
+#include "app_config.h"
+#include "panel_power.h"
+#include "unity.h"
+
+#define DIM_MS        ( 30 * 1000 )
+#define POWER_SAVE_MS ( 120 * 1000 )
+
+TEST_CASE( "Panel dims and enters power save after idle time", "[panel_power]" )
+{
+  TEST_ASSERT_EQUAL( PANEL_POWER_ACTIVE, panelPowerStateForIdle( PANEL_POWER_ACTIVE, MS2ST( DIM_MS ) - 1 ) );
+  TEST_ASSERT_EQUAL( PANEL_POWER_DIMMED, panelPowerStateForIdle( PANEL_POWER_ACTIVE, MS2ST( DIM_MS ) ) );
+  TEST_ASSERT_EQUAL( PANEL_POWER_DIMMED, panelPowerStateForIdle( PANEL_POWER_DIMMED, MS2ST( POWER_SAVE_MS ) - 1 ) );
+  TEST_ASSERT_EQUAL( PANEL_POWER_SAVE, panelPowerStateForIdle( PANEL_POWER_DIMMED, MS2ST( POWER_SAVE_MS ) ) );
+
+  /* Long idle without any frame in between goes straight to power save */
+  TEST_ASSERT_EQUAL( PANEL_POWER_SAVE, panelPowerStateForIdle( PANEL_POWER_ACTIVE, MS2ST( 10 * POWER_SAVE_MS ) ) );
+
+  /* Only activity brings panel back */
+  TEST_ASSERT_EQUAL( PANEL_POWER_SAVE, panelPowerStateForIdle( PANEL_POWER_SAVE, 0 ) );
+}
+
+TEST_CASE( "Panel contrast follows battery voltage and state", "[panel_power]" )
+{
+  TEST_ASSERT_EQUAL( 255, panelPowerTargetContrast( PANEL_POWER_ACTIVE, 4.1, false ) );
+  TEST_ASSERT_EQUAL( 96, panelPowerTargetContrast( PANEL_POWER_ACTIVE, 3.3, false ) );
+  TEST_ASSERT_EQUAL( 255, panelPowerTargetContrast( PANEL_POWER_ACTIVE, 3.3, true ) );
+
+  /* Linear between low and full contrast voltage */
+  uint8_t mid = panelPowerTargetContrast( PANEL_POWER_ACTIVE, 3.6, false );
+  TEST_ASSERT_UINT32_WITHIN( 1, ( 96 + 255 ) / 2, mid );
+  TEST_ASSERT_LESS_THAN( panelPowerTargetContrast( PANEL_POWER_ACTIVE, 3.7, false ), mid );
+
+  TEST_ASSERT_EQUAL( 255 / 4, panelPowerTargetContrast( PANEL_POWER_DIMMED, 4.1, false ) );
+  TEST_ASSERT_EQUAL( 96 / 4, panelPowerTargetContrast( PANEL_POWER_DIMMED, 3.3, false ) );
+  TEST_ASSERT_EQUAL( 16, panelPowerTargetContrast( PANEL_POWER_SAVE, 4.1, true ) );
+}
+
+TEST_CASE( "Panel contrast ignores small voltage steps", "[panel_power]" )
+{
+  TEST_ASSERT_FALSE( panelPowerContrastChange( 175, 175 ) );
+  TEST_ASSERT_FALSE( panelPowerContrastChange( 175, 182 ) );
+  TEST_ASSERT_FALSE( panelPowerContrastChange( 175, 168 ) );
+  TEST_ASSERT_TRUE( panelPowerContrastChange( 175, 183 ) );
+  TEST_ASSERT_TRUE( panelPowerContrastChange( 175, 167 ) );
+
+  /* Limits are always reached, charger plug in restores full contrast */
+  TEST_ASSERT_TRUE( panelPowerContrastChange( 250, 255 ) );
+  TEST_ASSERT_TRUE( panelPowerContrastChange( 20, 16 ) );
+}
@@ -0,0 +1,61 @@
+#include <stdio.h>
+
+#include "esp_cpu.h"
+#include "param_access.h"
+#include "unity.h"
+
+#define BENCH_CALLS 10000
+
+TEST_CASE( "Single writer parameter is read from mirror", "[param_access]" )
+{
+  PARAM_CURRENT_MOTOR_set( 1234 );
+  TEST_ASSERT_EQUAL( 1234, PARAM_CURRENT_MOTOR_get() );
+  TEST_ASSERT_EQUAL( 1234, parameters_getValue( PARAM_CURRENT_MOTOR ) );
+
+  PARAM_CURRENT_MOTOR_set( 0x10000 );
+  TEST_ASSERT_EQUAL( 0xFFFF, PARAM_CURRENT_MOTOR_get() );
+}
+
+TEST_CASE( "HTTP written parameter is read from parameters", "[param_access]" )
+{
+  /* Written past typed setter as HTTP API does */
+  parameters_setValue( PARAM_VIBRO_DUTY_PWM, 70 );
+  TEST_ASSERT_EQUAL( 70, PARAM_VIBRO_DUTY_PWM_get() );
+
+  PARAM_VIBRO_DUTY_PWM_set( 200 );
+  TEST_ASSERT_EQUAL( 100, parameters_getValue( PARAM_VIBRO_DUTY_PWM ) );
+}
+
+TEST_CASE( "Parameter accessor cost", "[param_access]" )
+{
+  volatile uint32_t sink = 0;
+
+  PARAM_CURRENT_MOTOR_set( 100 );
+
+  uint32_t start = esp_cpu_get_cycle_count();
+  for ( int i = 0; i < BENCH_CALLS; i++ )
+  {
+    sink += PARAM_CURRENT_MOTOR_get();
+  }
+  uint32_t mirror_cycles = esp_cpu_get_cycle_count() - start;
+
+  start = esp_cpu_get_cycle_count();
+  for ( int i = 0; i < BENCH_CALLS; i++ )
+  {
+    sink += parameters_getValue( PARAM_CURRENT_MOTOR );
+  }
+  uint32_t store_cycles = esp_cpu_get_cycle_count() - start;
+
+  start = esp_cpu_get_cycle_count();
+  for ( int i = 0; i < BENCH_CALLS; i++ )
+  {
+    PARAM_CURRENT_MOTOR_set( i );
+  }
+  uint32_t set_cycles = esp_cpu_get_cycle_count() - start;
+
+  printf( "Parameter access cycles per call: mirror get %lu, parameters_getValue %lu, typed set %lu\n",
+          (unsigned long) ( mirror_cycles / BENCH_CALLS ), (unsigned long) ( store_cycles / BENCH_CALLS ),
+          (unsigned long) ( set_cycles / BENCH_CALLS ) );
+
+  TEST_ASSERT_LESS_THAN( store_cycles, mirror_cycles );
+}
@@ -0,0 +1,157 @@
+#include "app_config.h"
+#include "nvs.h"
+#include "nvs_flash.h"
+#include "param_access.h"
+#include "param_persist.h"
+#include "parameters.h"
+#include "unity.h"
+
+/* Same namespace as param_persist.c, tests start without delta records */
+#define PERSIST_NVS_NAMESPACE "param_delta"
+
+static const uint32_t param_min[] =
+  {
+#define PARAM( _id, _min, _max, _def, _name ) [_id] = _min,
+    PARAMETERS_U32_LIST
+#undef PARAM
+};
+
+static const uint32_t param_max[] =
+  {
+#define PARAM( _id, _min, _max, _def, _name ) [_id] = _max,
+    PARAMETERS_U32_LIST
+#undef PARAM
+};
+
+static void _init( void )
+{
+  static bool initialized;
+
+  if ( initialized )
+  {
+    return;
+  }
+
+  nvs_handle_t handle;
+
+  nvs_flash_init();
+  TEST_ASSERT_EQUAL( ESP_OK, nvs_open( PERSIST_NVS_NAMESPACE, NVS_READWRITE, &handle ) );
+  nvs_erase_all( handle );
+  nvs_commit( handle );
+  nvs_close( handle );
+
+  paramPersistInit();
+  initialized = true;
+}
+
+/* In range value different from current one */
+static uint32_t _other_value( uint32_t param )
+{
+  uint32_t value = parameters_getValue( param );
+
+  return value < param_max[param] ? value + 1 : value - 1;
+}
+
+static void _stats( param_persist_stats_t* stats )
+{
+  paramPersistFlush();
+  paramPersistGetStats( stats );
+}
+
+TEST_CASE( "Persist writes no record for value equal to image", "[param_persist]" )
+{
+  param_persist_stats_t before;
+  param_persist_stats_t after;
+
+  _init();
+  _stats( &before );
+
+  paramPersistMarkDirty( PARAM_MOTOR );
+  paramPersistFlush();
+  paramPersistGetStats( &after );
+  TEST_ASSERT_EQUAL( before.records, after.records );
+  TEST_ASSERT_EQUAL( before.deltas, after.deltas );
+
+  /* Changed and changed back inside one window */
+  uint32_t value = parameters_getValue( PARAM_MOTOR );
+  paramPersistSetValue( PARAM_MOTOR, _other_value( PARAM_MOTOR ) );
+  paramPersistSetValue( PARAM_MOTOR, value );
+  paramPersistFlush();
+  paramPersistGetStats( &after );
+  TEST_ASSERT_EQUAL( before.records, after.records );
+  TEST_ASSERT_EQUAL( before.deltas, after.deltas );
+}
+
+TEST_CASE( "Persist coalesces writes in window to one record", "[param_persist]" )
+{
+  param_persist_stats_t before;
+  param_persist_stats_t after;
+
+  _init();
+  _stats( &before );
+
+  uint32_t image = parameters_getValue( PARAM_SERVO );
+  uint32_t value = _other_value( PARAM_SERVO );
+
+  for ( int i = 0; i < 10; i++ )
+  {
+    paramPersistSetValue( PARAM_SERVO, i % 2 ? image : value );
+  }
+
+  paramPersistSetValue( PARAM_SERVO, value );
+  paramPersistFlush();
+  paramPersistGetStats( &after );
+  TEST_ASSERT_EQUAL( before.records + 1, after.records );
+  TEST_ASSERT_EQUAL( before.deltas + 1, after.deltas );
+  TEST_ASSERT_EQUAL( before.flushes + 1, after.flushes );
+
+  /* Back to image value drops the record */
+  paramPersistSetValue( PARAM_SERVO, image );
+  paramPersistFlush();
+  paramPersistGetStats( &after );
+  TEST_ASSERT_EQUAL( before.deltas, after.deltas );
+  TEST_ASSERT_EQUAL( image, parameters_getValue( PARAM_SERVO ) );
+}
+
+TEST_CASE( "Persist compacts delta records into full image", "[param_persist]" )
+{
+  param_persist_stats_t before;
+  param_persist_stats_t after;
+  uint32_t previous[PARAM_ACCESS_COUNT];
+  uint32_t changed = 0;
+
+  _init();
+  _stats( &before );
+
+  for ( uint32_t param = 0; param < PARAM_ACCESS_COUNT; param++ )
+  {
+    previous[param] = parameters_getValue( param );
+    if ( param_min[param] == param_max[param] || changed > PARAM_PERSIST_COMPACT_COUNT )
+    {
+      continue;
+    }
+
+    paramPersistSetValue( param, _other_value( param ) );
+    changed += parameters_getValue( param ) != previous[param];
+  }
+
+  TEST_ASSERT_GREATER_THAN( PARAM_PERSIST_COMPACT_COUNT, before.deltas + changed );
+
+  paramPersistFlush();
+  paramPersistGetStats( &after );
+  TEST_ASSERT_EQUAL( before.compactions + 1, after.compactions );
+  TEST_ASSERT_EQUAL( 0, after.deltas );
+
+  /* Compaction keeps values, new image is the base for next deltas */
+  uint32_t param = PARAM_MOTOR;
+  TEST_ASSERT_NOT_EQUAL( previous[param], parameters_getValue( param ) );
+  paramPersistMarkDirty( param );
+  paramPersistFlush();
+  paramPersistGetStats( &after );
+  TEST_ASSERT_EQUAL( 0, after.deltas );
+
+  paramPersistSetValue( param, previous[param] );
+  paramPersistFlush();
+  paramPersistGetStats( &after );
+  TEST_ASSERT_EQUAL( 1, after.deltas );
+}
@@ -0,0 +1,88 @@
+#include "app_config.h"
+#include "render_sched.h"
+#include "unity.h"
+
+#define TARGET_FPS     10
+#define MIN_REFRESH_MS 250
+
+static render_sched_t sched;
+
+static void _reset( TickType_t now )
+{
+  sched = ( render_sched_t ){ .target_fps = TARGET_FPS, .min_refresh_ms = MIN_REFRESH_MS };
+  renderSchedMarkDirty( &sched );
+  TEST_ASSERT_TRUE( renderSchedBeginAt( &sched, now, 0, false ) );
+  renderSchedEnd( &sched );
+}
+
+/* Frames drawn over given number of ticks, one call per tick as menu driver does */
+static uint32_t _frames( TickType_t* now, TickType_t ticks, uint32_t signature, bool animated )
+{
+  uint32_t frames = 0;
+
+  for ( TickType_t i = 0; i < ticks; i++ )
+  {
+    ( *now )++;
+    if ( renderSchedBeginAt( &sched, *now, signature, animated ) )
+    {
+      renderSchedEnd( &sched );
+      frames++;
+    }
+  }
+
+  return frames;
+}
+
+TEST_CASE( "Render scheduler draws only on change", "[render_sched]" )
+{
+  TickType_t now = 1000;
+  uint32_t hash = renderSchedHash( 0, 50 );
+
+  _reset( now );
+  TEST_ASSERT_NOT_EQUAL( hash, renderSchedHash( 0, 51 ) );
+
+  TEST_ASSERT_TRUE( renderSchedBeginAt( &sched, ++now, hash, false ) );
+  renderSchedEnd( &sched );
+  TEST_ASSERT_FALSE( renderSchedBeginAt( &sched, ++now, hash, false ) );
+
+  /* Input change draws at once, even right after a frame */
+  hash = renderSchedHash( hash, 1 );
+  TEST_ASSERT_TRUE( renderSchedBeginAt( &sched, now, hash, false ) );
+  renderSchedEnd( &sched );
+
+  renderSchedMarkDirty( &sched );
+  TEST_ASSERT_TRUE( renderSchedBeginAt( &sched, now, hash, false ) );
+  renderSchedEnd( &sched );
+  TEST_ASSERT_FALSE( renderSchedBeginAt( &sched, now, hash, false ) );
+
+  render_stats_t stats;
+  renderSchedGetStats( &sched, &stats );
+  TEST_ASSERT_EQUAL( 4, stats.frames );
+  TEST_ASSERT_EQUAL( 2, stats.skipped );
+}
+
+TEST_CASE( "Render scheduler keeps refresh floor on static screen", "[render_sched]" )
+{
+  TickType_t now = 1000;
+
+  _reset( now );
+
+  /* Only the floor redraws, 4 frames per second */
+  TEST_ASSERT_EQUAL( 4, _frames( &now, MS2ST( 1000 ), 0, false ) );
+}
+
+TEST_CASE( "Render scheduler animates at target rate", "[render_sched]" )
+{
+  TickType_t now = 1000;
+
+  _reset( now );
+  TEST_ASSERT_EQUAL( TARGET_FPS, _frames( &now, MS2ST( 1000 ), 0, true ) );
+
+  /* Animation stops with motor, screen falls back to the floor */
+  TEST_ASSERT_EQUAL( 4, _frames( &now, MS2ST( 1000 ), 0, false ) );
+
+  /* Tick counter wrap does not stall drawing */
+  now = (TickType_t) -MS2ST( 500 );
+  _reset( now );
+  TEST_ASSERT_EQUAL( TARGET_FPS, _frames( &now, MS2ST( 1000 ), 0, true ) );
+}
@@ -0,0 +1,98 @@
+#include "app_config.h"
+#include "role_detect.h"
+#include "unity.h"
+#include "wifidrv.h"
+
+#define SCRIPT_MAX 8
+
+/* Scripted display probe, results are replayed in order */
+typedef struct
+{
+  esp_err_t results[SCRIPT_MAX];
+  int count;
+  int calls;
+} probe_script_t;
+
+static probe_script_t script;
+
+static esp_err_t _scripted_probe( void )
+{
+  TEST_ASSERT_LESS_THAN( script.count, script.calls );
+  return script.results[script.calls++];
+}
+
+static void _script( const esp_err_t* results, int count )
+{
+  TEST_ASSERT_LESS_OR_EQUAL( SCRIPT_MAX, count );
+  script.count = count;
+  script.calls = 0;
+  for ( int i = 0; i < count; i++ )
+  {
+    script.results[i] = results[i];
+  }
+}
+
+TEST_CASE( "Role source prefers strap, then controller hint", "[role_detect]" )
+{
+  TEST_ASSERT_EQUAL( ROLE_SOURCE_STRAP, roleDetectSource( true, true, T_WIFI_TYPE_SERVER ) );
+  TEST_ASSERT_EQUAL( ROLE_SOURCE_STRAP, roleDetectSource( true, false, 0 ) );
+  TEST_ASSERT_EQUAL( ROLE_SOURCE_HINT, roleDetectSource( false, true, T_WIFI_TYPE_SERVER ) );
+
+  /* Panel hint still probes, display init needs the bus anyway */
+  TEST_ASSERT_EQUAL( ROLE_SOURCE_PROBE, roleDetectSource( false, true, T_WIFI_TYPE_CLIENT ) );
+  TEST_ASSERT_EQUAL( ROLE_SOURCE_PROBE, roleDetectSource( false, false, T_WIFI_TYPE_SERVER ) );
+}
+
+TEST_CASE( "Role probe stops at first ACK", "[role_detect]" )
+{
+  const esp_err_t ack[] = { ESP_OK };
+  const esp_err_t late_ack[] = { ESP_ERR_TIMEOUT, ESP_FAIL, ESP_OK };
+  bool confirmed = false;
+
+  _script( ack, 1 );
+  TEST_ASSERT_EQUAL( T_WIFI_TYPE_CLIENT, roleDetectProbe( _scripted_probe, &confirmed ) );
+  TEST_ASSERT_TRUE( confirmed );
+  TEST_ASSERT_EQUAL( 1, script.calls );
+
+  _script( late_ack, 3 );
+  TEST_ASSERT_EQUAL( T_WIFI_TYPE_CLIENT, roleDetectProbe( _scripted_probe, &confirmed ) );
+  TEST_ASSERT_TRUE( confirmed );
+  TEST_ASSERT_EQUAL( 3, script.calls );
+}
+
+TEST_CASE( "Role probe confirms controller only on NACK from every attempt", "[role_detect]" )
+{
+  esp_err_t results[ROLE_PROBE_ATTEMPTS];
+  bool confirmed = false;
+
+  for ( int i = 0; i < ROLE_PROBE_ATTEMPTS; i++ )
+  {
+    results[i] = ESP_FAIL;
+  }
+
+  _script( results, ROLE_PROBE_ATTEMPTS );
+  TEST_ASSERT_EQUAL( T_WIFI_TYPE_SERVER, roleDetectProbe( _scripted_probe, &confirmed ) );
+  TEST_ASSERT_TRUE( confirmed );
+  TEST_ASSERT_EQUAL( ROLE_PROBE_ATTEMPTS, script.calls );
+
+  /* A slow display timing out once must not be taken for a missing one */
+  results[ROLE_PROBE_ATTEMPTS - 1] = ESP_ERR_TIMEOUT;
+  _script( results, ROLE_PROBE_ATTEMPTS );
+  TEST_ASSERT_EQUAL( T_WIFI_TYPE_SERVER, roleDetectProbe( _scripted_probe, &confirmed ) );
+  TEST_ASSERT_FALSE( confirmed );
+}
+
+TEST_CASE( "Role hint is stored only for confirmed change", "[role_detect]" )
+{
+  TEST_ASSERT_TRUE( roleDetectStoreHint( false, 0, T_WIFI_TYPE_CLIENT, true ) );
+  TEST_ASSERT_TRUE( roleDetectStoreHint( true, T_WIFI_TYPE_CLIENT, T_WIFI_TYPE_SERVER, true ) );
+  TEST_ASSERT_FALSE( roleDetectStoreHint( true, T_WIFI_TYPE_CLIENT, T_WIFI_TYPE_CLIENT, true ) );
+  TEST_ASSERT_FALSE( roleDetectStoreHint( false, 0, T_WIFI_TYPE_SERVER, false ) );
+}
+
+TEST_CASE( "Role verify restarts only on confirmed mismatch", "[role_detect]" )
+{
+  TEST_ASSERT_TRUE( roleDetectRestart( T_WIFI_TYPE_SERVER, T_WIFI_TYPE_CLIENT, true ) );
+  TEST_ASSERT_FALSE( roleDetectRestart( T_WIFI_TYPE_SERVER, T_WIFI_TYPE_SERVER, true ) );
+  TEST_ASSERT_FALSE( roleDetectRestart( T_WIFI_TYPE_SERVER, T_WIFI_TYPE_CLIENT, false ) );
+}
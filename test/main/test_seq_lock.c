@@ -0,0 +1,141 @@
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+#include "seq_lock.h"
+#include "unity.h"
+
+#define WRITERS        2
+#define WRITES         100000
+#define READ_RETRIES   8
+
+/* Stand-in for parameter store, writer keeps b == ~a, each store alone is atomic */
+typedef struct
+{
+  seq_lock_t seq;
+  _Atomic uint32_t a;
+  _Atomic uint32_t b;
+  _Atomic uint32_t writers_left;
+  SemaphoreHandle_t done;
+} seq_test_ctx_t;
+
+static seq_test_ctx_t ctx;
+
+static void _writer_task( void* arg )
+{
+  uint32_t base = (uint32_t) (uintptr_t) arg;
+
+  for ( uint32_t i = 0; i < WRITES; i++ )
+  {
+    uint32_t value = base + i;
+
+    seqLockWriteBegin( &ctx.seq );
+    atomic_store_explicit( &ctx.a, value, memory_order_relaxed );
+    /* Widen the window where a pair is half written */
+    if ( ( i & 0xFF ) == 0 )
+    {
+      taskYIELD();
+    }
+    atomic_store_explicit( &ctx.b, ~value, memory_order_relaxed );
+    seqLockWriteEnd( &ctx.seq );
+
+    /* Idle gap lets reader through between bursts */
+    if ( ( i & 0x3FF ) == 0x3FF )
+    {
+      vTaskDelay( 1 );
+    }
+  }
+
+  if ( atomic_fetch_sub( &ctx.writers_left, 1 ) == 1 )
+  {
+    xSemaphoreGive( ctx.done );
+  }
+
+  vTaskDelete( NULL );
+}
+
+static bool _read_pair( uint32_t* a, uint32_t* b )
+{
+  for ( int retry = 0; retry < READ_RETRIES; retry++ )
+  {
+    uint32_t start;
+
+    if ( !seqLockReadBegin( &ctx.seq, &start ) )
+    {
+      continue;
+    }
+
+    *a = atomic_load_explicit( &ctx.a, memory_order_relaxed );
+    *b = atomic_load_explicit( &ctx.b, memory_order_relaxed );
+
+    if ( seqLockReadValid( &ctx.seq, start ) )
+    {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+TEST_CASE( "Sequence lock reader sees idle state", "[seq_lock]" )
+{
+  seq_lock_t seq = { 0 };
+  uint32_t start;
+
+  TEST_ASSERT_TRUE( seqLockReadBegin( &seq, &start ) );
+  TEST_ASSERT_TRUE( seqLockReadValid( &seq, start ) );
+
+  seqLockWriteBegin( &seq );
+  TEST_ASSERT_FALSE( seqLockReadBegin( &seq, &start ) );
+
+  /* Second writer overlapping the first keeps readers out until both end */
+  seqLockWriteBegin( &seq );
+  seqLockWriteEnd( &seq );
+  TEST_ASSERT_FALSE( seqLockReadBegin( &seq, &start ) );
+  seqLockWriteEnd( &seq );
+  TEST_ASSERT_TRUE( seqLockReadBegin( &seq, &start ) );
+
+  /* Write completed during read invalidates it */
+  seqLockWriteBegin( &seq );
+  seqLockWriteEnd( &seq );
+  TEST_ASSERT_FALSE( seqLockReadValid( &seq, start ) );
+}
+
+TEST_CASE( "Sequence lock readers never see torn pair under writer stress", "[seq_lock]" )
+{
+  uint32_t reads = 0;
+  uint32_t torn = 0;
+
+  atomic_store( &ctx.seq.begin, 0 );
+  atomic_store( &ctx.seq.end, 0 );
+  atomic_store( &ctx.a, 0 );
+  atomic_store( &ctx.b, ~0u );
+  atomic_store( &ctx.writers_left, WRITERS );
+  ctx.done = xSemaphoreCreateBinary();
+  TEST_ASSERT_NOT_NULL( ctx.done );
+
+  /* Writers on both cores, at reader priority so all three interleave */
+  for ( uintptr_t i = 0; i < WRITERS; i++ )
+  {
+    TEST_ASSERT_EQUAL( pdPASS, xTaskCreatePinnedToCore( _writer_task, "seq_writer", 2048, (void*) ( i << 24 ), uxTaskPriorityGet( NULL ), NULL,
+                                                        i % portNUM_PROCESSORS ) );
+  }
+
+  while ( xSemaphoreTake( ctx.done, 0 ) != pdTRUE )
+  {
+    uint32_t a;
+    uint32_t b;
+
+    if ( _read_pair( &a, &b ) )
+    {
+      reads++;
+      torn += b != ~a;
+    }
+
+    taskYIELD();
+  }
+
+  vSemaphoreDelete( ctx.done );
+  TEST_ASSERT_EQUAL_UINT32( 0, torn );
+  TEST_ASSERT_GREATER_THAN( 0, reads );
+  TEST_ASSERT_EQUAL_UINT32( atomic_load( &ctx.seq.begin ), atomic_load( &ctx.seq.end ) );
+}
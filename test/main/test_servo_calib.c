@@ -0,0 +1,141 @@
+#include "servo_calib.h"
+#include "unity.h"
+
+#define FREE_MV   1000
+#define STALL_MV  ( FREE_MV + SERVO_CALIB_STALL_MV + 100 )
+#define CLOSE_END 40
+#define OPEN_END  60
+#define MAX_STEPS 1000
+#define MAX_MV    4000
+
+typedef struct
+{
+  uint8_t close_end;
+  uint8_t open_end;
+  int32_t drift_mv;
+  uint32_t step;
+} servo_sim_t;
+
+/* Sense voltage rises when servo is pushed into stop, drift moves free running level */
+static uint32_t _sense( const servo_sim_t* sim, const servo_calib_t* calib )
+{
+  uint32_t base = FREE_MV + sim->drift_mv * (int32_t) sim->step / 100;
+  bool stalled = calib->phase == SERVO_CALIB_CLOSE ? calib->regulation <= sim->close_end : calib->regulation >= sim->open_end;
+
+  return stalled ? base + STALL_MV - FREE_MV : base;
+}
+
+static servo_calib_phase_t _run( servo_calib_t* calib, servo_sim_t* sim )
+{
+  servoCalibStart( calib, MAX_MV );
+
+  for ( sim->step = 0; sim->step < MAX_STEPS; sim->step++ )
+  {
+    servo_calib_phase_t phase = servoCalibStep( calib, _sense( sim, calib ) );
+
+    if ( phase == SERVO_CALIB_DONE || phase == SERVO_CALIB_FAILED || phase == SERVO_CALIB_OVERCURRENT )
+    {
+      return phase;
+    }
+  }
+
+  return calib->phase;
+}
+
+TEST_CASE( "Stall current marks both endpoints with margin", "[servo_calib]" )
+{
+  servo_sim_t sim = { .close_end = CLOSE_END, .open_end = OPEN_END };
+  servo_calib_t calib;
+
+  TEST_ASSERT_EQUAL( SERVO_CALIB_DONE, _run( &calib, &sim ) );
+  TEST_ASSERT_EQUAL( CLOSE_END + SERVO_CALIB_MARGIN, calib.close_result );
+  TEST_ASSERT_EQUAL( OPEN_END - SERVO_CALIB_MARGIN, calib.open_result );
+}
+
+TEST_CASE( "Slow supply drift is not taken as stall", "[servo_calib]" )
+{
+  /* Sense rises by 5 mV per step, within one search well above stall threshold */
+  servo_sim_t sim = { .close_end = CLOSE_END, .open_end = OPEN_END, .drift_mv = 500 };
+  servo_calib_t calib;
+
+  TEST_ASSERT_EQUAL( SERVO_CALIB_DONE, _run( &calib, &sim ) );
+  TEST_ASSERT_EQUAL( CLOSE_END + SERVO_CALIB_MARGIN, calib.close_result );
+  TEST_ASSERT_EQUAL( OPEN_END - SERVO_CALIB_MARGIN, calib.open_result );
+}
+
+TEST_CASE( "Single current spike is not a stall", "[servo_calib]" )
+{
+  servo_calib_t calib;
+
+  servoCalibStart( &calib, MAX_MV );
+
+  while ( calib.baseline_cnt < SERVO_CALIB_BASELINE_CNT )
+  {
+    servoCalibStep( &calib, FREE_MV );
+  }
+
+  uint8_t regulation = calib.regulation;
+
+  for ( int i = 0; i < SERVO_CALIB_SETTLE; i++ )
+  {
+    servoCalibStep( &calib, FREE_MV );
+  }
+
+  servoCalibStep( &calib, STALL_MV );
+  TEST_ASSERT_EQUAL( SERVO_CALIB_CLOSE, calib.phase );
+  TEST_ASSERT_EQUAL( regulation, calib.regulation );
+
+  /* Free running sample after spike resets stall count and moves on */
+  servoCalibStep( &calib, FREE_MV );
+  TEST_ASSERT_EQUAL( SERVO_CALIB_CLOSE, calib.phase );
+  TEST_ASSERT_EQUAL( 0, calib.stall_cnt );
+  TEST_ASSERT_EQUAL( regulation - SERVO_CALIB_STEP, calib.regulation );
+}
+
+TEST_CASE( "Missing stop fails calibration", "[servo_calib]" )
+{
+  servo_calib_t calib;
+
+  /* Closing reaches 0 without stall */
+  servoCalibStart( &calib, MAX_MV );
+
+  for ( int i = 0; i < MAX_STEPS && calib.phase == SERVO_CALIB_CLOSE; i++ )
+  {
+    servoCalibStep( &calib, FREE_MV );
+  }
+
+  TEST_ASSERT_EQUAL( SERVO_CALIB_FAILED, calib.phase );
+  TEST_ASSERT_EQUAL( SERVO_CALIB_FAILED, servoCalibStep( &calib, STALL_MV ) );
+}
+
+TEST_CASE( "Sense over hard limit aborts when baseline follows stall", "[servo_calib]" )
+{
+  servo_calib_t calib;
+
+  /* Sense rises 50 mV per position, baseline tracks it and stall is never detected */
+  servoCalibStart( &calib, MAX_MV );
+
+  for ( int i = 0; i < MAX_STEPS && calib.phase == SERVO_CALIB_CLOSE; i++ )
+  {
+    servoCalibStep( &calib, MAX_MV - 1000 + ( SERVO_CALIB_START_CLOSE - calib.regulation ) * 25 );
+  }
+
+  TEST_ASSERT_EQUAL( SERVO_CALIB_OVERCURRENT, calib.phase );
+  TEST_ASSERT_EQUAL( 0, calib.stall_cnt );
+  TEST_ASSERT_GREATER_THAN( MAX_MV, MAX_MV - 1000 + ( SERVO_CALIB_START_CLOSE - calib.regulation ) * 25 );
+  TEST_ASSERT_EQUAL( SERVO_CALIB_OVERCURRENT, servoCalibStep( &calib, FREE_MV ) );
+}
+
+TEST_CASE( "Sense spike while servo settles is not over hard limit", "[servo_calib]" )
+{
+  servo_calib_t calib;
+
+  servoCalibStart( &calib, MAX_MV );
+
+  for ( int i = 0; i < SERVO_CALIB_START_SETTLE; i++ )
+  {
+    TEST_ASSERT_EQUAL( SERVO_CALIB_CLOSE, servoCalibStep( &calib, MAX_MV * 2 ) );
+  }
+
+  TEST_ASSERT_EQUAL( SERVO_CALIB_OVERCURRENT, servoCalibStep( &calib, MAX_MV + 1 ) );
+}
@@ -0,0 +1,103 @@
+#include "soc_estimator.h"
+#include "unity.h"
+
+/* 12 V accumulator table, 100 mOhm, rest below 500 mA */
+#define ACCUM_CAPACITY_MAH 100
+#define STEP_MS            1000
+
+static void _feed( soc_estimator_t* est, uint32_t voltage_mv, uint32_t current_ma, int steps )
+{
+  for ( int i = 0; i < steps; i++ )
+  {
+    socEstimatorUpdate( est, voltage_mv, current_ma, STEP_MS );
+  }
+}
+
+TEST_CASE( "OCV table is interpolated and clamped", "[soc_estimator]" )
+{
+  TEST_ASSERT_EQUAL( 1000, socOcvToPermille( &soc_config_panel, 4500 ) );
+  TEST_ASSERT_EQUAL( 1000, socOcvToPermille( &soc_config_panel, 4200 ) );
+  TEST_ASSERT_EQUAL( 500, socOcvToPermille( &soc_config_panel, 3820 ) );
+  TEST_ASSERT_EQUAL( 550, socOcvToPermille( &soc_config_panel, 3845 ) );
+  TEST_ASSERT_EQUAL( 0, socOcvToPermille( &soc_config_panel, 3200 ) );
+  TEST_ASSERT_EQUAL( 0, socOcvToPermille( &soc_config_panel, 2500 ) );
+}
+
+TEST_CASE( "First update takes state of charge from OCV", "[soc_estimator]" )
+{
+  soc_estimator_t est;
+
+  socEstimatorInit( &est, &soc_config_accum, ACCUM_CAPACITY_MAH );
+  TEST_ASSERT_FALSE( socEstimatorIsValid( &est ) );
+
+  socEstimatorUpdate( &est, 12100, 0, STEP_MS );
+  TEST_ASSERT_TRUE( socEstimatorIsValid( &est ) );
+  TEST_ASSERT_EQUAL( 50, socEstimatorGetSoc( &est ) );
+  TEST_ASSERT_EQUAL( SOC_TIME_LEFT_UNKNOWN, socEstimatorGetTimeLeftMin( &est ) );
+}
+
+TEST_CASE( "Voltage under load is compensated by internal resistance", "[soc_estimator]" )
+{
+  soc_estimator_t est;
+
+  /* 12000 mV at 1 A with 100 mOhm is 12100 mV open circuit */
+  socEstimatorInit( &est, &soc_config_accum, ACCUM_CAPACITY_MAH );
+  socEstimatorUpdate( &est, 12000, 1000, STEP_MS );
+  TEST_ASSERT_EQUAL( 50, socEstimatorGetSoc( &est ) );
+}
+
+TEST_CASE( "Coulomb counting follows load between OCV corrections", "[soc_estimator]" )
+{
+  soc_estimator_t est;
+
+  socEstimatorInit( &est, &soc_config_accum, ACCUM_CAPACITY_MAH );
+  socEstimatorUpdate( &est, 12730, 0, STEP_MS );
+  TEST_ASSERT_EQUAL( 100, socEstimatorGetSoc( &est ) );
+
+  /* 10 A for 18 s is 50 mAh, voltage keeps claiming full, load weight trusts counting */
+  _feed( &est, 12730 - 1000, 10000, 18 );
+  TEST_ASSERT_INT_WITHIN( 2, 50, socEstimatorGetSoc( &est ) );
+}
+
+TEST_CASE( "Rested voltage pulls drifted charge back to OCV", "[soc_estimator]" )
+{
+  soc_estimator_t est;
+
+  socEstimatorInit( &est, &soc_config_accum, ACCUM_CAPACITY_MAH );
+  socEstimatorUpdate( &est, 12730, 0, STEP_MS );
+
+  _feed( &est, 12100, 0, 400 );
+  TEST_ASSERT_INT_WITHIN( 2, 50, socEstimatorGetSoc( &est ) );
+}
+
+TEST_CASE( "Small changes stay within hysteresis", "[soc_estimator]" )
+{
+  soc_estimator_t est;
+
+  socEstimatorInit( &est, &soc_config_accum, ACCUM_CAPACITY_MAH );
+  socEstimatorUpdate( &est, 12100, 0, STEP_MS );
+
+  /* 1 mAh is 1 %, below 2 % hysteresis */
+  socEstimatorUpdate( &est, 12100 - 1000, 10000, 360 );
+  TEST_ASSERT_EQUAL( 50, socEstimatorGetSoc( &est ) );
+
+  socEstimatorUpdate( &est, 12100 - 1000, 10000, 720 );
+  TEST_ASSERT_EQUAL( 47, socEstimatorGetSoc( &est ) );
+}
+
+TEST_CASE( "Time left uses averaged load current", "[soc_estimator]" )
+{
+  soc_estimator_t est;
+
+  socEstimatorInit( &est, &soc_config_accum, ACCUM_CAPACITY_MAH );
+  socEstimatorUpdate( &est, 11600, 6000, STEP_MS );
+
+  /* 12200 mV open circuit is about 57 mAh, 6 A drains it in about 34 s */
+  TEST_ASSERT_EQUAL( 0, socEstimatorGetTimeLeftMin( &est ) );
+
+  soc_estimator_t big;
+
+  socEstimatorInit( &big, &soc_config_accum, 60000 );
+  socEstimatorUpdate( &big, 12730, 1000, STEP_MS );
+  TEST_ASSERT_EQUAL( 3600, socEstimatorGetTimeLeftMin( &big ) );
+}
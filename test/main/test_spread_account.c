@@ -0,0 +1,112 @@
+#include "app_config.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "param_access.h"
+#include "spread_account.h"
+#include "unity.h"
+
+#define MIN_TICKS ( MS2ST( 60 * 1000 ) )
+
+typedef struct
+{
+  TickType_t now;
+  uint32_t mass_kg;
+  uint32_t work_min;
+} spread_test_ctx_t;
+
+static spread_test_ctx_t ctx;
+
+static void _start( uint32_t calibration )
+{
+  PARAM_FLOW_CALIBRATION_set( calibration );
+  spreadAccountInit();
+  ctx.now = xTaskGetTickCount();
+  ctx.mass_kg = PARAM_MASS_TOTAL_get();
+  ctx.work_min = PARAM_WORK_TIME_get();
+  spreadAccountUpdateAt( ctx.now, false, 0, 0 );
+}
+
+/* Controller cycles of given length, alternating one tick shorter and longer */
+static void _run( bool working, uint8_t servo_open, uint8_t motor_duty, TickType_t ticks, TickType_t cycle )
+{
+  TickType_t done = 0;
+
+  for ( uint32_t n = 0; done < ticks; n++ )
+  {
+    TickType_t step = cycle > 1 ? cycle + ( n % 2 ? 1 : -1 ) : cycle;
+
+    step = step > ticks - done ? ticks - done : step;
+    done += step;
+    ctx.now += step;
+    spreadAccountUpdateAt( ctx.now, working, servo_open, motor_duty );
+  }
+}
+
+TEST_CASE( "Spread account integrates constant flow", "[spread_account]" )
+{
+  _start( 100 );
+
+  /* 50 % opening is 675 g/s at full disc speed */
+  TEST_ASSERT_EQUAL( 675000, spreadAccountFlowMgPerS( 50, 100 ) );
+  _run( true, 50, 100, 10 * MIN_TICKS, 10 );
+
+  TEST_ASSERT_EQUAL( 40500, PARAM_SESSION_MASS_get() );
+  TEST_ASSERT_EQUAL( 10, PARAM_SESSION_TIME_get() );
+  TEST_ASSERT_EQUAL( ctx.mass_kg + 405, PARAM_MASS_TOTAL_get() );
+  TEST_ASSERT_EQUAL( ctx.work_min + 10, PARAM_WORK_TIME_get() );
+}
+
+TEST_CASE( "Spread account integrates stepped duty and opening", "[spread_account]" )
+{
+  _start( 100 );
+
+  /* 150 g/s, 1330 g/s and 2000 g/s */
+  _run( true, 20, 100, 2 * MIN_TICKS, 5 );
+  _run( true, 80, 50, 3 * MIN_TICKS, 5 );
+  _run( true, 100, 100, 1 * MIN_TICKS, 5 );
+
+  /* 18 + 239.4 + 120 kg */
+  TEST_ASSERT_EQUAL( 37740, PARAM_SESSION_MASS_get() );
+  TEST_ASSERT_EQUAL( 6, PARAM_SESSION_TIME_get() );
+  TEST_ASSERT_EQUAL( ctx.mass_kg + 377, PARAM_MASS_TOTAL_get() );
+
+  /* Closed servo and stopped disc spread nothing but still count as work time */
+  _run( true, 0, 0, MIN_TICKS, 5 );
+  TEST_ASSERT_EQUAL( 37740, PARAM_SESSION_MASS_get() );
+  TEST_ASSERT_EQUAL( 7, PARAM_SESSION_TIME_get() );
+}
+
+TEST_CASE( "Spread account carries mass remainder between cycles", "[spread_account]" )
+{
+  _start( 33 );
+
+  /* 1320 mg/s is 13.2 mg per tick, dropping remainders would lose 1.5 % */
+  TEST_ASSERT_EQUAL( 1320, spreadAccountFlowMgPerS( 1, 1 ) );
+  _run( true, 1, 1, 10 * MIN_TICKS, 1 );
+
+  /* 792 g in 10 g units, 780 g without the carry */
+  TEST_ASSERT_EQUAL( 79, PARAM_SESSION_MASS_get() );
+  TEST_ASSERT_EQUAL( 10, PARAM_SESSION_TIME_get() );
+  TEST_ASSERT_EQUAL( ctx.work_min + 10, PARAM_WORK_TIME_get() );
+}
+
+TEST_CASE( "Spread account resets session and keeps totals", "[spread_account]" )
+{
+  _start( 100 );
+
+  _run( true, 100, 100, MIN_TICKS, 10 );
+  TEST_ASSERT_EQUAL( 12000, PARAM_SESSION_MASS_get() );
+
+  /* Session values stay shown while stopped, idle time is not counted */
+  _run( false, 100, 100, 5 * MIN_TICKS, 10 );
+  TEST_ASSERT_EQUAL( 12000, PARAM_SESSION_MASS_get() );
+  TEST_ASSERT_EQUAL( 1, PARAM_SESSION_TIME_get() );
+  TEST_ASSERT_EQUAL( ctx.mass_kg + 120, PARAM_MASS_TOTAL_get() );
+  TEST_ASSERT_EQUAL( ctx.work_min + 1, PARAM_WORK_TIME_get() );
+
+  _run( true, 50, 100, 2 * MIN_TICKS, 10 );
+  TEST_ASSERT_EQUAL( 8100, PARAM_SESSION_MASS_get() );
+  TEST_ASSERT_EQUAL( 2, PARAM_SESSION_TIME_get() );
+  TEST_ASSERT_EQUAL( ctx.mass_kg + 201, PARAM_MASS_TOTAL_get() );
+  TEST_ASSERT_EQUAL( ctx.work_min + 3, PARAM_WORK_TIME_get() );
+}
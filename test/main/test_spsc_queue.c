@@ -0,0 +1,131 @@
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+#include "spsc_queue.h"
+#include "unity.h"
+
+#define QUEUE_SIZE   32
+#define STRESS_ITEMS 300000
+
+typedef struct
+{
+  spsc_queue_t queue;
+  spsc_queue_item_t buffer[QUEUE_SIZE];
+  SemaphoreHandle_t done;
+  uint32_t errors;
+} spsc_test_ctx_t;
+
+static spsc_test_ctx_t ctx;
+
+static void _consumer_task( void* arg )
+{
+  spsc_queue_item_t item;
+
+  for ( uint32_t expected = 0; expected < STRESS_ITEMS; )
+  {
+    if ( !spscQueuePop( &ctx.queue, &item ) )
+    {
+      taskYIELD();
+      continue;
+    }
+
+    if ( item.key != expected || item.value != ~expected )
+    {
+      ctx.errors++;
+    }
+
+    expected++;
+  }
+
+  xSemaphoreGive( ctx.done );
+  vTaskDelete( NULL );
+}
+
+TEST_CASE( "SPSC queue size must be power of two", "[spsc_queue]" )
+{
+  TEST_ASSERT_FALSE( spscQueueInit( &ctx.queue, ctx.buffer, 24 ) );
+  TEST_ASSERT_FALSE( spscQueueInit( &ctx.queue, ctx.buffer, 0 ) );
+  TEST_ASSERT_FALSE( spscQueueInit( &ctx.queue, NULL, QUEUE_SIZE ) );
+  TEST_ASSERT_TRUE( spscQueueInit( &ctx.queue, ctx.buffer, QUEUE_SIZE ) );
+}
+
+TEST_CASE( "SPSC queue keeps order and reports full and empty", "[spsc_queue]" )
+{
+  spsc_queue_item_t item;
+
+  TEST_ASSERT_TRUE( spscQueueInit( &ctx.queue, ctx.buffer, QUEUE_SIZE ) );
+  TEST_ASSERT_FALSE( spscQueuePop( &ctx.queue, &item ) );
+
+  for ( uint32_t i = 0; i < QUEUE_SIZE; i++ )
+  {
+    TEST_ASSERT_TRUE( spscQueuePush( &ctx.queue, i, ~i ) );
+  }
+
+  TEST_ASSERT_FALSE( spscQueuePush( &ctx.queue, QUEUE_SIZE, 0 ) );
+  TEST_ASSERT_EQUAL_UINT32( QUEUE_SIZE, spscQueueCount( &ctx.queue ) );
+
+  for ( uint32_t i = 0; i < QUEUE_SIZE; i++ )
+  {
+    TEST_ASSERT_TRUE( spscQueuePop( &ctx.queue, &item ) );
+    TEST_ASSERT_EQUAL_UINT32( i, item.key );
+    TEST_ASSERT_EQUAL_UINT32( ~i, item.value );
+  }
+
+  TEST_ASSERT_FALSE( spscQueuePop( &ctx.queue, &item ) );
+  TEST_ASSERT_EQUAL_UINT32( 0, spscQueueCount( &ctx.queue ) );
+}
+
+TEST_CASE( "SPSC queue survives index wrap", "[spsc_queue]" )
+{
+  spsc_queue_item_t item;
+
+  /* Free running head and tail just below overflow */
+  TEST_ASSERT_TRUE( spscQueueInit( &ctx.queue, ctx.buffer, QUEUE_SIZE ) );
+  atomic_store( &ctx.queue.head, UINT32_MAX - 2 );
+  atomic_store( &ctx.queue.tail, UINT32_MAX - 2 );
+
+  for ( uint32_t i = 0; i < QUEUE_SIZE; i++ )
+  {
+    TEST_ASSERT_TRUE( spscQueuePush( &ctx.queue, i, ~i ) );
+  }
+
+  TEST_ASSERT_FALSE( spscQueuePush( &ctx.queue, QUEUE_SIZE, 0 ) );
+  TEST_ASSERT_EQUAL_UINT32( QUEUE_SIZE, spscQueueCount( &ctx.queue ) );
+
+  for ( uint32_t i = 0; i < QUEUE_SIZE; i++ )
+  {
+    TEST_ASSERT_TRUE( spscQueuePop( &ctx.queue, &item ) );
+    TEST_ASSERT_EQUAL_UINT32( i, item.key );
+  }
+
+  TEST_ASSERT_FALSE( spscQueuePop( &ctx.queue, &item ) );
+}
+
+TEST_CASE( "SPSC queue producer and consumer on separate cores", "[spsc_queue]" )
+{
+  TEST_ASSERT_TRUE( spscQueueInit( &ctx.queue, ctx.buffer, QUEUE_SIZE ) );
+  ctx.errors = 0;
+  ctx.done = xSemaphoreCreateBinary();
+  TEST_ASSERT_NOT_NULL( ctx.done );
+
+  /* Consumer on the other core, small queue keeps both sides hitting full and empty */
+  BaseType_t core = portNUM_PROCESSORS > 1 ? !xPortGetCoreID() : 0;
+
+  TEST_ASSERT_EQUAL( pdPASS, xTaskCreatePinnedToCore( _consumer_task, "spsc_consumer", 2048, NULL, uxTaskPriorityGet( NULL ), NULL, core ) );
+
+  for ( uint32_t i = 0; i < STRESS_ITEMS; )
+  {
+    if ( spscQueuePush( &ctx.queue, i, ~i ) )
+    {
+      i++;
+    }
+    else
+    {
+      taskYIELD();
+    }
+  }
+
+  xSemaphoreTake( ctx.done, portMAX_DELAY );
+  vSemaphoreDelete( ctx.done );
+  TEST_ASSERT_EQUAL_UINT32( 0, ctx.errors );
+}
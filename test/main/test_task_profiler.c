@@ -0,0 +1,36 @@
+#include "task_profiler.h"
+#include "unity.h"
+
+#define BUDGET 4096
+
+static task_profiler_entry_t _entry( uint32_t stack_size, uint32_t stack_free )
+{
+  return ( task_profiler_entry_t ) { .name = "task", .stack_size = stack_size, .stack_free = stack_free };
+}
+
+TEST_CASE( "Stack using less than half of budget is oversized", "[task_profiler]" )
+{
+  task_profiler_entry_t entry = _entry( BUDGET, BUDGET / 2 + 1 );
+
+  TEST_ASSERT_TRUE( taskProfilerStackIsOversized( &entry ) );
+
+  entry = _entry( BUDGET, BUDGET - 100 );
+  TEST_ASSERT_TRUE( taskProfilerStackIsOversized( &entry ) );
+}
+
+TEST_CASE( "Stack using half of budget or more is not oversized", "[task_profiler]" )
+{
+  task_profiler_entry_t entry = _entry( BUDGET, BUDGET / 2 );
+
+  TEST_ASSERT_FALSE( taskProfilerStackIsOversized( &entry ) );
+
+  entry = _entry( BUDGET, 200 );
+  TEST_ASSERT_FALSE( taskProfilerStackIsOversized( &entry ) );
+}
+
+TEST_CASE( "Task without budget is never oversized", "[task_profiler]" )
+{
+  task_profiler_entry_t entry = _entry( 0, BUDGET );
+
+  TEST_ASSERT_FALSE( taskProfilerStackIsOversized( &entry ) );
+}
@@ -0,0 +1,94 @@
+#include "dictionary.h"
+#include "text_cache.h"
+#include "unity.h"
+
+#define FONT_SMALL 0
+#define FONT_BIG   1
+
+static uint32_t hits;
+static uint32_t misses;
+
+static void _reset( void )
+{
+  TEST_ASSERT_TRUE( dictionary_set_language( MENU_LANGUAGE_ENGLISH ) );
+  textCacheInvalidate();
+  textCacheGetStats( &hits, &misses );
+}
+
+/* Hits and misses since last call */
+static void _assert_stats( uint32_t exp_hits, uint32_t exp_misses )
+{
+  uint32_t now_hits;
+  uint32_t now_misses;
+
+  textCacheGetStats( &now_hits, &now_misses );
+  TEST_ASSERT_EQUAL( exp_hits, now_hits - hits );
+  TEST_ASSERT_EQUAL( exp_misses, now_misses - misses );
+  hits = now_hits;
+  misses = now_misses;
+}
+
+TEST_CASE( "Text cache measures run once and hits after", "[text_cache]" )
+{
+  _reset();
+
+  const text_run_t* run = textCacheGet( DICT_WAIT_TO_START_WIFI, FONT_SMALL );
+  TEST_ASSERT_EQUAL_STRING( dictionary_get_string( DICT_WAIT_TO_START_WIFI ), run->text );
+  TEST_ASSERT_EQUAL( 2, run->lines );
+  TEST_ASSERT_EQUAL( 14, run->max_line_glyphs );
+  _assert_stats( 0, 1 );
+
+  TEST_ASSERT_EQUAL_PTR( run, textCacheGet( DICT_WAIT_TO_START_WIFI, FONT_SMALL ) );
+  _assert_stats( 1, 0 );
+
+  /* Same phrase in other font is other run */
+  TEST_ASSERT_NOT_EQUAL( run, textCacheGet( DICT_WAIT_TO_START_WIFI, FONT_BIG ) );
+  _assert_stats( 0, 1 );
+}
+
+TEST_CASE( "Text cache counts glyphs not bytes and drops runs on language change", "[text_cache]" )
+{
+  _reset();
+
+  TEST_ASSERT_EQUAL( 4, textCacheGet( DICT_INIT, FONT_SMALL )->max_line_glyphs );
+  _assert_stats( 0, 1 );
+
+  TEST_ASSERT_TRUE( dictionary_set_language( MENU_LANGUAGE_RUSSIAN ) );
+  const text_run_t* run = textCacheGet( DICT_INIT, FONT_SMALL );
+  _assert_stats( 0, 1 );
+  TEST_ASSERT_EQUAL( MENU_LANGUAGE_RUSSIAN, run->language );
+  TEST_ASSERT_EQUAL( 13, run->max_line_glyphs );
+
+  TEST_ASSERT_TRUE( dictionary_set_language( MENU_LANGUAGE_ENGLISH ) );
+}
+
+TEST_CASE( "Text cache evicts least recently used run", "[text_cache]" )
+{
+  _reset();
+
+  for ( int phrase = 0; phrase < TEXT_CACHE_SIZE; phrase++ )
+  {
+    textCacheGet( phrase, FONT_SMALL );
+  }
+  _assert_stats( 0, TEXT_CACHE_SIZE );
+
+  /* First run is used again, second becomes the oldest */
+  textCacheGet( 0, FONT_SMALL );
+  textCacheGet( TEXT_CACHE_SIZE, FONT_SMALL );
+  _assert_stats( 1, 1 );
+
+  textCacheGet( 0, FONT_SMALL );
+  textCacheGet( TEXT_CACHE_SIZE, FONT_SMALL );
+  _assert_stats( 2, 0 );
+  textCacheGet( 1, FONT_SMALL );
+  _assert_stats( 0, 1 );
+
+  /* Its place was taken from the next oldest */
+  for ( int phrase = 3; phrase < TEXT_CACHE_SIZE; phrase++ )
+  {
+    textCacheGet( phrase, FONT_SMALL );
+  }
+  _assert_stats( TEXT_CACHE_SIZE - 3, 0 );
+  textCacheGet( 2, FONT_SMALL );
+  _assert_stats( 0, 1 );
+}